@@ -0,0 +1,315 @@
+/*
+ * libpino - bench.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+#include "bench.h"
+#include "handler_blob.h"
+#include "handler_f64a.h"
+#include "handler_u32a.h"
+#include "util.h"
+
+#define BENCH_MIN_SIZE_DEFAULT 16
+#define BENCH_MAX_SIZE_DEFAULT (1024 * 1024 * 1024)
+#define BENCH_SIZE_STEP        4
+
+typedef enum {
+    FORMAT_CSV = 0,
+    FORMAT_JSON,
+} format_t;
+
+typedef struct {
+    pino_magic_safe_t magic;
+    bool (*reg)(void);
+    bool (*unreg)(void);
+    size_t min_size;
+    size_t max_size;
+    size_t elem_size;
+} bench_handler_t;
+
+typedef struct {
+    format_t format;
+    size_t min_size;
+    size_t max_size;
+    const char *handler;
+    size_t rows;
+} options_t;
+
+/* blob stands in for spl1, whose deliberate leak makes every free scan a growing allocation list */
+static bench_handler_t g_handlers[] = {
+    {"blob", PH_NAME_REG(blob), PH_NAME_UNREG(blob), 1, SIZE_MAX, 1},
+    {"u32a", PH_NAME_REG(u32a), PH_NAME_UNREG(u32a), sizeof(uint32_t) * 2, sizeof(uint32_t) * 2, sizeof(uint32_t)},
+    {"f64a", PH_NAME_REG(f64a), PH_NAME_UNREG(f64a), sizeof(double), UINT8_MAX * sizeof(double), sizeof(double)},
+};
+
+/* keeps the baseline copy from being optimized away */
+static volatile uint8_t g_sink;
+
+static void emit(options_t *options, const char *handler, const char *operation, size_t size, size_t iters,
+                 uint64_t ns)
+{
+    if (options->format == FORMAT_JSON) {
+        printf("%s\n    {\"handler\": \"%s\", \"operation\": \"%s\", \"size\": %zu, \"iterations\": %zu, \"ns\": %llu, "
+               "\"ops_per_sec\": %.1f, \"gb_per_sec\": %.3f}",
+               options->rows > 0 ? "," : "", handler, operation, size, iters, (unsigned long long)ns,
+               bench_ops_per_sec(iters, ns), bench_gbps(size, iters, ns));
+    } else {
+        printf("%s,%s,%zu,%zu,%llu,%.1f,%.3f\n", handler, operation, size, iters, (unsigned long long)ns,
+               bench_ops_per_sec(iters, ns), bench_gbps(size, iters, ns));
+    }
+
+    options->rows++;
+}
+
+static bool run_memcpy(options_t *options, size_t size)
+{
+    uint8_t *src, *dest;
+    size_t i, iters;
+    uint64_t start, ns;
+
+    src = (uint8_t *)malloc(size);
+    dest = (uint8_t *)malloc(size);
+    if (!src || !dest) {
+        free(src);
+        free(dest);
+        return false;
+    }
+
+    generate_fixed_data(src, size);
+    iters = bench_iters(size);
+
+    start = bench_now_ns();
+    for (i = 0; i < iters; i++) {
+        memcpy(dest, src, size);
+        g_sink ^= dest[i % size];
+    }
+    ns = bench_now_ns() - start;
+
+    emit(options, "memcpy", "memcpy", size, iters, ns);
+
+    free(src);
+    free(dest);
+
+    return true;
+}
+
+static bool run_handler(options_t *options, bench_handler_t *handler, size_t size)
+{
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    uint8_t *data, *serialized, *unpacked;
+    size_t i, iters, serialized_size;
+    uint64_t start, ns;
+    bool result = false;
+
+    data = (uint8_t *)malloc(size);
+    unpacked = (uint8_t *)malloc(size);
+    pino = NULL;
+    serialized = NULL;
+    if (!data || !unpacked) {
+        goto cleanup;
+    }
+
+    generate_fixed_data(data, size);
+
+    iters = bench_iters(size);
+
+    start = bench_now_ns();
+    for (i = 0; i < iters; i++) {
+        pino = pino_pack(handler->magic, data, size);
+        if (!pino) {
+            goto cleanup;
+        }
+        if (i + 1 < iters) {
+            pino_destroy(pino);
+        }
+    }
+    ns = bench_now_ns() - start;
+    emit(options, handler->magic, "pack", size, iters, ns);
+
+    serialized_size = pino_serialize_size(pino);
+    serialized = (uint8_t *)malloc(serialized_size);
+    if (!serialized) {
+        goto cleanup;
+    }
+
+    start = bench_now_ns();
+    for (i = 0; i < iters; i++) {
+        if (!pino_serialize(pino, serialized)) {
+            goto cleanup;
+        }
+    }
+    ns = bench_now_ns() - start;
+    emit(options, handler->magic, "serialize", size, iters, ns);
+
+    start = bench_now_ns();
+    for (i = 0; i < iters; i++) {
+        if (!pino_peek(serialized, serialized_size, &info)) {
+            goto cleanup;
+        }
+    }
+    ns = bench_now_ns() - start;
+    emit(options, handler->magic, "peek", size, iters, ns);
+
+    start = bench_now_ns();
+    for (i = 0; i < iters; i++) {
+        restored = pino_unserialize(serialized, serialized_size);
+        if (!restored) {
+            goto cleanup;
+        }
+        pino_destroy(restored);
+    }
+    ns = bench_now_ns() - start;
+    emit(options, handler->magic, "unserialize", size, iters, ns);
+
+    start = bench_now_ns();
+    for (i = 0; i < iters; i++) {
+        if (!pino_unpack(pino, unpacked)) {
+            goto cleanup;
+        }
+    }
+    ns = bench_now_ns() - start;
+    emit(options, handler->magic, "unpack", size, iters, ns);
+
+    result = memcmp(data, unpacked, size) == 0;
+
+cleanup:
+    if (pino) {
+        pino_destroy(pino);
+    }
+    free(serialized);
+    free(unpacked);
+    free(data);
+
+    return result;
+}
+
+/* the sweep clamped to what the handler accepts, duplicates are skipped */
+static size_t handler_size(bench_handler_t *handler, size_t size)
+{
+    if (size < handler->min_size) {
+        size = handler->min_size;
+    }
+    if (size > handler->max_size) {
+        size = handler->max_size;
+    }
+
+    return size - size % handler->elem_size;
+}
+
+static bool parse_options(int argc, char **argv, options_t *options)
+{
+    int i;
+
+    options->format = FORMAT_CSV;
+    options->min_size = BENCH_MIN_SIZE_DEFAULT;
+    options->max_size = BENCH_MAX_SIZE_DEFAULT;
+    options->handler = NULL;
+    options->rows = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format=csv") == 0) {
+            options->format = FORMAT_CSV;
+        } else if (strcmp(argv[i], "--format=json") == 0) {
+            options->format = FORMAT_JSON;
+        } else if (strncmp(argv[i], "--min-size=", 11) == 0) {
+            if (!bench_parse_size(argv[i] + 11, &options->min_size)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--max-size=", 11) == 0) {
+            if (!bench_parse_size(argv[i] + 11, &options->max_size)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--handler=", 10) == 0) {
+            options->handler = argv[i] + 10;
+        } else {
+            return false;
+        }
+    }
+
+    return options->min_size <= options->max_size;
+}
+
+int main(int argc, char **argv)
+{
+    options_t options;
+    size_t size, last, i;
+    bool result = true;
+
+    if (!parse_options(argc, argv, &options)) {
+        fprintf(stderr,
+                "usage: %s [--format=csv|json] [--min-size=N[K|M|G]] [--max-size=N[K|M|G]] [--handler=NAME]\n",
+                argv[0]);
+        return 2;
+    }
+
+    if (!pino_init()) {
+        return 1;
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf("{\n  \"version_id\": %u,\n  \"results\": [", (unsigned)pino_version_id());
+    } else {
+        printf("handler,operation,size,iterations,ns,ops_per_sec,gb_per_sec\n");
+    }
+
+    if (!options.handler || strcmp(options.handler, "memcpy") == 0) {
+        for (size = options.min_size; size <= options.max_size; size *= BENCH_SIZE_STEP) {
+            if (!run_memcpy(&options, size)) {
+                fprintf(stderr, "memcpy: %zu bytes could not be allocated, stopping\n", size);
+                break;
+            }
+            if (size > options.max_size / BENCH_SIZE_STEP) {
+                break;
+            }
+        }
+    }
+
+    for (i = 0; i < sizeof(g_handlers) / sizeof(g_handlers[0]); i++) {
+        if (options.handler && strcmp(options.handler, g_handlers[i].magic) != 0) {
+            continue;
+        }
+
+        if (!g_handlers[i].reg()) {
+            result = false;
+            continue;
+        }
+
+        last = 0;
+        for (size = options.min_size; size <= options.max_size; size *= BENCH_SIZE_STEP) {
+            if (handler_size(&g_handlers[i], size) != last) {
+                last = handler_size(&g_handlers[i], size);
+                if (!run_handler(&options, &g_handlers[i], last)) {
+                    fprintf(stderr, "%s: %zu bytes failed, stopping\n", g_handlers[i].magic, last);
+                    break;
+                }
+            }
+            if (size > options.max_size / BENCH_SIZE_STEP) {
+                break;
+            }
+        }
+
+        g_handlers[i].unreg();
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf("\n  ]\n}\n");
+    }
+
+    pino_free();
+
+    return result ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+/*
+ * libpino - bench.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_BENCH_BENCH_H
+#define PINO_BENCH_BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BENCH_HAS_CYCLES 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLES 1
+#else
+#define BENCH_HAS_CYCLES 0
+#endif
+
+#define BENCH_TARGET_BYTES (64 * 1024 * 1024)
+#define BENCH_MIN_ITERS    16
+
+static inline uint64_t bench_now_ns(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+/* time stamp counter, reference cycles rather than core cycles. 0 where there is none */
+static inline uint64_t bench_cycles(void)
+{
+#if BENCH_HAS_CYCLES
+    return (uint64_t)__rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static inline size_t bench_iters(size_t size)
+{
+    size_t iters;
+
+    iters = size > 0 ? BENCH_TARGET_BYTES / size : BENCH_TARGET_BYTES;
+
+    return iters < BENCH_MIN_ITERS ? BENCH_MIN_ITERS : iters;
+}
+
+static inline double bench_mbps(size_t bytes, size_t iters, uint64_t ns)
+{
+    if (ns == 0) {
+        return 0.0;
+    }
+
+    return (double)bytes * (double)iters / ((double)ns / 1e9) / (1024.0 * 1024.0);
+}
+
+static inline double bench_ops_per_sec(size_t iters, uint64_t ns)
+{
+    if (ns == 0) {
+        return 0.0;
+    }
+
+    return (double)iters / ((double)ns / 1e9);
+}
+
+/* decimal GB, bytes per nanosecond */
+static inline double bench_gbps(size_t bytes, size_t iters, uint64_t ns)
+{
+    if (ns == 0) {
+        return 0.0;
+    }
+
+    return (double)bytes * (double)iters / (double)ns;
+}
+
+/* N with an optional K, M or G binary suffix */
+static inline bool bench_parse_size(const char *str, size_t *size)
+{
+    char *end;
+    unsigned long long value;
+
+    value = strtoull(str, &end, 10);
+    switch (*end) {
+    case 'K':
+    case 'k':
+        value *= 1024;
+        end++;
+        break;
+    case 'M':
+    case 'm':
+        value *= 1024 * 1024;
+        end++;
+        break;
+    case 'G':
+    case 'g':
+        value *= 1024 * 1024 * 1024;
+        end++;
+        break;
+    default:
+        break;
+    }
+
+    if (end == str || *end != '\0' || value == 0 || value > SIZE_MAX) {
+        return false;
+    }
+
+    *size = (size_t)value;
+
+    return true;
+}
+
+#endif /* PINO_BENCH_BENCH_H */
@@ -0,0 +1,212 @@
+/*
+ * libpino - bench_bswap.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "internal/bswap.h"
+#include "util.h"
+
+#define BENCH_MIN_SIZE_DEFAULT (4 * 1024)
+#define BENCH_MAX_SIZE_DEFAULT (64 * 1024 * 1024)
+#define BENCH_SIZE_STEP        4
+#define BENCH_OFFSET_MAX       8
+#define BENCH_BUFFER_ALIGNMENT 64
+#define BENCH_KERNEL_BYTES     (16 * 1024 * 1024)
+#define BENCH_KERNEL_MIN_ITERS 2
+
+typedef enum {
+    FORMAT_CSV = 0,
+    FORMAT_JSON,
+} format_t;
+
+typedef struct {
+    format_t format;
+    size_t min_size;
+    size_t max_size;
+    double ghz;
+    size_t rows;
+} options_t;
+
+/* odd sizes never reach a vector path and show the cost of the byte loop */
+static const size_t g_elem_sizes[] = {1, 2, 3, 4, 5, 7, 8, 16};
+
+static inline uint8_t *align_up(uint8_t *p)
+{
+    return (uint8_t *)(((uintptr_t)p + BENCH_BUFFER_ALIGNMENT - 1) & ~(uintptr_t)(BENCH_BUFFER_ALIGNMENT - 1));
+}
+
+static void emit(options_t *options, const char *kernel, size_t elem_size, size_t offset, size_t size, size_t iters,
+                 uint64_t ns, uint64_t cycles)
+{
+    double bytes, cpb;
+
+    bytes = (double)size * (double)iters;
+    cpb = options->ghz > 0.0 ? (double)ns * options->ghz / bytes : (double)cycles / bytes;
+
+    if (options->format == FORMAT_JSON) {
+        printf("%s\n    {\"kernel\": \"%s\", \"elem_size\": %zu, \"offset\": %zu, \"size\": %zu, \"iterations\": %zu, "
+               "\"ns\": %llu, \"ns_per_byte\": %.4f, \"cycles_per_byte\": %.4f, \"gb_per_sec\": %.3f}",
+               options->rows > 0 ? "," : "", kernel, elem_size, offset, size, iters, (unsigned long long)ns,
+               (double)ns / bytes, cpb, bench_gbps(size, iters, ns));
+    } else {
+        printf("%s,%zu,%zu,%zu,%zu,%llu,%.4f,%.4f,%.3f\n", kernel, elem_size, offset, size, iters,
+               (unsigned long long)ns, (double)ns / bytes, cpb, bench_gbps(size, iters, ns));
+    }
+
+    options->rows++;
+}
+
+static bool run(options_t *options, const pino_bswap_kernels_t *kernel, uint8_t *src, uint8_t *dest, uint8_t *expected,
+                size_t elem_size, size_t offset, size_t size)
+{
+    size_t i, iters;
+    uint64_t start_ns, start_cycles, ns, cycles;
+
+    /* warm up and check against the portable branch in the same pass */
+    kernel->copy(dest + offset, src + offset, size, elem_size);
+    if (memcmp(dest + offset, expected, size) != 0) {
+        fprintf(stderr, "%s: elem_size %zu, offset %zu, size %zu produced a wrong result\n",
+                pino_endianness_kernel_name(kernel->kernel), elem_size, offset, size);
+        return false;
+    }
+
+    /* the matrix is large, so each cell gets a smaller share than bench_iters() would give it */
+    iters = BENCH_KERNEL_BYTES / size;
+    if (iters < BENCH_KERNEL_MIN_ITERS) {
+        iters = BENCH_KERNEL_MIN_ITERS;
+    }
+
+    start_ns = bench_now_ns();
+    start_cycles = bench_cycles();
+    for (i = 0; i < iters; i++) {
+        kernel->copy(dest + offset, src + offset, size, elem_size);
+    }
+    cycles = bench_cycles() - start_cycles;
+    ns = bench_now_ns() - start_ns;
+
+    emit(options, pino_endianness_kernel_name(kernel->kernel), elem_size, offset, size, iters, ns, cycles);
+
+    return true;
+}
+
+static bool parse_options(int argc, char **argv, options_t *options)
+{
+    int i;
+    char *end;
+
+    options->format = FORMAT_CSV;
+    options->min_size = BENCH_MIN_SIZE_DEFAULT;
+    options->max_size = BENCH_MAX_SIZE_DEFAULT;
+    options->ghz = 0.0;
+    options->rows = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format=csv") == 0) {
+            options->format = FORMAT_CSV;
+        } else if (strcmp(argv[i], "--format=json") == 0) {
+            options->format = FORMAT_JSON;
+        } else if (strncmp(argv[i], "--min-size=", 11) == 0) {
+            if (!bench_parse_size(argv[i] + 11, &options->min_size)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--max-size=", 11) == 0) {
+            if (!bench_parse_size(argv[i] + 11, &options->max_size)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--ghz=", 6) == 0) {
+            options->ghz = strtod(argv[i] + 6, &end);
+            if (end == argv[i] + 6 || *end != '\0' || options->ghz <= 0.0) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return options->min_size <= options->max_size;
+}
+
+int main(int argc, char **argv)
+{
+    options_t options;
+    const pino_bswap_kernels_t *kernel;
+    uint8_t *src_block, *dest_block, *expected, *src, *dest;
+    size_t size, elem_size, buffer_size, e, k, offset;
+    bool result = true;
+
+    if (!parse_options(argc, argv, &options)) {
+        fprintf(stderr, "usage: %s [--format=csv|json] [--min-size=N[K|M|G]] [--max-size=N[K|M|G]] [--ghz=F]\n",
+                argv[0]);
+        return 2;
+    }
+
+    if (!BENCH_HAS_CYCLES && options.ghz <= 0.0) {
+        fprintf(stderr, "no cycle counter on this target, pass --ghz to derive cycles from time\n");
+    }
+
+    src_block = (uint8_t *)malloc(options.max_size + BENCH_OFFSET_MAX + BENCH_BUFFER_ALIGNMENT);
+    dest_block = (uint8_t *)malloc(options.max_size + BENCH_OFFSET_MAX + BENCH_BUFFER_ALIGNMENT);
+    expected = (uint8_t *)malloc(options.max_size);
+    if (!src_block || !dest_block || !expected) {
+        fprintf(stderr, "%zu bytes could not be allocated\n", options.max_size);
+        free(src_block);
+        free(dest_block);
+        free(expected);
+        return 1;
+    }
+
+    src = align_up(src_block);
+    dest = align_up(dest_block);
+    generate_fixed_data(src, options.max_size + BENCH_OFFSET_MAX);
+
+    if (options.format == FORMAT_JSON) {
+        printf("{\n  \"results\": [");
+    } else {
+        printf("kernel,elem_size,offset,size,iterations,ns,ns_per_byte,cycles_per_byte,gb_per_sec\n");
+    }
+
+    for (size = options.min_size; size <= options.max_size && result; size *= BENCH_SIZE_STEP) {
+        for (e = 0; e < sizeof(g_elem_sizes) / sizeof(g_elem_sizes[0]) && result; e++) {
+            elem_size = g_elem_sizes[e];
+            buffer_size = size - size % elem_size;
+
+            /* src and dest share the offset, so the pair is either both aligned or both not */
+            for (offset = 0; offset < BENCH_OFFSET_MAX && result; offset++) {
+                pino_bswap_memcpy_scalar(expected, src + offset, buffer_size, elem_size);
+
+                /* every kernel built in that this CPU can run, whichever one pino_init() would pick */
+                for (k = 0; k < PINO_BSWAP_KERNEL_COUNT && result; k++) {
+                    kernel = pino_bswap_kernels_find((pino_bswap_kernel_t)k);
+                    if (kernel) {
+                        result = run(&options, kernel, src, dest, expected, elem_size, offset, buffer_size);
+                    }
+                }
+            }
+        }
+
+        if (size > options.max_size / BENCH_SIZE_STEP) {
+            break;
+        }
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf("\n  ]\n}\n");
+    }
+
+    free(src_block);
+    free(dest_block);
+    free(expected);
+
+    return result ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/*
+ * libpino - bench_compress.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+#include "bench.h"
+#include "handler_blob.h"
+#include "util.h"
+
+typedef void (*generator_t)(uint8_t *out, size_t size);
+
+static bool run(const char *data_name, generator_t generator, size_t size, bool compress)
+{
+    pino_t *pino, *restored;
+    uint8_t *data, *serialized;
+    size_t i, iters, serialized_size;
+    uint64_t start, serialize_ns, unserialize_ns;
+
+    data = (uint8_t *)malloc(size);
+    if (!data) {
+        return false;
+    }
+    generator(data, size);
+
+    if (!pino_handler_set_flags("blob", compress ? PINO_HANDLER_FLAG_COMPRESS : 0)) {
+        free(data);
+        return false;
+    }
+
+    pino = pino_pack("blob", data, size);
+    free(data);
+    if (!pino) {
+        return false;
+    }
+
+    serialized_size = pino_serialize_size(pino);
+    serialized = (uint8_t *)malloc(serialized_size);
+    if (!serialized) {
+        pino_destroy(pino);
+        return false;
+    }
+
+    iters = bench_iters(size);
+
+    /* touch every round so the payload is encoded again instead of served from the cache */
+    start = bench_now_ns();
+    for (i = 0; i < iters; i++) {
+        pino_touch(pino);
+        if (!pino_serialize(pino, serialized)) {
+            break;
+        }
+    }
+    serialize_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for (i = 0; i < iters; i++) {
+        restored = pino_unserialize(serialized, serialized_size);
+        if (!restored) {
+            break;
+        }
+        pino_destroy(restored);
+    }
+    unserialize_ns = bench_now_ns() - start;
+
+    printf("%s,%s,%zu,%zu,%.3f,%.1f,%.1f\n", compress ? "lz" : "raw", data_name, size, serialized_size,
+           (double)size / (double)serialized_size, bench_mbps(size, iters, serialize_ns),
+           bench_mbps(size, iters, unserialize_ns));
+
+    free(serialized);
+    pino_destroy(pino);
+
+    return true;
+}
+
+int main(void)
+{
+    size_t sizes[] = {64, 256, 1024, 4096, 65536, 1024 * 1024};
+    size_t i;
+    bool result = true;
+
+    if (!pino_init() || !PH_REG(blob)) {
+        return 1;
+    }
+
+    printf("mode,data,size,serialized_size,ratio,serialize_mbps,unserialize_mbps\n");
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        result &= run("telemetry", generate_compressible_data, sizes[i], false);
+        result &= run("telemetry", generate_compressible_data, sizes[i], true);
+        result &= run("random", generate_random_data, sizes[i], false);
+        result &= run("random", generate_random_data, sizes[i], true);
+    }
+
+    PH_UNREG(blob);
+    pino_free();
+
+    return result ? 0 : 1;
+}
@@ -0,0 +1,355 @@
+/*
+ * libpino - bench_concurrency.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+#include "bench.h"
+#include "handler_blob.h"
+#include "util.h"
+
+#if PINO_BENCH_THREADS
+
+#include <pthread.h>
+
+#define BENCH_THREADS_DEFAULT "1,2,4,8"
+#define BENCH_THREADS_MAX     256
+#define BENCH_ITERS_DEFAULT   20000
+#define BENCH_SIZE_DEFAULT    256
+
+typedef enum {
+    FORMAT_CSV = 0,
+    FORMAT_JSON,
+} format_t;
+
+typedef struct {
+    format_t format;
+    size_t threads[BENCH_THREADS_MAX];
+    size_t thread_counts;
+    size_t iters;
+    size_t size;
+    size_t rows;
+} options_t;
+
+typedef struct {
+    pthread_t thread;
+    const uint8_t *data;
+    size_t size;
+    size_t iters;
+    uint64_t *latencies;
+    bool result;
+} worker_t;
+
+/*
+ * the handler registry, the handler contexts and the per handler memory manager are process wide and unlocked,
+ * so every call into the library is serialized here. the time spent waiting on this lock is the contention.
+ */
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_mutex_t g_start_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_start_cond = PTHREAD_COND_INITIALIZER;
+static bool g_started;
+
+static void wait_start(void)
+{
+    pthread_mutex_lock(&g_start_lock);
+    while (!g_started) {
+        pthread_cond_wait(&g_start_cond, &g_start_lock);
+    }
+    pthread_mutex_unlock(&g_start_lock);
+}
+
+static void signal_start(bool started)
+{
+    pthread_mutex_lock(&g_start_lock);
+    g_started = started;
+    pthread_cond_broadcast(&g_start_cond);
+    pthread_mutex_unlock(&g_start_lock);
+}
+
+static bool round_trip(const uint8_t *data, size_t size, uint8_t *serialized, size_t serialized_capacity,
+                       uint8_t *unpacked)
+{
+    pino_t *pino, *restored;
+    size_t serialized_size;
+    bool result;
+
+    pthread_mutex_lock(&g_lock);
+    pino = pino_pack("blob", data, size);
+    pthread_mutex_unlock(&g_lock);
+    if (!pino) {
+        return false;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    serialized_size = pino_serialize_size(pino);
+    result = serialized_size <= serialized_capacity && pino_serialize(pino, serialized);
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_mutex_lock(&g_lock);
+    restored = result ? pino_unserialize(serialized, serialized_size) : NULL;
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_mutex_lock(&g_lock);
+    result = restored && pino_unpack(restored, unpacked);
+    pthread_mutex_unlock(&g_lock);
+
+    pthread_mutex_lock(&g_lock);
+    if (restored) {
+        pino_destroy(restored);
+    }
+    pino_destroy(pino);
+    pthread_mutex_unlock(&g_lock);
+
+    return result;
+}
+
+static void *worker_main(void *arg)
+{
+    worker_t *worker = (worker_t *)arg;
+    uint8_t *serialized, *unpacked;
+    size_t i, serialized_capacity;
+    uint64_t start;
+
+    /* the header, the extensions and the checksum trailer are all far below a page */
+    serialized_capacity = worker->size + 4096;
+    serialized = (uint8_t *)malloc(serialized_capacity);
+    unpacked = (uint8_t *)malloc(worker->size);
+
+    wait_start();
+
+    worker->result = serialized && unpacked;
+    for (i = 0; i < worker->iters && worker->result; i++) {
+        start = bench_now_ns();
+        worker->result = round_trip(worker->data, worker->size, serialized, serialized_capacity, unpacked);
+        worker->latencies[i] = bench_now_ns() - start;
+    }
+
+    if (worker->result) {
+        worker->result = memcmp(worker->data, unpacked, worker->size) == 0;
+    }
+
+    free(serialized);
+    free(unpacked);
+
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static uint64_t percentile(const uint64_t *sorted, size_t count, double p)
+{
+    size_t index;
+
+    index = (size_t)(p * (double)count);
+
+    return sorted[index < count ? index : count - 1];
+}
+
+static void emit(options_t *options, size_t threads, size_t total, uint64_t ns, const uint64_t *sorted)
+{
+    double ops;
+
+    ops = bench_ops_per_sec(total, ns);
+
+    if (options->format == FORMAT_JSON) {
+        printf("%s\n    {\"threads\": %zu, \"iterations\": %zu, \"ns\": %llu, \"ops_per_sec\": %.1f, "
+               "\"ops_per_sec_per_thread\": %.1f, \"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, "
+               "\"max_ns\": %llu}",
+               options->rows > 0 ? "," : "", threads, total, (unsigned long long)ns, ops, ops / (double)threads,
+               (unsigned long long)percentile(sorted, total, 0.50), (unsigned long long)percentile(sorted, total, 0.99),
+               (unsigned long long)percentile(sorted, total, 0.999), (unsigned long long)sorted[total - 1]);
+    } else {
+        printf("%zu,%zu,%llu,%.1f,%.1f,%llu,%llu,%llu,%llu\n", threads, total, (unsigned long long)ns, ops,
+               ops / (double)threads, (unsigned long long)percentile(sorted, total, 0.50),
+               (unsigned long long)percentile(sorted, total, 0.99),
+               (unsigned long long)percentile(sorted, total, 0.999), (unsigned long long)sorted[total - 1]);
+    }
+
+    options->rows++;
+}
+
+static bool run(options_t *options, const uint8_t *data, size_t threads)
+{
+    worker_t *workers;
+    uint64_t *latencies, start, ns;
+    size_t i, started, total;
+    bool result = true;
+
+    total = threads * options->iters;
+    workers = (worker_t *)calloc(threads, sizeof(worker_t));
+    latencies = (uint64_t *)malloc(total * sizeof(uint64_t));
+    if (!workers || !latencies) {
+        free(workers);
+        free(latencies);
+        return false;
+    }
+
+    signal_start(false);
+
+    for (started = 0; started < threads; started++) {
+        workers[started].data = data;
+        workers[started].size = options->size;
+        workers[started].iters = options->iters;
+        workers[started].latencies = latencies + started * options->iters;
+        if (pthread_create(&workers[started].thread, NULL, worker_main, &workers[started]) != 0) {
+            result = false;
+            break;
+        }
+    }
+
+    start = bench_now_ns();
+    signal_start(true);
+
+    for (i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        result = result && workers[i].result;
+    }
+    ns = bench_now_ns() - start;
+
+    if (result) {
+        qsort(latencies, total, sizeof(uint64_t), compare_u64);
+        emit(options, threads, total, ns, latencies);
+    }
+
+    free(workers);
+    free(latencies);
+
+    return result;
+}
+
+static bool parse_threads(const char *str, options_t *options)
+{
+    char *end;
+    unsigned long value;
+
+    options->thread_counts = 0;
+    while (*str != '\0') {
+        value = strtoul(str, &end, 10);
+        if (end == str || value == 0 || value > BENCH_THREADS_MAX || options->thread_counts >= BENCH_THREADS_MAX) {
+            return false;
+        }
+        options->threads[options->thread_counts++] = (size_t)value;
+
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0') {
+            return false;
+        }
+        str = end;
+    }
+
+    return options->thread_counts > 0;
+}
+
+static bool parse_options(int argc, char **argv, options_t *options)
+{
+    int i;
+
+    options->format = FORMAT_CSV;
+    options->iters = BENCH_ITERS_DEFAULT;
+    options->size = BENCH_SIZE_DEFAULT;
+    options->rows = 0;
+    parse_threads(BENCH_THREADS_DEFAULT, options);
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format=csv") == 0) {
+            options->format = FORMAT_CSV;
+        } else if (strcmp(argv[i], "--format=json") == 0) {
+            options->format = FORMAT_JSON;
+        } else if (strncmp(argv[i], "--threads=", 10) == 0) {
+            if (!parse_threads(argv[i] + 10, options)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--iters=", 8) == 0) {
+            if (!bench_parse_size(argv[i] + 8, &options->iters)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--size=", 7) == 0) {
+            if (!bench_parse_size(argv[i] + 7, &options->size)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    options_t options;
+    uint8_t *data;
+    size_t i;
+    bool result = true;
+
+    if (!parse_options(argc, argv, &options)) {
+        fprintf(stderr, "usage: %s [--format=csv|json] [--threads=N[,N...]] [--iters=N] [--size=N[K|M|G]]\n",
+                argv[0]);
+        return 2;
+    }
+
+    data = (uint8_t *)malloc(options.size);
+    if (!data) {
+        return 1;
+    }
+    generate_fixed_data(data, options.size);
+
+    if (!pino_init() || !PH_REG(blob)) {
+        free(data);
+        return 1;
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf("{\n  \"version_id\": %u,\n  \"size\": %zu,\n  \"results\": [", (unsigned)pino_version_id(),
+               options.size);
+    } else {
+        printf("threads,iterations,ns,ops_per_sec,ops_per_sec_per_thread,p50_ns,p99_ns,p999_ns,max_ns\n");
+    }
+
+    for (i = 0; i < options.thread_counts && result; i++) {
+        result = run(&options, data, options.threads[i]);
+        if (!result) {
+            fprintf(stderr, "%zu threads: round trip failed\n", options.threads[i]);
+        }
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf("\n  ]\n}\n");
+    }
+
+    PH_UNREG(blob);
+    pino_free();
+    free(data);
+
+    return result ? 0 : 1;
+}
+
+#else
+
+int main(void)
+{
+    fprintf(stderr, "pino_bench_concurrency needs POSIX threads\n");
+
+    return 0;
+}
+
+#endif
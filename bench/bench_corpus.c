@@ -0,0 +1,453 @@
+/*
+ * libpino - bench_corpus.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/bundle.h>
+#include <pino/file.h>
+#include <pino/handler.h>
+
+#include "bench.h"
+#include "handler_blob.h"
+#include "handler_f64a.h"
+#include "handler_spl1.h"
+#include "handler_u32a.h"
+
+#if !defined(_WIN32)
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#define BENCH_ROUNDS_DEFAULT 10
+#define BENCH_PATH_MAX       4096
+
+typedef enum {
+    FORMAT_CSV = 0,
+    FORMAT_JSON,
+} format_t;
+
+typedef struct {
+    bool (*reg)(void);
+    bool (*unreg)(void);
+} corpus_handler_t;
+
+typedef struct {
+    pino_magic_safe_t magic;
+    const void *data;
+    size_t size;
+} sample_t;
+
+typedef struct {
+    format_t format;
+    size_t rounds;
+    size_t rows;
+} options_t;
+
+typedef struct {
+    pino_file_t **files;
+    size_t file_count;
+    size_t file_capacity;
+    sample_t *samples;
+    size_t count;
+    size_t capacity;
+    size_t skipped;
+} corpus_t;
+
+/*
+ * records are replayed through whatever is registered here, so captured data needs its handler added to this list.
+ * spl1 never frees its own struct, long spl1 replays slow down as its memory manager grows.
+ */
+static const corpus_handler_t g_handlers[] = {
+    {PH_NAME_REG(spl1), PH_NAME_UNREG(spl1)},
+    {PH_NAME_REG(u32a), PH_NAME_UNREG(u32a)},
+    {PH_NAME_REG(f64a), PH_NAME_UNREG(f64a)},
+    {PH_NAME_REG(blob), PH_NAME_UNREG(blob)},
+};
+
+static bool add_sample(corpus_t *corpus, const void *data, size_t size)
+{
+    pino_peek_info_t info;
+    sample_t *samples;
+    pino_t *pino;
+    size_t capacity;
+
+    if (!pino_peek(data, size, &info) || !info.registered) {
+        corpus->skipped++;
+        return true;
+    }
+
+    /* broken captures are dropped up front rather than failing the replay */
+    pino = pino_unserialize(data, size);
+    if (!pino) {
+        corpus->skipped++;
+        return true;
+    }
+    pino_destroy(pino);
+
+    if (corpus->count == corpus->capacity) {
+        capacity = corpus->capacity > 0 ? corpus->capacity * 2 : 64;
+        samples = (sample_t *)realloc(corpus->samples, capacity * sizeof(sample_t));
+        if (!samples) {
+            return false;
+        }
+        corpus->samples = samples;
+        corpus->capacity = capacity;
+    }
+
+    memcpy(corpus->samples[corpus->count].magic, info.magic, sizeof(pino_magic_safe_t));
+    corpus->samples[corpus->count].data = data;
+    corpus->samples[corpus->count].size = size;
+    corpus->count++;
+
+    return true;
+}
+
+/* a bundle contributes each of its records, any other file is taken as one serialized record */
+static bool add_file(corpus_t *corpus, const char *path)
+{
+    pino_file_t *file, **files;
+    pino_bundle_t *bundle;
+    const void *data;
+    size_t i, size, capacity;
+
+    file = pino_file_open(path);
+    if (!file) {
+        fprintf(stderr, "%s: could not be opened\n", path);
+        return false;
+    }
+
+    if (corpus->file_count == corpus->file_capacity) {
+        capacity = corpus->file_capacity > 0 ? corpus->file_capacity * 2 : 16;
+        files = (pino_file_t **)realloc(corpus->files, capacity * sizeof(pino_file_t *));
+        if (!files) {
+            pino_file_close(file);
+            return false;
+        }
+        corpus->files = files;
+        corpus->file_capacity = capacity;
+    }
+    corpus->files[corpus->file_count++] = file;
+
+    pino_file_advise(file, PINO_FILE_ADVICE_WILLNEED);
+
+    bundle = pino_file_bundle(file);
+    if (!bundle) {
+        return add_sample(corpus, pino_file_data(file), pino_file_size(file));
+    }
+
+    for (i = 0; i < pino_bundle_count(bundle); i++) {
+        if (!pino_bundle_record(bundle, i, &data, &size)) {
+            corpus->skipped++;
+            continue;
+        }
+        if (!add_sample(corpus, data, size)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool add_path(corpus_t *corpus, const char *path)
+{
+#if !defined(_WIN32)
+    struct stat st;
+    DIR *dir;
+    struct dirent *entry;
+    char child[BENCH_PATH_MAX];
+    bool result = true;
+
+    if (stat(path, &st) != 0) {
+        fprintf(stderr, "%s: not found\n", path);
+        return false;
+    }
+
+    if (!S_ISDIR(st.st_mode)) {
+        return add_file(corpus, path);
+    }
+
+    dir = opendir(path);
+    if (!dir) {
+        fprintf(stderr, "%s: could not be read\n", path);
+        return false;
+    }
+
+    while (result && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        if ((size_t)snprintf(child, sizeof(child), "%s/%s", path, entry->d_name) >= sizeof(child)) {
+            continue;
+        }
+        if (stat(child, &st) == 0 && S_ISREG(st.st_mode)) {
+            result = add_file(corpus, child);
+        }
+    }
+
+    closedir(dir);
+
+    return result;
+#else
+    return add_file(corpus, path);
+#endif
+}
+
+static void corpus_free(corpus_t *corpus)
+{
+    size_t i;
+
+    for (i = 0; i < corpus->file_count; i++) {
+        pino_file_close(corpus->files[i]);
+    }
+
+    free(corpus->files);
+    free(corpus->samples);
+}
+
+static int compare_sample(const void *a, const void *b)
+{
+    return strcmp(((const sample_t *)a)->magic, ((const sample_t *)b)->magic);
+}
+
+static void emit(options_t *options, const char *magic, const char *operation, size_t records, uint64_t bytes,
+                 uint64_t ns)
+{
+    double seconds;
+
+    seconds = (double)ns / 1e9;
+
+    if (options->format == FORMAT_JSON) {
+        printf("%s\n    {\"magic\": \"%s\", \"operation\": \"%s\", \"records\": %zu, \"bytes\": %llu, \"ns\": %llu, "
+               "\"records_per_sec\": %.1f, \"gb_per_sec\": %.3f}",
+               options->rows > 0 ? "," : "", magic, operation, records, (unsigned long long)bytes,
+               (unsigned long long)ns, ns > 0 ? (double)records / seconds : 0.0,
+               ns > 0 ? (double)bytes / (double)ns : 0.0);
+    } else {
+        printf("%s,%s,%zu,%llu,%llu,%.1f,%.3f\n", magic, operation, records, (unsigned long long)bytes,
+               (unsigned long long)ns, ns > 0 ? (double)records / seconds : 0.0,
+               ns > 0 ? (double)bytes / (double)ns : 0.0);
+    }
+
+    options->rows++;
+}
+
+/* every phase runs over the whole group before the next one starts, as a batch job over captured data would */
+static bool replay(options_t *options, sample_t *samples, size_t count)
+{
+    pino_t **restored, **repacked;
+    uint8_t **unpacked, *serialized;
+    size_t i, r, *unpacked_sizes, serialized_capacity, serialized_size;
+    uint64_t start, ns[4], bytes[4];
+    bool result = false;
+
+    restored = (pino_t **)calloc(count, sizeof(pino_t *));
+    repacked = (pino_t **)calloc(count, sizeof(pino_t *));
+    unpacked = (uint8_t **)calloc(count, sizeof(uint8_t *));
+    unpacked_sizes = (size_t *)calloc(count, sizeof(size_t));
+    serialized = NULL;
+    serialized_capacity = 0;
+    memset(ns, 0, sizeof(ns));
+    memset(bytes, 0, sizeof(bytes));
+
+    if (!restored || !repacked || !unpacked || !unpacked_sizes) {
+        goto cleanup;
+    }
+
+    for (r = 0; r < options->rounds; r++) {
+        start = bench_now_ns();
+        for (i = 0; i < count; i++) {
+            restored[i] = pino_unserialize(samples[i].data, samples[i].size);
+            if (!restored[i]) {
+                fprintf(stderr, "%s: record %zu could not be unserialized\n", samples[i].magic, i);
+                goto cleanup;
+            }
+        }
+        ns[0] += bench_now_ns() - start;
+
+        /* buffers are sized on the first round and reused after */
+        for (i = 0; i < count && r == 0; i++) {
+            unpacked_sizes[i] = pino_unpack_size(restored[i]);
+            unpacked[i] = (uint8_t *)malloc(unpacked_sizes[i] > 0 ? unpacked_sizes[i] : 1);
+            if (!unpacked[i]) {
+                goto cleanup;
+            }
+        }
+
+        start = bench_now_ns();
+        for (i = 0; i < count; i++) {
+            if (!pino_unpack(restored[i], unpacked[i])) {
+                goto cleanup;
+            }
+        }
+        ns[1] += bench_now_ns() - start;
+
+        start = bench_now_ns();
+        for (i = 0; i < count; i++) {
+            repacked[i] = pino_pack(samples[i].magic, unpacked[i], unpacked_sizes[i]);
+            if (!repacked[i]) {
+                fprintf(stderr, "%s: record %zu could not be repacked\n", samples[i].magic, i);
+                goto cleanup;
+            }
+        }
+        ns[2] += bench_now_ns() - start;
+
+        start = bench_now_ns();
+        for (i = 0; i < count; i++) {
+            serialized_size = pino_serialize_size(repacked[i]);
+            if (serialized_size > serialized_capacity) {
+                free(serialized);
+                serialized = (uint8_t *)malloc(serialized_size);
+                serialized_capacity = serialized ? serialized_size : 0;
+            }
+            if (!serialized || !pino_serialize(repacked[i], serialized)) {
+                goto cleanup;
+            }
+            if (r == 0) {
+                bytes[3] += serialized_size;
+            }
+        }
+        ns[3] += bench_now_ns() - start;
+
+        for (i = 0; i < count; i++) {
+            pino_destroy(restored[i]);
+            pino_destroy(repacked[i]);
+            restored[i] = NULL;
+            repacked[i] = NULL;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        bytes[0] += samples[i].size;
+        bytes[1] += unpacked_sizes[i];
+    }
+    bytes[2] = bytes[1];
+
+    emit(options, samples[0].magic, "unserialize", count * options->rounds, bytes[0] * options->rounds, ns[0]);
+    emit(options, samples[0].magic, "unpack", count * options->rounds, bytes[1] * options->rounds, ns[1]);
+    emit(options, samples[0].magic, "repack", count * options->rounds, bytes[2] * options->rounds, ns[2]);
+    emit(options, samples[0].magic, "serialize", count * options->rounds, bytes[3] * options->rounds, ns[3]);
+
+    result = true;
+
+cleanup:
+    for (i = 0; i < count && restored && repacked && unpacked; i++) {
+        if (restored[i]) {
+            pino_destroy(restored[i]);
+        }
+        if (repacked[i]) {
+            pino_destroy(repacked[i]);
+        }
+        free(unpacked[i]);
+    }
+
+    free(restored);
+    free(repacked);
+    free(unpacked);
+    free(unpacked_sizes);
+    free(serialized);
+
+    return result;
+}
+
+static bool parse_options(int argc, char **argv, options_t *options, int *first_path)
+{
+    int i;
+
+    options->format = FORMAT_CSV;
+    options->rounds = BENCH_ROUNDS_DEFAULT;
+    options->rows = 0;
+
+    for (i = 1; i < argc && strncmp(argv[i], "--", 2) == 0; i++) {
+        if (strcmp(argv[i], "--format=csv") == 0) {
+            options->format = FORMAT_CSV;
+        } else if (strcmp(argv[i], "--format=json") == 0) {
+            options->format = FORMAT_JSON;
+        } else if (strncmp(argv[i], "--rounds=", 9) == 0) {
+            if (!bench_parse_size(argv[i] + 9, &options->rounds)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    *first_path = i;
+
+    return i < argc;
+}
+
+int main(int argc, char **argv)
+{
+    options_t options;
+    corpus_t corpus;
+    size_t i, start;
+    int first_path, a;
+    bool result = true;
+
+    if (!parse_options(argc, argv, &options, &first_path)) {
+        fprintf(stderr, "usage: %s [--format=csv|json] [--rounds=N] PATH...\n", argv[0]);
+        return 2;
+    }
+
+    if (!pino_init()) {
+        return 1;
+    }
+
+    for (i = 0; i < sizeof(g_handlers) / sizeof(g_handlers[0]); i++) {
+        if (!g_handlers[i].reg()) {
+            return 1;
+        }
+    }
+
+    memset(&corpus, 0, sizeof(corpus));
+    for (a = first_path; a < argc && result; a++) {
+        result = add_path(&corpus, argv[a]);
+    }
+
+    if (corpus.skipped > 0) {
+        fprintf(stderr, "%zu records skipped: not a valid record or no handler registered for the magic\n",
+                corpus.skipped);
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf("{\n  \"version_id\": %u,\n  \"rounds\": %zu,\n  \"results\": [", (unsigned)pino_version_id(),
+               options.rounds);
+    } else {
+        printf("magic,operation,records,bytes,ns,records_per_sec,gb_per_sec\n");
+    }
+
+    if (result && corpus.count > 0) {
+        qsort(corpus.samples, corpus.count, sizeof(sample_t), compare_sample);
+
+        for (start = 0, i = 1; i <= corpus.count && result; i++) {
+            if (i == corpus.count || strcmp(corpus.samples[i].magic, corpus.samples[start].magic) != 0) {
+                result = replay(&options, corpus.samples + start, i - start);
+                start = i;
+            }
+        }
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf("\n  ]\n}\n");
+    }
+
+    corpus_free(&corpus);
+
+    for (i = 0; i < sizeof(g_handlers) / sizeof(g_handlers[0]); i++) {
+        g_handlers[i].unreg();
+    }
+    pino_free();
+
+    return result ? 0 : 1;
+}
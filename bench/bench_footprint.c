@@ -0,0 +1,282 @@
+/*
+ * libpino - bench_footprint.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+#include "bench.h"
+#include "handler_blob.h"
+#include "handler_f64a.h"
+#include "handler_u32a.h"
+#include "util.h"
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define BENCH_HAS_ALLOC_STATS 1
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#define BENCH_HAS_ALLOC_STATS 1
+#else
+#define BENCH_HAS_ALLOC_STATS 0
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#define BENCH_HAS_RSS 1
+#elif defined(__APPLE__)
+#define BENCH_HAS_RSS 1
+#else
+#define BENCH_HAS_RSS 0
+#endif
+
+#define BENCH_COUNT_DEFAULT  10000
+#define BENCH_BUDGET_DEFAULT 256
+
+typedef enum {
+    FORMAT_CSV = 0,
+    FORMAT_JSON,
+} format_t;
+
+typedef struct {
+    pino_magic_safe_t magic;
+    const char *shape;
+    size_t size;
+} footprint_case_t;
+
+typedef struct {
+    format_t format;
+    size_t count;
+    size_t budget;
+    size_t rows;
+} options_t;
+
+/* u32a keeps the payload inside the handler struct, f64a and blob hold it in a second block */
+static footprint_case_t g_cases[] = {
+    {"u32a", "inline", sizeof(uint32_t) * 2},
+    {"f64a", "external", sizeof(double)},
+    {"f64a", "external", 32 * sizeof(double)},
+    {"f64a", "external", UINT8_MAX * sizeof(double)},
+    {"blob", "external", 16},
+    {"blob", "external", 256},
+    {"blob", "external", 4096},
+};
+
+/* bytes handed out by the allocator and still live, 0 where the allocator does not tell */
+static size_t alloc_bytes(void)
+{
+#if defined(__GLIBC__) && BENCH_HAS_ALLOC_STATS
+    return mallinfo2().uordblks;
+#elif defined(__APPLE__)
+    malloc_statistics_t stats;
+
+    malloc_zone_statistics(NULL, &stats);
+
+    return stats.size_in_use;
+#else
+    return 0;
+#endif
+}
+
+static size_t rss_bytes(void)
+{
+#if defined(__linux__)
+    FILE *fp;
+    unsigned long size, resident;
+
+    fp = fopen("/proc/self/statm", "r");
+    if (!fp) {
+        return 0;
+    }
+
+    if (fscanf(fp, "%lu %lu", &size, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(fp);
+
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+
+    return (size_t)info.resident_size;
+#else
+    return 0;
+#endif
+}
+
+static inline double per_object(size_t before, size_t after, size_t count)
+{
+    return after > before ? (double)(after - before) / (double)count : 0.0;
+}
+
+static void emit(options_t *options, footprint_case_t *fc, double alloc, double rss, bool over)
+{
+    if (options->format == FORMAT_JSON) {
+        printf("%s\n    {\"handler\": \"%s\", \"shape\": \"%s\", \"size\": %zu, \"count\": %zu, "
+               "\"alloc_bytes_per_object\": %.1f, \"alloc_overhead\": %.1f, \"rss_bytes_per_object\": %.1f, "
+               "\"rss_overhead\": %.1f, \"budget\": %zu, \"status\": \"%s\"}",
+               options->rows > 0 ? "," : "", fc->magic, fc->shape, fc->size, options->count, alloc,
+               alloc - (double)fc->size, rss, rss - (double)fc->size, options->budget, over ? "over" : "ok");
+    } else {
+        printf("%s,%s,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%zu,%s\n", fc->magic, fc->shape, fc->size, options->count, alloc,
+               alloc - (double)fc->size, rss, rss - (double)fc->size, options->budget, over ? "over" : "ok");
+    }
+
+    options->rows++;
+}
+
+static bool run(options_t *options, footprint_case_t *fc, bool *over)
+{
+    pino_t **pinos;
+    uint8_t *data;
+    size_t i, alloc_before, alloc_after, rss_before, rss_after;
+    double alloc, rss, overhead;
+    bool result = true;
+
+    pinos = (pino_t **)calloc(options->count, sizeof(pino_t *));
+    data = (uint8_t *)malloc(fc->size);
+    if (!pinos || !data) {
+        free(pinos);
+        free(data);
+        return false;
+    }
+    generate_fixed_data(data, fc->size);
+
+    alloc_before = alloc_bytes();
+    rss_before = rss_bytes();
+
+    for (i = 0; i < options->count; i++) {
+        pinos[i] = pino_pack(fc->magic, data, fc->size);
+        if (!pinos[i]) {
+            result = false;
+            break;
+        }
+    }
+
+    alloc_after = alloc_bytes();
+    rss_after = rss_bytes();
+
+    if (result) {
+        alloc = per_object(alloc_before, alloc_after, options->count);
+        rss = per_object(rss_before, rss_after, options->count);
+
+        /* the allocator figure is exact, RSS only stands in where there is none */
+        overhead = (BENCH_HAS_ALLOC_STATS ? alloc : rss) - (double)fc->size;
+        *over = overhead > (double)options->budget;
+
+        emit(options, fc, alloc, rss, *over);
+    }
+
+    for (i = 0; i < options->count && pinos[i]; i++) {
+        pino_destroy(pinos[i]);
+    }
+
+    free(pinos);
+    free(data);
+
+    return result;
+}
+
+static bool parse_options(int argc, char **argv, options_t *options)
+{
+    int i;
+
+    options->format = FORMAT_CSV;
+    options->count = BENCH_COUNT_DEFAULT;
+    options->budget = BENCH_BUDGET_DEFAULT;
+    options->rows = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format=csv") == 0) {
+            options->format = FORMAT_CSV;
+        } else if (strcmp(argv[i], "--format=json") == 0) {
+            options->format = FORMAT_JSON;
+        } else if (strncmp(argv[i], "--count=", 8) == 0) {
+            if (!bench_parse_size(argv[i] + 8, &options->count)) {
+                return false;
+            }
+        } else if (strncmp(argv[i], "--budget=", 9) == 0) {
+            if (!bench_parse_size(argv[i] + 9, &options->budget)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    options_t options;
+    size_t i;
+    bool result = true, over, any_over = false;
+
+    if (!parse_options(argc, argv, &options)) {
+        fprintf(stderr, "usage: %s [--format=csv|json] [--count=N[K|M|G]] [--budget=N[K|M|G]]\n", argv[0]);
+        return 2;
+    }
+
+    if (!BENCH_HAS_ALLOC_STATS) {
+        fprintf(stderr, "allocator statistics are not available, the budget is checked against RSS\n");
+    }
+
+    if (!BENCH_HAS_ALLOC_STATS && !BENCH_HAS_RSS) {
+        fprintf(stderr, "no memory statistics on this target\n");
+        return 0;
+    }
+
+    if (!pino_init() || !PH_REG(u32a) || !PH_REG(f64a) || !PH_REG(blob)) {
+        return 1;
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf("{\n  \"version_id\": %u,\n  \"results\": [", (unsigned)pino_version_id());
+    } else {
+        printf("handler,shape,size,count,alloc_bytes_per_object,alloc_overhead,rss_bytes_per_object,rss_overhead,"
+               "budget,status\n");
+    }
+
+    for (i = 0; i < sizeof(g_cases) / sizeof(g_cases[0]) && result; i++) {
+        over = false;
+        result = run(&options, &g_cases[i], &over);
+        if (!result) {
+            fprintf(stderr, "%s: %zu objects of %zu bytes could not be packed\n", g_cases[i].magic, options.count,
+                    g_cases[i].size);
+        }
+        any_over = any_over || over;
+    }
+
+    if (options.format == FORMAT_JSON) {
+        printf("\n  ]\n}\n");
+    }
+
+    PH_UNREG(blob);
+    PH_UNREG(f64a);
+    PH_UNREG(u32a);
+    pino_free();
+
+    if (any_over) {
+        fprintf(stderr, "per object overhead exceeds the budget of %zu bytes\n", options.budget);
+    }
+
+    return result && !any_over ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/*
+ * libpino - handler_blob.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_BENCH_HANDLER_BLOB_H
+#define PINO_BENCH_HANDLER_BLOB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+/* variable sized byte payload, like spl1 but without the deliberate leak */
+
+PH_BEGIN(blob);
+
+PH_DEF_STATIC_FIELDS_STRUCT(blob)
+{
+    uint64_t size;
+}
+PH_DEF_STATIC_FIELDS_STRUCT_END;
+
+PH_DEF_STRUCT(blob)
+{
+    uint8_t *data;
+}
+PH_DEF_STRUCT_END;
+
+PH_DEFUN_SERIALIZE_SIZE(blob)
+{
+    uint64_t size;
+
+    PH_THIS_STATIC_GET(blob, size, &size);
+
+    return (size_t)size;
+}
+
+PH_DEFUN_SERIALIZE(blob)
+{
+    uint64_t size;
+
+    PH_THIS_STATIC_GET(blob, size, &size);
+    PH_SERIALIZE_DATA(blob, data, (size_t)size);
+
+    return true;
+}
+
+PH_DEFUN_UNSERIALIZE(blob)
+{
+    uint64_t size;
+
+    PH_THIS_STATIC_GET(blob, size, &size);
+    PH_UNSERIALIZE_DATA(blob, data, (size_t)size);
+
+    return true;
+}
+
+PH_DEFUN_PACK(blob)
+{
+    PH_PACK_DATA(blob, data, PH_ARG_SIZE);
+
+    return true;
+}
+
+PH_DEFUN_UNPACK_SIZE(blob)
+{
+    uint64_t size;
+
+    PH_THIS_STATIC_GET(blob, size, &size);
+
+    return (size_t)size;
+}
+
+PH_DEFUN_UNPACK(blob)
+{
+    uint64_t size;
+
+    PH_THIS_STATIC_GET(blob, size, &size);
+    PH_UNPACK_DATA(blob, data, (size_t)size);
+
+    return true;
+}
+
+PH_DEFUN_CREATE(blob)
+{
+    uint64_t size = (uint64_t)PH_ARG_SIZE;
+
+    PH_CREATE_THIS(blob);
+
+    PH_THIS(blob)->data = (uint8_t *)PH_MALLOC(blob, PH_ARG_SIZE > 0 ? PH_ARG_SIZE : 1);
+    if (!PH_THIS(blob)->data) {
+        PH_DESTROY_THIS(blob);
+        return NULL;
+    }
+
+    PH_THIS_STATIC_SET(blob, size, &size);
+
+    return PH_THIS(blob);
+}
+
+PH_DEFUN_DESTROY(blob)
+{
+    PH_FREE(blob, PH_THIS(blob)->data);
+    PH_DESTROY_THIS(blob);
+}
+
+PH_END(blob);
+
+#endif /* PINO_BENCH_HANDLER_BLOB_H */
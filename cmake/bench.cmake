@@ -0,0 +1,46 @@
+# libpino bench
+
+file(MAKE_DIRECTORY ${CMAKE_BINARY_DIR}/bench)
+
+file(GLOB BENCH_SOURCES "bench/bench*.c")
+
+foreach(BENCH_SOURCE ${BENCH_SOURCES})
+  get_filename_component(BENCH_NAME ${BENCH_SOURCE} NAME_WE)
+  set(BENCH_NAME "pino_${BENCH_NAME}")
+
+  add_executable(${BENCH_NAME} ${BENCH_SOURCE})
+
+  target_link_libraries(${BENCH_NAME} PRIVATE pino)
+
+  target_include_directories(${BENCH_NAME} PRIVATE ${CMAKE_SOURCE_DIR}/include ${CMAKE_SOURCE_DIR}/src ${CMAKE_SOURCE_DIR}/bench ${CMAKE_SOURCE_DIR}/tests)
+
+  set_target_properties(${BENCH_NAME} PROPERTIES
+    RUNTIME_OUTPUT_DIRECTORY ${CMAKE_BINARY_DIR}/bench
+  )
+endforeach()
+
+if(PINO_USE_SIMD)
+  if(EMSCRIPTEN)
+    set_source_files_properties(${CMAKE_SOURCE_DIR}/bench/bench_bswap.c PROPERTIES
+      COMPILE_OPTIONS "-msimd128"
+      COMPILE_DEFINITIONS "PINO_USE_SIMD=1;PINO_SIMD_WASM=1"
+    )
+  elseif(CMAKE_SYSTEM_PROCESSOR MATCHES "^(aarch64|arm64|ARM64)")
+    set_source_files_properties(${CMAKE_SOURCE_DIR}/bench/bench_bswap.c PROPERTIES
+      COMPILE_DEFINITIONS "PINO_USE_SIMD=1;PINO_SIMD_NEON=1"
+    )
+  elseif(CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|amd64)" AND CMAKE_SIZEOF_VOID_P EQUAL 8)
+    set_source_files_properties(${CMAKE_SOURCE_DIR}/bench/bench_bswap.c PROPERTIES
+      COMPILE_DEFINITIONS "PINO_USE_SIMD=1;PINO_SIMD_DISPATCH=1"
+    )
+  else()
+    set_source_files_properties(${CMAKE_SOURCE_DIR}/bench/bench_bswap.c PROPERTIES COMPILE_DEFINITIONS "PINO_USE_SIMD=0")
+  endif()
+else()
+  set_source_files_properties(${CMAKE_SOURCE_DIR}/bench/bench_bswap.c PROPERTIES COMPILE_DEFINITIONS "PINO_USE_SIMD=0")
+endif()
+
+if(Threads_FOUND AND CMAKE_USE_PTHREADS_INIT)
+  target_compile_definitions(pino_bench_concurrency PRIVATE PINO_BENCH_THREADS=1)
+  target_link_libraries(pino_bench_concurrency PRIVATE Threads::Threads)
+endif()
@@ -16,6 +16,23 @@ file(MAKE_DIRECTORY ${CMAKE_BINARY_DIR}/tests)
 
 set(PINO_TEST_LINK_LIBRARIES pino unity)
 
+# test_alloc asserts allocation counts, it links a counting copy of the library so the other tests stay uninstrumented
+if(PINO_USE_ALLOC_STATS)
+  set(PINO_TEST_ALLOC_LIBRARY pino)
+else()
+  add_library(pino-obj-alloc OBJECT ${SOURCES})
+  target_include_directories(pino-obj-alloc PUBLIC $<TARGET_PROPERTY:pino-obj,INCLUDE_DIRECTORIES>)
+  target_compile_definitions(pino-obj-alloc PRIVATE $<TARGET_PROPERTY:pino-obj,COMPILE_DEFINITIONS> PINO_ALLOC_STATS=1)
+  target_compile_options(pino-obj-alloc PRIVATE $<TARGET_PROPERTY:pino-obj,COMPILE_OPTIONS>)
+
+  add_library(pino-alloc STATIC $<TARGET_OBJECTS:pino-obj-alloc>)
+  if(Threads_FOUND AND CMAKE_USE_PTHREADS_INIT)
+    target_link_libraries(pino-alloc PUBLIC Threads::Threads)
+  endif()
+
+  set(PINO_TEST_ALLOC_LIBRARY pino-alloc)
+endif()
+
 if(PINO_ENABLE_COVERAGE)
   file(MAKE_DIRECTORY ${CMAKE_BINARY_DIR}/coverage)
   add_custom_target(coverage
@@ -39,7 +56,11 @@ foreach(TEST_SOURCE ${TEST_SOURCES})
 
   add_executable(${TEST_NAME} ${TEST_SOURCE})
 
-  target_link_libraries(${TEST_NAME} PRIVATE pino unity)
+  if(TEST_NAME STREQUAL "pino_test_alloc")
+    target_link_libraries(${TEST_NAME} PRIVATE ${PINO_TEST_ALLOC_LIBRARY} unity)
+  else()
+    target_link_libraries(${TEST_NAME} PRIVATE pino unity)
+  endif()
 
   target_include_directories(${TEST_NAME} PRIVATE ${unity_SOURCE_DIR}/src ${CMAKE_SOURCE_DIR}/include ${CMAKE_SOURCE_DIR}/src)
 
@@ -49,13 +70,8 @@ foreach(TEST_SOURCE ${TEST_SOURCES})
       target_compile_definitions(${TEST_NAME} PRIVATE PINO_USE_SIMD=1 PINO_SIMD_WASM=1)
     elseif(CMAKE_SYSTEM_PROCESSOR MATCHES "^(aarch64|arm64|ARM64)")
       target_compile_definitions(${TEST_NAME} PRIVATE PINO_USE_SIMD=1 PINO_SIMD_NEON=1)
-    elseif(CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|amd64)")
-      if(MSVC)
-        target_compile_options(${TEST_NAME} PRIVATE /arch:AVX2)
-      else()
-        target_compile_options(${TEST_NAME} PRIVATE -mavx2)
-      endif()
-      target_compile_definitions(${TEST_NAME} PRIVATE PINO_USE_SIMD=1 PINO_SIMD_AVX2=1)
+    elseif(CMAKE_SYSTEM_PROCESSOR MATCHES "^(x86_64|AMD64|amd64)" AND CMAKE_SIZEOF_VOID_P EQUAL 8)
+      target_compile_definitions(${TEST_NAME} PRIVATE PINO_USE_SIMD=1 PINO_SIMD_DISPATCH=1)
     else()
       target_compile_definitions(${TEST_NAME} PRIVATE PINO_USE_SIMD=0)
     endif()
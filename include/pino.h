@@ -27,6 +27,13 @@ typedef char pino_magic_safe_t[sizeof(pino_magic_t) + 1]; /* + '\0' */
 
 typedef uint64_t pino_static_fields_size_t;
 
+/* format flags live in the top byte of the serialized static fields size */
+#define PINO_FORMAT_FLAG_COMPRESSED 0x01
+#define PINO_FORMAT_FLAG_DICTIONARY 0x02
+#define PINO_FORMAT_FLAG_CHECKSUM   0x04
+#define PINO_FORMAT_FLAG_ALIGNED    0x08
+#define PINO_FORMAT_FLAG_BIG_ENDIAN 0x10
+
 typedef struct {
     pino_magic_safe_t magic;
     pino_static_fields_size_t static_fields_size;
@@ -34,18 +41,37 @@ typedef struct {
     void *static_fields;
     void *this;
     void *entry;
+    size_t serialize_size_cache;
+    uint32_t serialize_generation;
+    void *encoded;
+    bool dirty;
 } pino_t;
 
+typedef struct {
+    pino_magic_safe_t magic;
+    pino_static_fields_size_t static_fields_size;
+    const void *static_fields;
+    size_t payload_offset;
+    size_t payload_size;
+    size_t raw_payload_size;
+    uint16_t dictionary_id;
+    uint8_t flags;
+    bool registered;
+} pino_peek_info_t;
+
 bool pino_init(void);
 void pino_free(void);
 
+bool pino_peek(const void *src, size_t size, pino_peek_info_t *info);
 size_t pino_serialize_size(const pino_t *pino);
 bool pino_serialize(const pino_t *pino, void *dest);
+bool pino_serialize_n(const pino_t *pino, void *dest, size_t capacity, size_t *written);
 pino_t *pino_unserialize(const void *src, size_t size);
 pino_t *pino_pack(pino_magic_safe_t magic, const void *src, size_t size);
 size_t pino_unpack_size(const pino_t *pino);
 bool pino_unpack(const pino_t *pino, void *dest);
 void pino_destroy(pino_t *pino);
+void pino_touch(pino_t *pino);
 
 uint32_t pino_version_id(void);
 pino_buildtime_t pino_buildtime(void);
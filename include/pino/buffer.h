@@ -0,0 +1,42 @@
+/*
+ * libpino - buffer.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_BUFFER_H
+#define PINO_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} pino_buffer_t;
+
+bool pino_buffer_init(pino_buffer_t *buffer, size_t capacity);
+bool pino_buffer_reserve(pino_buffer_t *buffer, size_t additional);
+bool pino_buffer_append(pino_buffer_t *buffer, const pino_t *pino);
+bool pino_buffer_append_bytes(pino_buffer_t *buffer, const void *src, size_t size);
+void pino_buffer_reset(pino_buffer_t *buffer);
+void *pino_buffer_release(pino_buffer_t *buffer, size_t *size);
+void pino_buffer_data_free(void *data);
+void pino_buffer_free(pino_buffer_t *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PINO_BUFFER_H */
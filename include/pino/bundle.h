@@ -0,0 +1,57 @@
+/*
+ * libpino - bundle.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_BUNDLE_H
+#define PINO_BUNDLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <pino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * bundle layout (all integers are LE):
+ *   header: "PINB" u32 version
+ *   records: concatenated pino_serialize() outputs
+ *   index: { u64 offset, u64 size, magic[4], u32 reserved } * count
+ *   footer: u64 index_offset, u64 count, u32 version, "PINB"
+ */
+#define PINO_BUNDLE_MAGIC       "PINB"
+#define PINO_BUNDLE_VERSION     1
+#define PINO_BUNDLE_HEADER_SIZE 8
+#define PINO_BUNDLE_INDEX_SIZE  24
+#define PINO_BUNDLE_FOOTER_SIZE 24
+
+typedef struct _pino_bundle_writer_t pino_bundle_writer_t;
+typedef struct _pino_bundle_t pino_bundle_t;
+
+pino_bundle_writer_t *pino_bundle_writer_create(FILE *fp);
+bool pino_bundle_writer_add(pino_bundle_writer_t *writer, const pino_t *pino);
+bool pino_bundle_writer_add_raw(pino_bundle_writer_t *writer, const void *src, size_t size);
+bool pino_bundle_writer_close(pino_bundle_writer_t *writer);
+
+pino_bundle_t *pino_bundle_open(const void *data, size_t size);
+size_t pino_bundle_count(const pino_bundle_t *bundle);
+bool pino_bundle_record(const pino_bundle_t *bundle, size_t index, const void **data, size_t *size);
+bool pino_bundle_magic(const pino_bundle_t *bundle, size_t index, pino_magic_safe_t magic);
+size_t pino_bundle_find(const pino_bundle_t *bundle, size_t start, pino_magic_safe_t magic);
+pino_t *pino_bundle_get(const pino_bundle_t *bundle, size_t index);
+void pino_bundle_close(pino_bundle_t *bundle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PINO_BUNDLE_H */
@@ -0,0 +1,41 @@
+/*
+ * libpino - delta.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_DELTA_H
+#define PINO_DELTA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pino.h>
+#include <pino/buffer.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * delta layout (integers are LE, varints are LEB128):
+ *   header: magic[4], varint target size, u32 crc32c of the reference
+ *   ops: { varint unchanged, varint changed, changed bytes } until the end of the delta
+ *   bytes after the last op are taken from the reference
+ */
+#define PINO_DELTA_MIN_HEADER_SIZE 9
+
+bool pino_serialize_delta(const pino_t *pino, const void *reference, size_t reference_size, pino_buffer_t *buffer);
+bool pino_delta_apply(const void *reference, size_t reference_size, const void *delta, size_t delta_size,
+                      pino_buffer_t *buffer);
+pino_t *pino_unserialize_delta(const void *reference, size_t reference_size, const void *delta, size_t delta_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PINO_DELTA_H */
@@ -0,0 +1,33 @@
+/*
+ * libpino - dictionary.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_DICTIONARY_H
+#define PINO_DICTIONARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PINO_DICTIONARY_MAX_SIZE 65535
+
+size_t pino_dictionary_train(pino_magic_safe_t magic, const void *const *samples, const size_t *sizes, size_t count,
+                             void *dest, size_t capacity);
+bool pino_dictionary_register(pino_magic_safe_t magic, uint16_t id, const void *dict, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PINO_DICTIONARY_H */
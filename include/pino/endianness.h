@@ -19,6 +19,20 @@
 extern "C" {
 #endif
 
+/* byte swap kernels, x86-64 picks one at pino_init() from what the CPU supports */
+typedef enum {
+    PINO_BSWAP_KERNEL_SCALAR = 0,
+    PINO_BSWAP_KERNEL_SSSE3,
+    PINO_BSWAP_KERNEL_AVX2,
+    PINO_BSWAP_KERNEL_AVX512,
+    PINO_BSWAP_KERNEL_NEON,
+    PINO_BSWAP_KERNEL_WASM_SIMD128,
+    PINO_BSWAP_KERNEL_COUNT,
+} pino_bswap_kernel_t;
+
+pino_bswap_kernel_t pino_endianness_kernel(void);
+const char *pino_endianness_kernel_name(pino_bswap_kernel_t kernel);
+
 void *pino_endianness_memcpy_le2native(void *dest, const void *src, size_t size, size_t elem_size);
 void *pino_endianness_memcpy_be2native(void *dest, const void *src, size_t size, size_t elem_size);
 void *pino_endianness_memcpy_native2le(void *dest, const void *src, size_t size, size_t elem_size);
@@ -0,0 +1,46 @@
+/*
+ * libpino - file.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_FILE_H
+#define PINO_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pino.h>
+#include <pino/bundle.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PINO_FILE_ADVICE_NORMAL = 0,
+    PINO_FILE_ADVICE_SEQUENTIAL,
+    PINO_FILE_ADVICE_RANDOM,
+    PINO_FILE_ADVICE_WILLNEED,
+} pino_file_advice_t;
+
+typedef struct _pino_file_t pino_file_t;
+
+pino_file_t *pino_file_open(const char *path);
+bool pino_file_advise(pino_file_t *file, pino_file_advice_t advice);
+const void *pino_file_data(const pino_file_t *file);
+size_t pino_file_size(const pino_file_t *file);
+bool pino_file_view(const pino_file_t *file, size_t offset, size_t size, const void **data);
+pino_t *pino_file_unserialize(const pino_file_t *file, size_t offset, size_t size);
+pino_bundle_t *pino_file_bundle(pino_file_t *file);
+void pino_file_close(pino_file_t *file);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PINO_FILE_H */
@@ -19,11 +19,23 @@
 extern "C" {
 #endif
 
+#define PINO_HANDLER_FLAG_COMPRESS       (1U << 0)
+#define PINO_HANDLER_FLAG_CHECKSUM       (1U << 1)
+#define PINO_HANDLER_FLAG_COMPACT_HEADER (1U << 2)
+#define PINO_HANDLER_FLAG_NATIVE_ORDER   (1U << 3)
+
+#define PINO_PAYLOAD_ALIGNMENT_MAX 64
+
 bool pino_handler_register(pino_magic_safe_t magic, pino_handler_t *handler);
 bool pino_handler_unregister(pino_magic_safe_t magic);
+bool pino_handler_set_flags(pino_magic_safe_t magic, uint32_t flags);
+uint32_t pino_handler_get_flags(pino_magic_safe_t magic);
 
 void *pino_handler_context_set(void *entry);
 void *pino_handler_context_resolve(void *entry);
+void *pino_handler_serialize_data_checked(void *dest, const void *src, size_t size, size_t elem_size);
+void *pino_handler_serialize_data_ordered(void *dest, const void *src, size_t size, size_t elem_size);
+void *pino_handler_unserialize_data_ordered(void *dest, const void *src, size_t size, size_t elem_size);
 
 void *pino_memory_manager_malloc(void *entry, size_t size);
 void *pino_memory_manager_calloc(void *entry, size_t count, size_t size);
@@ -110,8 +122,11 @@ void pino_memory_manager_free(void *entry, void *ptr);
 #define PH_PINO_STATIC_P(name, pino)          ((struct PH_NAME_STATIC_FIELDS_STRUCT(name) *)pino->static_fields)
 #define PH_PINO_STATIC_GET_P(name, pino, param, dest) \
     PH_THIS_STATIC_GET_P(name, PH_PINO_STATIC_P(name, pino), param, dest)
-#define PH_PINO_STATIC_SET_P(name, pino, param, src) \
-    PH_THIS_STATIC_SET_P(name, PH_PINO_STATIC_P(name, pino), param, src)
+#define PH_PINO_STATIC_SET_P(name, pino, param, src)                          \
+    do {                                                                      \
+        PH_THIS_STATIC_SET_P(name, PH_PINO_STATIC_P(name, pino), param, src); \
+        pino_touch(pino);                                                     \
+    } while (0)
 
 #define PH_SIZE(name)        (sizeof(struct PH_NAME_STRUCT(name)))
 #define PH_SIZE_STATIC(name) (sizeof(struct PH_NAME_STATIC_FIELDS_STRUCT(name)))
@@ -143,6 +158,14 @@ void pino_memory_manager_free(void *entry, void *ptr);
     do {                                                                                                         \
         pino_endianness_memcpy_native2le(PH_ARG_DST, PH_THIS(name)->src, size, sizeof((PH_THIS(name)->src)[0])); \
     } while (0)
+#define PH_SERIALIZE_DATA_CHECKED(name, src, size)                                                                  \
+    do {                                                                                                            \
+        pino_handler_serialize_data_checked(PH_ARG_DST, PH_THIS(name)->src, size, sizeof((PH_THIS(name)->src)[0])); \
+    } while (0)
+#define PH_SERIALIZE_DATA_ORDERED(name, src, size)                                                                  \
+    do {                                                                                                            \
+        pino_handler_serialize_data_ordered(PH_ARG_DST, PH_THIS(name)->src, size, sizeof((PH_THIS(name)->src)[0])); \
+    } while (0)
 #define PH_UNSERIALIZE_DATA(name, dest, size)                                                                      \
     do {                                                                                                           \
         if (size > PH_ARG_SRC_SIZE) {                                                                              \
@@ -150,6 +173,14 @@ void pino_memory_manager_free(void *entry, void *ptr);
         }                                                                                                          \
         pino_endianness_memcpy_le2native(PH_THIS(name)->dest, PH_ARG_SRC, size, sizeof((PH_THIS(name)->dest)[0])); \
     } while (0)
+#define PH_UNSERIALIZE_DATA_ORDERED(name, dest, size)                                                     \
+    do {                                                                                                  \
+        if (size > PH_ARG_SRC_SIZE) {                                                                     \
+            return false;                                                                                 \
+        }                                                                                                 \
+        pino_handler_unserialize_data_ordered(PH_THIS(name)->dest, PH_ARG_SRC, size,                      \
+                                              sizeof((PH_THIS(name)->dest)[0]));                          \
+    } while (0)
 #define PH_PACK_DATA(name, param, size)                    \
     do {                                                   \
         PH_MEMCPY(PH_THIS(name)->param, PH_ARG_SRC, size); \
@@ -170,7 +201,8 @@ void pino_memory_manager_free(void *entry, void *ptr);
     PH_DEFUN_CREATE(name);                       \
     PH_DEFUN_DESTROY(name);
 
-#define PH_END(name)                                                                                    \
+#define PH_END(name) PH_END_ALIGNED(name, 0)
+#define PH_END_ALIGNED(name, alignment)                                                                 \
     static pino_handler_t PH_NAME_HANDLER(name) = {.static_fields_size = PH_SIZE_STATIC(name),          \
                                                    .serialize_size = PH_NAME_FUNC_SERIALIZE_SIZE(name), \
                                                    .serialize = PH_NAME_FUNC_SERIALIZE(name),           \
@@ -180,6 +212,7 @@ void pino_memory_manager_free(void *entry, void *ptr);
                                                    .unpack = PH_NAME_FUNC_UNPACK(name),                 \
                                                    .create = PH_NAME_FUNC_CREATE(name),                 \
                                                    .destroy = PH_NAME_FUNC_DESTROY(name),               \
+                                                   .payload_alignment = alignment,                      \
                                                    .entry = NULL};                                      \
     static inline bool PH_NAME_REG(name)(void)                                                          \
     {                                                                                                   \
@@ -209,6 +242,7 @@ struct _pino_handler_t {
     pino_handler_unpack_t unpack;
     pino_handler_create_t create;
     pino_handler_destroy_t destroy;
+    size_t payload_alignment; /* 0 or a power of two up to PINO_PAYLOAD_ALIGNMENT_MAX */
     void *entry;
 };
 
@@ -0,0 +1,45 @@
+/*
+ * libpino - reassembler.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_REASSEMBLER_H
+#define PINO_REASSEMBLER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * collects size-prefixed records from arbitrary chunks and unserializes each one once all of its bytes are there.
+ * every record on the stream is prefixed by its serialized size as u64 LE.
+ */
+#define PINO_REASSEMBLER_PREFIX_SIZE sizeof(uint64_t)
+
+typedef struct _pino_reassembler_t pino_reassembler_t;
+
+/* ownership of pino is passed to the callback */
+typedef void (*pino_reassembler_callback_t)(pino_t *pino, void *userdata);
+
+pino_reassembler_t *pino_reassembler_create(pino_reassembler_callback_t callback, void *userdata,
+                                            size_t max_record_size);
+bool pino_reassembler_feed(pino_reassembler_t *reassembler, const void *bytes, size_t size);
+size_t pino_reassembler_buffered(const pino_reassembler_t *reassembler);
+void pino_reassembler_reset(pino_reassembler_t *reassembler);
+void pino_reassembler_destroy(pino_reassembler_t *reassembler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PINO_REASSEMBLER_H */
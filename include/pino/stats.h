@@ -0,0 +1,68 @@
+/*
+ * libpino - stats.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_STATS_H
+#define PINO_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PINO_STATS_MAGIC_MAX 64
+#define PINO_STATS_BUCKETS   32
+
+typedef enum {
+    PINO_STATS_OP_CREATE = 0,
+    PINO_STATS_OP_PACK,
+    PINO_STATS_OP_SERIALIZE,
+    PINO_STATS_OP_UNSERIALIZE,
+    PINO_STATS_OP_UNPACK,
+    PINO_STATS_OP_DESTROY,
+    PINO_STATS_OP_COUNT,
+} pino_stats_op_t;
+
+/*
+ * histogram[i] counts calls that took [2^i, 2^(i+1)) ns.
+ * the first bucket also takes 0 ns and the last one everything above.
+ */
+typedef struct {
+    uint64_t calls;
+    uint64_t bytes;
+    uint64_t failures;
+    uint64_t histogram[PINO_STATS_BUCKETS];
+} pino_stats_counters_t;
+
+typedef struct {
+    pino_magic_safe_t magic;
+    pino_stats_counters_t ops[PINO_STATS_OP_COUNT];
+} pino_stats_t;
+
+/* process wide, realloc(NULL, n) counts as an allocation and free(NULL) is not counted */
+typedef struct {
+    uint64_t allocations;
+    uint64_t reallocations;
+    uint64_t frees;
+    uint64_t bytes;
+} pino_stats_alloc_t;
+
+bool pino_stats_enabled(void);
+size_t pino_stats_snapshot(pino_stats_t *stats, size_t capacity);
+bool pino_stats_alloc(pino_stats_alloc_t *alloc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PINO_STATS_H */
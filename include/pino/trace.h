@@ -0,0 +1,67 @@
+/*
+ * libpino - trace.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_TRACE_H
+#define PINO_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <pino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* public entry points first, then the handler callbacks they dispatch to */
+typedef enum {
+    PINO_TRACE_OP_PEEK = 0,
+    PINO_TRACE_OP_SERIALIZE_SIZE,
+    PINO_TRACE_OP_SERIALIZE,
+    PINO_TRACE_OP_UNSERIALIZE,
+    PINO_TRACE_OP_PACK,
+    PINO_TRACE_OP_UNPACK_SIZE,
+    PINO_TRACE_OP_UNPACK,
+    PINO_TRACE_OP_DESTROY,
+    PINO_TRACE_OP_TOUCH,
+    PINO_TRACE_OP_HANDLER_CREATE,
+    PINO_TRACE_OP_HANDLER_DESTROY,
+    PINO_TRACE_OP_HANDLER_PACK,
+    PINO_TRACE_OP_HANDLER_UNPACK_SIZE,
+    PINO_TRACE_OP_HANDLER_UNPACK,
+    PINO_TRACE_OP_HANDLER_SERIALIZE_SIZE,
+    PINO_TRACE_OP_HANDLER_SERIALIZE,
+    PINO_TRACE_OP_HANDLER_UNSERIALIZE,
+    PINO_TRACE_OP_COUNT,
+} pino_trace_op_t;
+
+typedef enum {
+    PINO_TRACE_PHASE_BEGIN = 0,
+    PINO_TRACE_PHASE_END,
+} pino_trace_phase_t;
+
+typedef struct {
+    pino_trace_op_t op;
+    pino_trace_phase_t phase;
+    pino_magic_safe_t magic; /* empty while not known yet */
+    size_t size;
+    bool result; /* always false on begin */
+} pino_trace_event_t;
+
+typedef void (*pino_trace_hook_t)(const pino_trace_event_t *event, void *user_data);
+
+bool pino_trace_enabled(void);
+bool pino_trace_set_hook(pino_trace_hook_t hook, void *user_data);
+const char *pino_trace_op_name(pino_trace_op_t op);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PINO_TRACE_H */
@@ -0,0 +1,59 @@
+/*
+ * libpino - writer.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_WRITER_H
+#define PINO_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pino.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PINO_WRITER_BUFFER_SIZE_DEFAULT (1024 * 1024)
+#define PINO_WRITER_BUFFER_ALIGNMENT    4096
+
+typedef enum {
+    PINO_WRITER_BACKEND_AUTO = 0,
+    PINO_WRITER_BACKEND_IO_URING,
+    PINO_WRITER_BACKEND_THREAD,
+    PINO_WRITER_BACKEND_SYNC,
+} pino_writer_backend_t;
+
+typedef enum {
+    PINO_WRITER_SYNC_NONE = 0,
+    PINO_WRITER_SYNC_DATA,
+    PINO_WRITER_SYNC_FULL,
+} pino_writer_sync_t;
+
+typedef struct {
+    size_t buffer_size;
+    pino_writer_backend_t backend;
+    pino_writer_sync_t sync;
+} pino_writer_options_t;
+
+typedef struct _pino_writer_t pino_writer_t;
+
+pino_writer_t *pino_writer_create(int fd, const pino_writer_options_t *options);
+bool pino_writer_add(pino_writer_t *writer, const pino_t *pino);
+bool pino_writer_add_raw(pino_writer_t *writer, const void *src, size_t size);
+bool pino_writer_flush(pino_writer_t *writer);
+bool pino_writer_close(pino_writer_t *writer);
+pino_writer_backend_t pino_writer_backend(const pino_writer_t *writer);
+uint64_t pino_writer_offset(const pino_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PINO_WRITER_H */
@@ -0,0 +1,118 @@
+/*
+ * libpino - bswap.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <pino/endianness.h>
+
+#include "internal/bswap.h"
+#include "internal/common.h"
+#include "internal/cpu.h"
+
+#define BSWAP_KERNEL_ENV "PINO_BSWAP_KERNEL"
+
+pino_bswap_kernels_t pino_bswap_kernels = {PINO_BSWAP_KERNEL_SCALAR, pino_bswap_memcpy_scalar,
+                                           pino_bswap_memcpy_crc32c_scalar};
+
+/* indexed by pino_bswap_kernel_t, an entry without a copy is not built into this library */
+static const pino_bswap_kernels_t g_bswap_kernels[PINO_BSWAP_KERNEL_COUNT] = {
+    {PINO_BSWAP_KERNEL_SCALAR, pino_bswap_memcpy_scalar, pino_bswap_memcpy_crc32c_scalar},
+#if PINO_SIMD_DISPATCH
+    /* SSSE3 has no crc32 instruction, SSE4.2 came one generation later */
+    {PINO_BSWAP_KERNEL_SSSE3, pino_bswap_memcpy_ssse3, pino_bswap_memcpy_crc32c_scalar},
+    {PINO_BSWAP_KERNEL_AVX2, pino_bswap_memcpy_avx2, pino_bswap_memcpy_crc32c_avx2},
+#else
+    {PINO_BSWAP_KERNEL_SSSE3, NULL, NULL},
+    {PINO_BSWAP_KERNEL_AVX2, NULL, NULL},
+#endif
+#if PINO_SIMD_DISPATCH && PINO_SIMD_AVX512
+    {PINO_BSWAP_KERNEL_AVX512, pino_bswap_memcpy_avx512, pino_bswap_memcpy_crc32c_avx2},
+#else
+    {PINO_BSWAP_KERNEL_AVX512, NULL, NULL},
+#endif
+    /* the inline kernels of bswap.h are the native ones on these targets */
+#if PINO_USE_SIMD && defined(PINO_SIMD_NEON)
+    {PINO_BSWAP_KERNEL_NEON, pino_bswap_memcpy_generic, pino_bswap_memcpy_crc32c_generic},
+#else
+    {PINO_BSWAP_KERNEL_NEON, NULL, NULL},
+#endif
+#if PINO_USE_SIMD && defined(PINO_SIMD_WASM)
+    {PINO_BSWAP_KERNEL_WASM_SIMD128, pino_bswap_memcpy_generic, pino_bswap_memcpy_crc32c_generic},
+#else
+    {PINO_BSWAP_KERNEL_WASM_SIMD128, NULL, NULL},
+#endif
+};
+
+static const char *g_bswap_kernel_names[PINO_BSWAP_KERNEL_COUNT] = {
+    "scalar", "ssse3", "avx2", "avx512", "neon", "wasm_simd128",
+};
+
+static inline bool kernel_supported(pino_bswap_kernel_t kernel, uint32_t features)
+{
+    switch (kernel) {
+    case PINO_BSWAP_KERNEL_SSSE3:
+        return (features & PINO_CPU_SSSE3) != 0;
+    case PINO_BSWAP_KERNEL_AVX2:
+        /* the fused kernel uses the crc32 instruction as well */
+        return (features & (PINO_CPU_AVX2 | PINO_CPU_SSE42)) == (PINO_CPU_AVX2 | PINO_CPU_SSE42);
+    case PINO_BSWAP_KERNEL_AVX512:
+        /* its fused kernel is the AVX2 one */
+        return (features & (PINO_CPU_AVX512 | PINO_CPU_AVX2 | PINO_CPU_SSE42)) ==
+               (PINO_CPU_AVX512 | PINO_CPU_AVX2 | PINO_CPU_SSE42);
+    default:
+        return true;
+    }
+}
+
+extern const char *pino_endianness_kernel_name(pino_bswap_kernel_t kernel)
+{
+    if ((size_t)kernel >= PINO_BSWAP_KERNEL_COUNT) {
+        return NULL;
+    }
+
+    return g_bswap_kernel_names[kernel];
+}
+
+extern pino_bswap_kernel_t pino_endianness_kernel(void)
+{
+    return pino_bswap_kernels.kernel;
+}
+
+extern const pino_bswap_kernels_t *pino_bswap_kernels_find(pino_bswap_kernel_t kernel)
+{
+    if ((size_t)kernel >= PINO_BSWAP_KERNEL_COUNT || !g_bswap_kernels[kernel].copy ||
+        !kernel_supported(kernel, pino_cpu_features())) {
+        return NULL;
+    }
+
+    return &g_bswap_kernels[kernel];
+}
+
+extern void pino_bswap_init(void)
+{
+    const pino_bswap_kernels_t *found = NULL;
+    const char *name;
+    size_t i;
+
+    /* a forced kernel the CPU cannot run is ignored rather than left to fault later */
+    name = getenv(BSWAP_KERNEL_ENV);
+    for (i = 0; name && i < PINO_BSWAP_KERNEL_COUNT && !found; i++) {
+        if (strcmp(name, g_bswap_kernel_names[i]) == 0) {
+            found = pino_bswap_kernels_find((pino_bswap_kernel_t)i);
+        }
+    }
+
+    /* otherwise the widest one */
+    for (i = PINO_BSWAP_KERNEL_COUNT; i > 0 && !found; i--) {
+        found = pino_bswap_kernels_find((pino_bswap_kernel_t)(i - 1));
+    }
+
+    pino_bswap_kernels = *found;
+}
@@ -0,0 +1,90 @@
+/*
+ * libpino - bswap_avx2.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "internal/bswap.h"
+
+#if PINO_SIMD_DISPATCH
+
+#include <immintrin.h>
+
+static inline __m256i shuffle_mask(size_t elem_size)
+{
+    if (elem_size == 2) {
+        return _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11,
+                                10, 13, 12, 15, 14);
+    } else if (elem_size == 4) {
+        return _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10,
+                                9, 8, 15, 14, 13, 12);
+    }
+
+    return _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13,
+                            12, 11, 10, 9, 8);
+}
+
+extern void *pino_bswap_memcpy_avx2(void *dest, const void *src, size_t size, size_t elem_size)
+{
+    const uint8_t *sp = (const uint8_t *)src;
+    uint8_t *dp = (uint8_t *)dest;
+    __m256i mask, data;
+    size_t i;
+
+    if ((elem_size != 2 && elem_size != 4 && elem_size != 8) || size % elem_size != 0) {
+        return pino_bswap_memcpy_generic(dest, src, size, elem_size);
+    }
+
+    mask = shuffle_mask(elem_size);
+
+    for (i = 0; i + 32 <= size; i += 32) {
+        data = _mm256_loadu_si256((const __m256i *)(sp + i));
+        _mm256_storeu_si256((__m256i *)(dp + i), _mm256_shuffle_epi8(data, mask));
+    }
+
+    pino_bswap_memcpy_generic(dp + i, sp + i, size - i, elem_size);
+
+    return dest;
+}
+
+/*
+ * this file is also built with SSE4.2, so the crc steps below and in the tail are the crc32 instruction. the 64-bit
+ * lane extracts and crc32 steps exist on x86_64 only, anywhere else the generic kernel does the work.
+ */
+extern uint32_t pino_bswap_memcpy_crc32c_avx2(void *dest, const void *src, size_t size, size_t elem_size,
+                                              uint32_t state)
+{
+#if defined(PINO_CRC32C_SSE42)
+    const uint8_t *sp = (const uint8_t *)src;
+    uint8_t *dp = (uint8_t *)dest;
+    __m256i mask, data;
+
+    if ((elem_size != 1 && elem_size != 2 && elem_size != 4 && elem_size != 8) || size % elem_size != 0) {
+        return pino_bswap_memcpy_crc32c_generic(dest, src, size, elem_size, state);
+    }
+
+    mask = shuffle_mask(elem_size);
+
+    for (; size >= 32; size -= 32, sp += 32, dp += 32) {
+        data = _mm256_loadu_si256((const __m256i *)sp);
+        if (elem_size > 1) {
+            data = _mm256_shuffle_epi8(data, mask);
+        }
+        _mm256_storeu_si256((__m256i *)dp, data);
+
+        state = pino_crc32c_step64(state, (uint64_t)_mm256_extract_epi64(data, 0));
+        state = pino_crc32c_step64(state, (uint64_t)_mm256_extract_epi64(data, 1));
+        state = pino_crc32c_step64(state, (uint64_t)_mm256_extract_epi64(data, 2));
+        state = pino_crc32c_step64(state, (uint64_t)_mm256_extract_epi64(data, 3));
+    }
+
+    return pino_bswap_memcpy_crc32c_generic(dp, sp, size, elem_size, state);
+#else
+    return pino_bswap_memcpy_crc32c_generic(dest, src, size, elem_size, state);
+#endif
+}
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * libpino - bswap_avx512.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "internal/bswap.h"
+
+#if PINO_SIMD_DISPATCH && PINO_SIMD_AVX512
+
+#include <immintrin.h>
+
+extern void *pino_bswap_memcpy_avx512(void *dest, const void *src, size_t size, size_t elem_size)
+{
+    const uint8_t *sp = (const uint8_t *)src;
+    uint8_t *dp = (uint8_t *)dest;
+    __m128i lane;
+    __m512i mask, data;
+    size_t i;
+
+    if ((elem_size != 2 && elem_size != 4 && elem_size != 8) || size % elem_size != 0) {
+        return pino_bswap_memcpy_generic(dest, src, size, elem_size);
+    }
+
+    /* vpshufb works per 128-bit lane, so one lane pattern is repeated four times */
+    if (elem_size == 2) {
+        lane = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    } else if (elem_size == 4) {
+        lane = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    } else {
+        lane = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+    mask = _mm512_broadcast_i32x4(lane);
+
+    for (i = 0; i + 64 <= size; i += 64) {
+        data = _mm512_loadu_si512((const void *)(sp + i));
+        _mm512_storeu_si512((void *)(dp + i), _mm512_shuffle_epi8(data, mask));
+    }
+
+    pino_bswap_memcpy_generic(dp + i, sp + i, size - i, elem_size);
+
+    return dest;
+}
+
+#endif
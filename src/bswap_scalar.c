@@ -0,0 +1,25 @@
+/*
+ * libpino - bswap_scalar.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+/* the portable branch of bswap.h, the fallback and the reference for every other kernel */
+#undef PINO_USE_SIMD
+#define PINO_USE_SIMD 0
+
+#include "internal/bswap.h"
+
+extern void *pino_bswap_memcpy_scalar(void *dest, const void *src, size_t size, size_t elem_size)
+{
+    return pino_bswap_memcpy_generic(dest, src, size, elem_size);
+}
+
+extern uint32_t pino_bswap_memcpy_crc32c_scalar(void *dest, const void *src, size_t size, size_t elem_size,
+                                                uint32_t state)
+{
+    return pino_bswap_memcpy_crc32c_generic(dest, src, size, elem_size, state);
+}
@@ -0,0 +1,46 @@
+/*
+ * libpino - bswap_ssse3.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "internal/bswap.h"
+
+#if PINO_SIMD_DISPATCH
+
+#include <tmmintrin.h>
+
+extern void *pino_bswap_memcpy_ssse3(void *dest, const void *src, size_t size, size_t elem_size)
+{
+    const uint8_t *sp = (const uint8_t *)src;
+    uint8_t *dp = (uint8_t *)dest;
+    __m128i shuffle_mask, data;
+    size_t i;
+
+    if ((elem_size != 2 && elem_size != 4 && elem_size != 8) || size % elem_size != 0) {
+        return pino_bswap_memcpy_generic(dest, src, size, elem_size);
+    }
+
+    if (elem_size == 2) {
+        shuffle_mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    } else if (elem_size == 4) {
+        shuffle_mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    } else {
+        shuffle_mask = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+
+    for (i = 0; i + 16 <= size; i += 16) {
+        data = _mm_loadu_si128((const __m128i *)(sp + i));
+        _mm_storeu_si128((__m128i *)(dp + i), _mm_shuffle_epi8(data, shuffle_mask));
+    }
+
+    /* whole elements are left over, since 16 is a multiple of every element size handled here */
+    pino_bswap_memcpy_generic(dp + i, sp + i, size - i, elem_size);
+
+    return dest;
+}
+
+#endif
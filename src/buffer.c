@@ -0,0 +1,172 @@
+/*
+ * libpino - buffer.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pino.h>
+#include <pino/buffer.h>
+#include <pino/handler.h>
+
+#include "internal/common.h"
+
+#define BUFFER_MIN_CAPACITY 64
+
+extern bool pino_buffer_init(pino_buffer_t *buffer, size_t capacity)
+{
+    if (!buffer) {
+        return false;
+    }
+
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+
+    if (capacity == 0) {
+        return true;
+    }
+
+    buffer->data = (uint8_t *)pmalloc(capacity);
+    if (!buffer->data) {
+        return false;
+    }
+
+    buffer->capacity = capacity;
+
+    return true;
+}
+
+extern bool pino_buffer_reserve(pino_buffer_t *buffer, size_t additional)
+{
+    uint8_t *data;
+    size_t required, new_capacity;
+
+    if (!buffer) {
+        return false;
+    }
+
+    if (additional > SIZE_MAX - buffer->size) {
+        return false;
+    }
+
+    required = buffer->size + additional;
+    if (required <= buffer->capacity) {
+        return true;
+    }
+
+    new_capacity = buffer->capacity < BUFFER_MIN_CAPACITY ? BUFFER_MIN_CAPACITY : buffer->capacity;
+    while (new_capacity < required) {
+        if (new_capacity > SIZE_MAX / 2) {
+            new_capacity = required;
+            break;
+        }
+        new_capacity *= 2;
+    }
+
+    data = (uint8_t *)prealloc(buffer->data, new_capacity);
+    if (!data) {
+        return false;
+    }
+
+    buffer->data = data;
+    buffer->capacity = new_capacity;
+
+    return true;
+}
+
+extern bool pino_buffer_append(pino_buffer_t *buffer, const pino_t *pino)
+{
+    size_t written;
+
+    if (!buffer || !pino) {
+        return false;
+    }
+
+    /* serialize straight into the spare capacity, grow only when it does not fit */
+    if (pino_serialize_n(pino, buffer->data ? buffer->data + buffer->size : NULL, buffer->capacity - buffer->size,
+                         &written)) {
+        buffer->size += written;
+        return true;
+    }
+
+    if (written <= buffer->capacity - buffer->size || !pino_buffer_reserve(buffer, written)) {
+        return false;
+    }
+
+    if (!pino_serialize_n(pino, buffer->data + buffer->size, buffer->capacity - buffer->size, &written)) {
+        return false;
+    }
+
+    buffer->size += written;
+
+    return true;
+}
+
+extern bool pino_buffer_append_bytes(pino_buffer_t *buffer, const void *src, size_t size)
+{
+    if (!buffer || (!src && size > 0)) {
+        return false;
+    }
+
+    if (size == 0) {
+        return true;
+    }
+
+    if (!pino_buffer_reserve(buffer, size)) {
+        return false;
+    }
+
+    pmemcpy(buffer->data + buffer->size, src, size);
+    buffer->size += size;
+
+    return true;
+}
+
+extern void pino_buffer_reset(pino_buffer_t *buffer)
+{
+    if (!buffer) {
+        return;
+    }
+
+    buffer->size = 0;
+}
+
+extern void *pino_buffer_release(pino_buffer_t *buffer, size_t *size)
+{
+    void *data;
+
+    if (!buffer) {
+        return NULL;
+    }
+
+    data = buffer->data;
+    if (size) {
+        *size = buffer->size;
+    }
+
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+
+    return data;
+}
+
+extern void pino_buffer_data_free(void *data)
+{
+    pfree(data);
+}
+
+extern void pino_buffer_free(pino_buffer_t *buffer)
+{
+    if (!buffer) {
+        return;
+    }
+
+    pfree(buffer->data);
+    buffer->data = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * libpino - bundle.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+
+#include <pino.h>
+#include <pino/buffer.h>
+#include <pino/bundle.h>
+#include <pino/handler.h>
+
+#include "internal/common.h"
+
+struct _pino_bundle_writer_t {
+    FILE *fp;
+    uint64_t offset;
+    size_t count;
+    size_t index_capacity;
+    uint8_t *index;
+    pino_buffer_t scratch;
+    bool failed;
+};
+
+struct _pino_bundle_t {
+    const uint8_t *data;
+    uint64_t index_offset;
+    size_t count;
+};
+
+static inline bool write_bytes(pino_bundle_writer_t *writer, const void *src, size_t size)
+{
+    if (size > 0 && fwrite(src, 1, size, writer->fp) != size) {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->offset += size;
+
+    return true;
+}
+
+static inline bool glow_index(pino_bundle_writer_t *writer)
+{
+    uint8_t *index;
+    size_t new_capacity;
+
+    if (writer->count < writer->index_capacity) {
+        return true;
+    }
+
+    new_capacity = writer->index_capacity > 0 ? writer->index_capacity * 2 : MM_STEP;
+    if (new_capacity > SIZE_MAX / PINO_BUNDLE_INDEX_SIZE) {
+        return false;
+    }
+
+    index = (uint8_t *)prealloc(writer->index, new_capacity * PINO_BUNDLE_INDEX_SIZE);
+    if (!index) {
+        return false;
+    }
+
+    writer->index = index;
+    writer->index_capacity = new_capacity;
+
+    return true;
+}
+
+static inline const uint8_t *index_entry(const pino_bundle_t *bundle, size_t index)
+{
+    return bundle->data + bundle->index_offset + (uint64_t)index * PINO_BUNDLE_INDEX_SIZE;
+}
+
+extern pino_bundle_writer_t *pino_bundle_writer_create(FILE *fp)
+{
+    pino_bundle_writer_t *writer;
+    uint32_t version = PINO_BUNDLE_VERSION;
+    uint8_t header[PINO_BUNDLE_HEADER_SIZE];
+
+    if (!fp) {
+        return NULL;
+    }
+
+    writer = (pino_bundle_writer_t *)pcalloc(1, sizeof(pino_bundle_writer_t));
+    if (!writer) {
+        return NULL;
+    }
+
+    writer->fp = fp;
+
+    pmemcpy(header, PINO_BUNDLE_MAGIC, 4);
+    pmemcpy_n2l(header + 4, &version, sizeof(version));
+    if (!write_bytes(writer, header, sizeof(header))) {
+        pfree(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+extern bool pino_bundle_writer_add_raw(pino_bundle_writer_t *writer, const void *src, size_t size)
+{
+    uint8_t *entry;
+    uint64_t record_offset, record_size;
+
+    if (!writer || writer->failed || !src || size < HEADER_MIN_SIZE) {
+        return false;
+    }
+
+    if (!glow_index(writer)) {
+        return false;
+    }
+
+    record_offset = writer->offset;
+    record_size = (uint64_t)size;
+    if (!write_bytes(writer, src, size)) {
+        return false;
+    }
+
+    entry = writer->index + writer->count * PINO_BUNDLE_INDEX_SIZE;
+    pmemcpy_n2l(entry, &record_offset, sizeof(uint64_t));
+    pmemcpy_n2l(entry + 8, &record_size, sizeof(uint64_t));
+    pmemcpy(entry + 16, src, sizeof(pino_magic_t));
+    entry[16] &= (uint8_t)~COMPACT_MAGIC_BIT;
+    memset(entry + 20, 0, 4);
+    writer->count++;
+
+    return true;
+}
+
+extern bool pino_bundle_writer_add(pino_bundle_writer_t *writer, const pino_t *pino)
+{
+    if (!writer || writer->failed) {
+        return false;
+    }
+
+    pino_buffer_reset(&writer->scratch);
+    if (!pino_buffer_append(&writer->scratch, pino)) {
+        return false;
+    }
+
+    return pino_bundle_writer_add_raw(writer, writer->scratch.data, writer->scratch.size);
+}
+
+extern bool pino_bundle_writer_close(pino_bundle_writer_t *writer)
+{
+    uint8_t footer[PINO_BUNDLE_FOOTER_SIZE];
+    uint64_t index_offset, count;
+    uint32_t version = PINO_BUNDLE_VERSION;
+    bool result;
+
+    if (!writer) {
+        return false;
+    }
+
+    index_offset = writer->offset;
+    count = (uint64_t)writer->count;
+
+    pmemcpy_n2l(footer, &index_offset, sizeof(uint64_t));
+    pmemcpy_n2l(footer + 8, &count, sizeof(uint64_t));
+    pmemcpy_n2l(footer + 16, &version, sizeof(uint32_t));
+    pmemcpy(footer + 20, PINO_BUNDLE_MAGIC, 4);
+
+    result = !writer->failed && write_bytes(writer, writer->index, writer->count * PINO_BUNDLE_INDEX_SIZE) &&
+             write_bytes(writer, footer, sizeof(footer)) && fflush(writer->fp) == 0;
+
+    pfree(writer->index);
+    pino_buffer_free(&writer->scratch);
+    pfree(writer);
+
+    return result;
+}
+
+extern pino_bundle_t *pino_bundle_open(const void *data, size_t size)
+{
+    pino_bundle_t *bundle;
+    const uint8_t *footer;
+    uint64_t index_offset, count;
+    uint32_t version;
+
+    if (!data || size < PINO_BUNDLE_HEADER_SIZE + PINO_BUNDLE_FOOTER_SIZE) {
+        return NULL;
+    }
+
+    footer = (const uint8_t *)data + size - PINO_BUNDLE_FOOTER_SIZE;
+    if (pmemcmp(data, PINO_BUNDLE_MAGIC, 4) != 0 || pmemcmp(footer + 20, PINO_BUNDLE_MAGIC, 4) != 0) {
+        return NULL;
+    }
+
+    pmemcpy_l2n(&version, (const uint8_t *)data + 4, sizeof(uint32_t));
+    if (version != PINO_BUNDLE_VERSION) {
+        return NULL;
+    }
+
+    pmemcpy_l2n(&index_offset, footer, sizeof(uint64_t));
+    pmemcpy_l2n(&count, footer + 8, sizeof(uint64_t));
+
+    if (index_offset < PINO_BUNDLE_HEADER_SIZE || index_offset > size - PINO_BUNDLE_FOOTER_SIZE) {
+        return NULL;
+    }
+
+    if (count != (size - PINO_BUNDLE_FOOTER_SIZE - index_offset) / PINO_BUNDLE_INDEX_SIZE ||
+        (size - PINO_BUNDLE_FOOTER_SIZE - index_offset) % PINO_BUNDLE_INDEX_SIZE != 0) {
+        return NULL;
+    }
+
+    bundle = (pino_bundle_t *)pmalloc(sizeof(pino_bundle_t));
+    if (!bundle) {
+        return NULL;
+    }
+
+    bundle->data = (const uint8_t *)data;
+    bundle->index_offset = index_offset;
+    bundle->count = (size_t)count;
+
+    return bundle;
+}
+
+extern size_t pino_bundle_count(const pino_bundle_t *bundle)
+{
+    if (!bundle) {
+        return 0;
+    }
+
+    return bundle->count;
+}
+
+extern bool pino_bundle_record(const pino_bundle_t *bundle, size_t index, const void **data, size_t *size)
+{
+    const uint8_t *entry;
+    uint64_t record_offset, record_size;
+
+    if (!bundle || !data || !size || index >= bundle->count) {
+        return false;
+    }
+
+    entry = index_entry(bundle, index);
+    pmemcpy_l2n(&record_offset, entry, sizeof(uint64_t));
+    pmemcpy_l2n(&record_size, entry + 8, sizeof(uint64_t));
+
+    /* records must live between the header and the index */
+    if (record_offset < PINO_BUNDLE_HEADER_SIZE || record_offset > bundle->index_offset ||
+        record_size > bundle->index_offset - record_offset) {
+        return false;
+    }
+
+    *data = bundle->data + record_offset;
+    *size = (size_t)record_size;
+
+    return true;
+}
+
+extern bool pino_bundle_magic(const pino_bundle_t *bundle, size_t index, pino_magic_safe_t magic)
+{
+    if (!bundle || !magic || index >= bundle->count) {
+        return false;
+    }
+
+    pmemcpy(magic, index_entry(bundle, index) + 16, sizeof(pino_magic_t));
+    magic[sizeof(pino_magic_t)] = '\0';
+
+    return true;
+}
+
+extern size_t pino_bundle_find(const pino_bundle_t *bundle, size_t start, pino_magic_safe_t magic)
+{
+    const uint8_t *entry;
+    size_t i;
+
+    if (!bundle || !magic || start >= bundle->count) {
+        return pino_bundle_count(bundle);
+    }
+
+    /* only the index is scanned, the records themselves are never touched */
+    for (i = start, entry = index_entry(bundle, start); i < bundle->count; i++, entry += PINO_BUNDLE_INDEX_SIZE) {
+        if (pmemcmp(entry + 16, magic, sizeof(pino_magic_t)) == 0) {
+            return i;
+        }
+    }
+
+    return bundle->count;
+}
+
+extern pino_t *pino_bundle_get(const pino_bundle_t *bundle, size_t index)
+{
+    const void *data;
+    size_t size;
+
+    if (!pino_bundle_record(bundle, index, &data, &size)) {
+        return NULL;
+    }
+
+    return pino_unserialize(data, size);
+}
+
+extern void pino_bundle_close(pino_bundle_t *bundle)
+{
+    pfree(bundle);
+}
@@ -0,0 +1,99 @@
+/*
+ * libpino - cpu.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "internal/cpu.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPU_X86 1
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(CPU_X86)
+
+#define CPU_XCR0_AVX    0x06 /* XMM and YMM */
+#define CPU_XCR0_AVX512 0xE6 /* XMM, YMM, opmask and both ZMM halves */
+
+static inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+    int r[4];
+
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    regs[0] = (uint32_t)r[0];
+    regs[1] = (uint32_t)r[1];
+    regs[2] = (uint32_t)r[2];
+    regs[3] = (uint32_t)r[3];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static inline uint64_t xgetbv(void)
+{
+#if defined(_MSC_VER)
+    return (uint64_t)_xgetbv(0);
+#else
+    uint32_t lo, hi;
+
+    /* spelled out so the file needs no -mxsave */
+    __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(lo), "=d"(hi) : "c"(0));
+
+    return ((uint64_t)hi << 32) | lo;
+#endif
+}
+
+extern uint32_t pino_cpu_features(void)
+{
+    uint32_t regs[4], max_leaf, features = 0;
+    uint64_t xcr0 = 0;
+
+    cpuid(0, 0, regs);
+    max_leaf = regs[0];
+    if (max_leaf < 1) {
+        return 0;
+    }
+
+    cpuid(1, 0, regs);
+    if (regs[2] & (1U << 9)) {
+        features |= PINO_CPU_SSSE3;
+    }
+    if (regs[2] & (1U << 20)) {
+        features |= PINO_CPU_SSE42;
+    }
+
+    /* AVX state must be enabled by the OS as well, or the first ymm instruction faults */
+    if ((regs[2] & (1U << 27)) == 0 || (regs[2] & (1U << 28)) == 0 || max_leaf < 7) {
+        return features;
+    }
+    xcr0 = xgetbv();
+
+    cpuid(7, 0, regs);
+    if ((xcr0 & CPU_XCR0_AVX) == CPU_XCR0_AVX && (regs[1] & (1U << 5))) {
+        features |= PINO_CPU_AVX2;
+    }
+    if ((xcr0 & CPU_XCR0_AVX512) == CPU_XCR0_AVX512 && (regs[1] & (1U << 16)) && (regs[1] & (1U << 30))) {
+        features |= PINO_CPU_AVX512;
+    }
+
+    return features;
+}
+
+#else
+
+extern uint32_t pino_cpu_features(void)
+{
+    return 0;
+}
+
+#endif
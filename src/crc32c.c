@@ -0,0 +1,62 @@
+/*
+ * libpino - crc32c.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pino.h>
+
+#include "internal/common.h"
+#include "internal/cpu.h"
+#include "internal/crc32c.h"
+
+#define CRC32C_POLY 0x82F63B78
+
+uint32_t pino_crc32c_table[8][256];
+
+#if PINO_SIMD_DISPATCH
+static bool g_crc32c_sse42 = false;
+#endif
+
+extern void pino_crc32c_init(void)
+{
+    uint32_t crc;
+    size_t i, j;
+
+#if PINO_SIMD_DISPATCH
+    g_crc32c_sse42 = (pino_cpu_features() & PINO_CPU_SSE42) != 0;
+#endif
+
+    if (pino_crc32c_table[0][1] != 0) {
+        return;
+    }
+
+    for (i = 0; i < 256; i++) {
+        crc = (uint32_t)i;
+        for (j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ (CRC32C_POLY & (0U - (crc & 1)));
+        }
+        pino_crc32c_table[0][i] = crc;
+    }
+
+    for (i = 0; i < 256; i++) {
+        for (j = 1; j < 8; j++) {
+            pino_crc32c_table[j][i] =
+                (pino_crc32c_table[j - 1][i] >> 8) ^ pino_crc32c_table[0][pino_crc32c_table[j - 1][i] & 0xFF];
+        }
+    }
+}
+
+extern uint32_t pino_crc32c(uint32_t crc, const void *data, size_t size)
+{
+#if PINO_SIMD_DISPATCH
+    if (g_crc32c_sse42) {
+        return pino_crc32c_sse42(crc, data, size);
+    }
+#endif
+
+    return pino_crc32c_update(crc, data, size);
+}
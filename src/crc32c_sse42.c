@@ -0,0 +1,24 @@
+/*
+ * libpino - crc32c_sse42.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+/* MSVC has no per file -msse4.2, the intrinsics are always available there */
+#if defined(_MSC_VER)
+#define PINO_CRC32C_FORCE_SSE42 1
+#endif
+
+#include "internal/crc32c.h"
+
+#if PINO_SIMD_DISPATCH
+
+extern uint32_t pino_crc32c_sse42(uint32_t crc, const void *data, size_t size)
+{
+    return pino_crc32c_update(crc, data, size);
+}
+
+#endif
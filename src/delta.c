@@ -0,0 +1,290 @@
+/*
+ * libpino - delta.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pino.h>
+#include <pino/buffer.h>
+#include <pino/delta.h>
+#include <pino/handler.h>
+
+#include "internal/common.h"
+#include "internal/crc32c.h"
+
+#if PINO_USE_SIMD
+#include "internal/simd.h"
+#endif
+
+/* an unchanged gap shorter than this costs more as a new op than as literals */
+#define DELTA_MIN_GAP 4
+
+/* records may use the compact header, which marks the first magic byte */
+static inline bool same_magic(const uint8_t *record, const uint8_t *magic)
+{
+    return (uint8_t)(record[0] & ~COMPACT_MAGIC_BIT) == (uint8_t)(magic[0] & ~COMPACT_MAGIC_BIT) &&
+           pmemcmp(record + 1, magic + 1, sizeof(pino_magic_t) - 1) == 0;
+}
+
+/* number of leading bytes that are equal */
+static inline size_t equal_prefix(const uint8_t *a, const uint8_t *b, size_t size)
+{
+    uint64_t wa, wb;
+    size_t i = 0;
+#if PINO_USE_SIMD && defined(PINO_SIMD_SSE2)
+    __m128i va, vb;
+
+    for (; i + 16 <= size; i += 16) {
+        va = _mm_loadu_si128((const __m128i *)(a + i));
+        vb = _mm_loadu_si128((const __m128i *)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF) {
+            break;
+        }
+    }
+#elif PINO_USE_SIMD && defined(PINO_SIMD_NEON)
+    uint8x16_t eq;
+
+    for (; i + 16 <= size; i += 16) {
+        eq = vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        if (vminvq_u8(eq) != 0xFF) {
+            break;
+        }
+    }
+#elif PINO_USE_SIMD && defined(PINO_SIMD_WASM)
+    for (; i + 16 <= size; i += 16) {
+        if (!wasm_i8x16_all_true(wasm_i8x16_eq(wasm_v128_load(a + i), wasm_v128_load(b + i)))) {
+            break;
+        }
+    }
+#endif
+
+    for (; i + 8 <= size; i += 8) {
+        pmemcpy(&wa, a + i, sizeof(uint64_t));
+        pmemcpy(&wb, b + i, sizeof(uint64_t));
+        if (wa != wb) {
+            break;
+        }
+    }
+
+    while (i < size && a[i] == b[i]) {
+        i++;
+    }
+
+    return i;
+}
+
+/* number of leading bytes that differ */
+static inline size_t changed_prefix(const uint8_t *a, const uint8_t *b, size_t size)
+{
+    size_t i = 0;
+#if PINO_USE_SIMD && defined(PINO_SIMD_SSE2)
+    __m128i va, vb;
+
+    for (; i + 16 <= size; i += 16) {
+        va = _mm_loadu_si128((const __m128i *)(a + i));
+        vb = _mm_loadu_si128((const __m128i *)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0) {
+            break;
+        }
+    }
+#elif PINO_USE_SIMD && defined(PINO_SIMD_NEON)
+    for (; i + 16 <= size; i += 16) {
+        if (vmaxvq_u8(vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i))) != 0) {
+            break;
+        }
+    }
+#elif PINO_USE_SIMD && defined(PINO_SIMD_WASM)
+    for (; i + 16 <= size; i += 16) {
+        if (wasm_v128_any_true(wasm_i8x16_eq(wasm_v128_load(a + i), wasm_v128_load(b + i)))) {
+            break;
+        }
+    }
+#endif
+
+    while (i < size && a[i] != b[i]) {
+        i++;
+    }
+
+    return i;
+}
+
+/* end of the changed range starting at start, short unchanged gaps are absorbed */
+static inline size_t changed_end(const uint8_t *target, size_t target_size, const uint8_t *reference, size_t common,
+                                 size_t start)
+{
+    size_t end = start, equal;
+
+    while (end < common) {
+        end += changed_prefix(target + end, reference + end, common - end);
+        if (end >= common) {
+            break;
+        }
+
+        equal = equal_prefix(target + end, reference + end, common - end);
+        if (equal >= DELTA_MIN_GAP || end + equal == target_size) {
+            return end;
+        }
+        end += equal;
+    }
+
+    /* everything past the reference is new */
+    return target_size;
+}
+
+extern bool pino_serialize_delta(const pino_t *pino, const void *reference, size_t reference_size,
+                                 pino_buffer_t *buffer)
+{
+    const uint8_t *ref = (const uint8_t *)reference;
+    uint8_t header[sizeof(pino_magic_t) + VARINT_MAX_SIZE + CRC32C_SIZE];
+    size_t base, target_size, common, delta_base, header_size, pos, start, end;
+    uint32_t crc;
+
+    if (!pino || !ref || reference_size < HEADER_MIN_SIZE || !buffer) {
+        return false;
+    }
+
+    if (!same_magic(ref, (const uint8_t *)pino->magic)) {
+        return false;
+    }
+
+    /* the target is serialized into the buffer and the ops are appended after it */
+    base = buffer->size;
+    if (!pino_buffer_append(buffer, pino)) {
+        return false;
+    }
+
+    target_size = buffer->size - base;
+    common = target_size < reference_size ? target_size : reference_size;
+
+    crc = pino_crc32c(0, ref, reference_size);
+    pmemcpy(header, pino->magic, sizeof(pino_magic_t));
+    header_size = sizeof(pino_magic_t) + varint_write(header + sizeof(pino_magic_t), (uint64_t)target_size);
+    pmemcpy_n2l(header + header_size, &crc, sizeof(uint32_t));
+    header_size += CRC32C_SIZE;
+
+    delta_base = buffer->size;
+    if (!pino_buffer_append_bytes(buffer, header, header_size)) {
+        buffer->size = base;
+        return false;
+    }
+
+    for (pos = 0; pos < target_size; pos = end) {
+        start = pos + (pos < common ? equal_prefix(buffer->data + base + pos, ref + pos, common - pos) : 0);
+        if (start >= target_size) {
+            break;
+        }
+
+        end = changed_end(buffer->data + base, target_size, ref, common, start);
+
+        /* offsets stay valid when the buffer moves */
+        if (!pino_buffer_reserve(buffer, VARINT_MAX_SIZE * 2 + (end - start))) {
+            buffer->size = base;
+            return false;
+        }
+
+        buffer->size += varint_write(buffer->data + buffer->size, (uint64_t)(start - pos));
+        buffer->size += varint_write(buffer->data + buffer->size, (uint64_t)(end - start));
+        pmemcpy(buffer->data + buffer->size, buffer->data + base + start, end - start);
+        buffer->size += end - start;
+    }
+
+    pmemmove(buffer->data + base, buffer->data + delta_base, buffer->size - delta_base);
+    buffer->size = base + (buffer->size - delta_base);
+
+    return true;
+}
+
+extern bool pino_delta_apply(const void *reference, size_t reference_size, const void *delta, size_t delta_size,
+                             pino_buffer_t *buffer)
+{
+    const uint8_t *ref = (const uint8_t *)reference, *p, *end;
+    uint8_t *out;
+    uint64_t target_size, unchanged, changed, pos;
+    uint32_t crc;
+
+    if (!ref || reference_size < HEADER_MIN_SIZE || !delta || delta_size < PINO_DELTA_MIN_HEADER_SIZE || !buffer) {
+        return false;
+    }
+
+    p = (const uint8_t *)delta;
+    end = p + delta_size;
+
+    if (!same_magic(ref, p)) {
+        return false;
+    }
+    p += sizeof(pino_magic_t);
+
+    if (!varint_read(&p, end, &target_size) || (size_t)(end - p) < CRC32C_SIZE) {
+        return false;
+    }
+
+    pmemcpy_l2n(&crc, p, sizeof(uint32_t));
+    p += CRC32C_SIZE;
+
+    /* applying a delta to any other reference would silently produce garbage */
+    if (crc != pino_crc32c(0, ref, reference_size)) {
+        return false;
+    }
+
+    /* every byte comes from either the reference or the delta */
+    if (target_size > (uint64_t)reference_size + (uint64_t)(end - p) || target_size > SIZE_MAX - buffer->size) {
+        return false;
+    }
+
+    if (!pino_buffer_reserve(buffer, (size_t)target_size)) {
+        return false;
+    }
+
+    out = buffer->data + buffer->size;
+    pos = 0;
+    while (p < end) {
+        if (!varint_read(&p, end, &unchanged) || !varint_read(&p, end, &changed)) {
+            return false;
+        }
+
+        if (unchanged > target_size - pos ||
+            (unchanged > 0 && (pos > reference_size || unchanged > reference_size - pos)) ||
+            changed > target_size - pos - unchanged || changed > (uint64_t)(end - p)) {
+            return false;
+        }
+
+        pmemcpy(out + pos, ref + pos, (size_t)unchanged);
+        pos += unchanged;
+        pmemcpy(out + pos, p, (size_t)changed);
+        pos += changed;
+        p += changed;
+    }
+
+    /* the rest is unchanged */
+    if (pos < target_size && (pos > reference_size || target_size - pos > reference_size - pos)) {
+        return false;
+    }
+
+    pmemcpy(out + pos, ref + pos, (size_t)(target_size - pos));
+    buffer->size += (size_t)target_size;
+
+    return true;
+}
+
+extern pino_t *pino_unserialize_delta(const void *reference, size_t reference_size, const void *delta,
+                                      size_t delta_size)
+{
+    pino_buffer_t buffer;
+    pino_t *pino;
+
+    if (!pino_buffer_init(&buffer, 0)) {
+        return NULL;
+    }
+
+    pino = NULL;
+    if (pino_delta_apply(reference, reference_size, delta, delta_size, &buffer)) {
+        pino = pino_unserialize(buffer.data, buffer.size);
+    }
+
+    pino_buffer_free(&buffer);
+
+    return pino;
+}
@@ -0,0 +1,286 @@
+/*
+ * libpino - dictionary.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pino.h>
+#include <pino/dictionary.h>
+#include <pino/handler.h>
+
+#include "internal/common.h"
+#include "internal/lz.h"
+
+#define TRAIN_KMER     6
+#define TRAIN_SEGMENT  32
+#define TRAIN_HASH_LOG 16
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint8_t *owned;
+} sample_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t sample;
+    size_t offset;
+    uint64_t score;
+} segment_t;
+
+static inline uint32_t kmer_hash(const uint8_t *p)
+{
+    uint64_t v = 0;
+
+    pmemcpy(&v, p, TRAIN_KMER);
+
+    return (uint32_t)((v * UINT64_C(0x9E3779B185EBCA87)) >> (64 - TRAIN_HASH_LOG));
+}
+
+static inline uint64_t segment_score(const segment_t *segment, const uint32_t *counts)
+{
+    uint64_t score = 0;
+    size_t i;
+
+    /* only k-mers shared by at least two samples are worth keeping */
+    for (i = 0; i + TRAIN_KMER <= segment->size; i++) {
+        if (counts[kmer_hash(segment->data + i)] > 1) {
+            score += counts[kmer_hash(segment->data + i)];
+        }
+    }
+
+    return score;
+}
+
+static int compare_segments(const void *a, const void *b)
+{
+    const segment_t *sa = (const segment_t *)a, *sb = (const segment_t *)b;
+
+    if (sa->score != sb->score) {
+        return sa->score < sb->score ? 1 : -1;
+    }
+
+    /* ties keep sample order so the dictionary does not depend on where the samples live */
+    if (sa->sample != sb->sample) {
+        return sa->sample < sb->sample ? -1 : 1;
+    }
+
+    return sa->offset < sb->offset ? -1 : (sa->offset > sb->offset);
+}
+
+static inline bool load_samples(const handler_entry_t *entry, const void *const *samples, const size_t *sizes,
+                                size_t count, sample_t *loaded)
+{
+    pino_peek_info_t info;
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        if (!pino_peek(samples[i], sizes[i], &info) || !magic_equal((char *)entry->magic, info.magic)) {
+            return false;
+        }
+
+        if (!pino_payload_decode(entry, &info, samples[i], &loaded[i].owned)) {
+            return false;
+        }
+
+        loaded[i].data = loaded[i].owned ? loaded[i].owned : (const uint8_t *)samples[i] + info.payload_offset;
+        loaded[i].size = info.raw_payload_size;
+    }
+
+    return true;
+}
+
+static inline size_t build_dictionary(const sample_t *loaded, size_t count, uint8_t *dest, size_t capacity)
+{
+    segment_t *segments = NULL, **picked = NULL;
+    uint32_t *counts = NULL;
+    size_t *seen = NULL, segment_count, picked_count, total, i, j, offset;
+    uint32_t h;
+
+    segment_count = 0;
+    for (i = 0; i < count; i++) {
+        segment_count += (loaded[i].size + TRAIN_SEGMENT - 1) / TRAIN_SEGMENT;
+    }
+
+    counts = (uint32_t *)pcalloc((size_t)1 << TRAIN_HASH_LOG, sizeof(uint32_t));
+    seen = (size_t *)pcalloc((size_t)1 << TRAIN_HASH_LOG, sizeof(size_t));
+    segments = (segment_t *)pmalloc((segment_count > 0 ? segment_count : 1) * sizeof(segment_t));
+    picked = (segment_t **)pmalloc((segment_count > 0 ? segment_count : 1) * sizeof(segment_t *));
+    total = 0;
+    if (!counts || !seen || !segments || !picked) {
+        goto done;
+    }
+
+    /* document frequency of every k-mer, each sample counts once */
+    for (i = 0; i < count; i++) {
+        for (j = 0; j + TRAIN_KMER <= loaded[i].size; j++) {
+            h = kmer_hash(loaded[i].data + j);
+            if (seen[h] != i + 1) {
+                seen[h] = i + 1;
+                counts[h]++;
+            }
+        }
+    }
+
+    segment_count = 0;
+    for (i = 0; i < count; i++) {
+        for (offset = 0; offset < loaded[i].size; offset += TRAIN_SEGMENT) {
+            segments[segment_count].data = loaded[i].data + offset;
+            segments[segment_count].sample = i;
+            segments[segment_count].offset = offset;
+            segments[segment_count].size =
+                loaded[i].size - offset < TRAIN_SEGMENT ? loaded[i].size - offset : TRAIN_SEGMENT;
+            segments[segment_count].score = segment_score(&segments[segment_count], counts);
+            if (segments[segment_count].score > 0) {
+                segment_count++;
+            }
+        }
+    }
+
+    qsort(segments, segment_count, sizeof(segment_t), compare_segments);
+
+    /* greedy cover: once a segment is taken its k-mers no longer count for the rest */
+    picked_count = 0;
+    for (i = 0; i < segment_count && total < capacity; i++) {
+        if (segments[i].size > capacity - total || segment_score(&segments[i], counts) == 0) {
+            continue;
+        }
+
+        for (j = 0; j + TRAIN_KMER <= segments[i].size; j++) {
+            counts[kmer_hash(segments[i].data + j)] = 0;
+        }
+
+        picked[picked_count++] = &segments[i];
+        total += segments[i].size;
+    }
+
+    /* the most valuable content goes last, closest to the data */
+    offset = 0;
+    while (picked_count-- > 0) {
+        pmemcpy(dest + offset, picked[picked_count]->data, picked[picked_count]->size);
+        offset += picked[picked_count]->size;
+    }
+
+done:
+    pfree(counts);
+    pfree(seen);
+    pfree(segments);
+    pfree(picked);
+
+    return total;
+}
+
+extern size_t pino_dictionary_train(pino_magic_safe_t magic, const void *const *samples, const size_t *sizes,
+                                    size_t count, void *dest, size_t capacity)
+{
+    handler_entry_t *entry;
+    sample_t *loaded;
+    size_t i, size;
+
+    if (!samples || !sizes || count == 0 || !dest || capacity == 0) {
+        return 0;
+    }
+
+    entry = pino_handler_find_entry(magic);
+    if (!entry) {
+        return 0;
+    }
+
+    if (capacity > PINO_DICTIONARY_MAX_SIZE) {
+        capacity = PINO_DICTIONARY_MAX_SIZE;
+    }
+
+    loaded = (sample_t *)pcalloc(count, sizeof(sample_t));
+    if (!loaded) {
+        return 0;
+    }
+
+    size = load_samples(entry, samples, sizes, count, loaded) ? build_dictionary(loaded, count, dest, capacity) : 0;
+
+    for (i = 0; i < count; i++) {
+        pfree(loaded[i].owned);
+    }
+    pfree(loaded);
+
+    return size;
+}
+
+extern bool pino_dictionary_register(pino_magic_safe_t magic, uint16_t id, const void *dict, size_t size)
+{
+    handler_entry_t *entry;
+    dictionary_t *dictionary;
+
+    if (!dict || size == 0 || size > PINO_DICTIONARY_MAX_SIZE) {
+        return false;
+    }
+
+    entry = pino_handler_find_entry(magic);
+    if (!entry) {
+        return false;
+    }
+
+    /* ids are immutable so records written with an older dictionary stay decodable */
+    if (pino_dictionary_find(entry, id)) {
+        return false;
+    }
+
+    dictionary = (dictionary_t *)pmalloc(sizeof(dictionary_t) + size);
+    if (!dictionary) {
+        return false;
+    }
+
+    dictionary->table = (size_t *)pmalloc(sizeof(size_t) * LZ_DICT_TABLE_LEN);
+    if (!dictionary->table) {
+        pfree(dictionary);
+        return false;
+    }
+
+    dictionary->id = id;
+    dictionary->size = size;
+    pmemcpy(dictionary->data, dict, size);
+    pino_lz_prepare_dict(dictionary->data, size, dictionary->table);
+
+    dictionary->next = entry->dictionaries;
+    entry->dictionaries = dictionary;
+    entry->generation++;
+
+    return true;
+}
+
+extern const dictionary_t *pino_dictionary_find(const handler_entry_t *entry, uint16_t id)
+{
+    const dictionary_t *dictionary;
+
+    if (!entry) {
+        return NULL;
+    }
+
+    for (dictionary = entry->dictionaries; dictionary; dictionary = dictionary->next) {
+        if (dictionary->id == id) {
+            return dictionary;
+        }
+    }
+
+    return NULL;
+}
+
+extern void pino_dictionary_free_all(handler_entry_t *entry)
+{
+    dictionary_t *dictionary, *next;
+
+    if (!entry) {
+        return;
+    }
+
+    for (dictionary = entry->dictionaries; dictionary; dictionary = next) {
+        next = dictionary->next;
+        pfree(dictionary->table);
+        pfree(dictionary);
+    }
+
+    entry->dictionaries = NULL;
+}
@@ -162,3 +162,22 @@ extern int pino_endianness_memcmp_native2be(const void *s1, const void *s2, size
 {
     return memcmp_common(s1, s2, size, elem_size, (platform_endianness() == ENDIANNESS_BIG));
 }
+
+extern uint32_t pino_endianness_memcpy_native2le_crc32c(void *dest, const void *src, size_t size, size_t elem_size,
+                                                        uint32_t state)
+{
+    return pino_bswap_memcpy_crc32c(
+        dest, src, size, platform_endianness() == ENDIANNESS_LITTLE ? 1 : normalize_elem_size(elem_size), state);
+}
+
+extern uint32_t pino_endianness_memcpy_native2be_crc32c(void *dest, const void *src, size_t size, size_t elem_size,
+                                                        uint32_t state)
+{
+    return pino_bswap_memcpy_crc32c(
+        dest, src, size, platform_endianness() == ENDIANNESS_BIG ? 1 : normalize_elem_size(elem_size), state);
+}
+
+extern bool pino_endianness_is_big(void)
+{
+    return platform_endianness() == ENDIANNESS_BIG;
+}
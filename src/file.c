@@ -0,0 +1,237 @@
+/*
+ * libpino - file.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+
+#include <pino.h>
+#include <pino/bundle.h>
+#include <pino/file.h>
+#include <pino/handler.h>
+
+#include "internal/common.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PINO_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define PINO_FILE_MMAP 0
+#endif
+
+struct _pino_file_t {
+    void *data;
+    size_t size;
+    bool mapped;
+    bool bundle_checked;
+    pino_bundle_t *bundle;
+};
+
+#if PINO_FILE_MMAP
+static inline bool map_file(pino_file_t *file, const char *path)
+{
+    struct stat st;
+    void *data;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (fstat(fd, &st) != 0 || st.st_size < 0 || (uint64_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        return false;
+    }
+
+    file->size = (size_t)st.st_size;
+    if (file->size == 0) {
+        close(fd);
+        return true;
+    }
+
+    data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    file->data = data;
+    file->mapped = true;
+
+    return true;
+}
+#else
+static inline bool map_file(pino_file_t *file, const char *path)
+{
+    FILE *fp;
+    long size;
+
+    fp = fopen(path, "rb");
+    if (!fp) {
+        return false;
+    }
+
+    if (fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return false;
+    }
+
+    file->size = (size_t)size;
+    if (file->size > 0) {
+        file->data = pmalloc(file->size);
+        if (!file->data || fread(file->data, 1, file->size, fp) != file->size) {
+            pfree(file->data);
+            file->data = NULL;
+            fclose(fp);
+            return false;
+        }
+    }
+
+    fclose(fp);
+
+    return true;
+}
+#endif
+
+extern pino_file_t *pino_file_open(const char *path)
+{
+    pino_file_t *file;
+
+    if (!path) {
+        return NULL;
+    }
+
+    file = (pino_file_t *)pcalloc(1, sizeof(pino_file_t));
+    if (!file) {
+        return NULL;
+    }
+
+    if (!map_file(file, path)) {
+        pfree(file);
+        return NULL;
+    }
+
+    return file;
+}
+
+extern bool pino_file_advise(pino_file_t *file, pino_file_advice_t advice)
+{
+#if PINO_FILE_MMAP
+    int flag;
+#endif
+
+    if (!file) {
+        return false;
+    }
+
+#if PINO_FILE_MMAP
+    if (!file->mapped) {
+        return true;
+    }
+
+    switch (advice) {
+    case PINO_FILE_ADVICE_SEQUENTIAL:
+        flag = MADV_SEQUENTIAL;
+        break;
+    case PINO_FILE_ADVICE_RANDOM:
+        flag = MADV_RANDOM;
+        break;
+    case PINO_FILE_ADVICE_WILLNEED:
+        flag = MADV_WILLNEED;
+        break;
+    case PINO_FILE_ADVICE_NORMAL:
+        flag = MADV_NORMAL;
+        break;
+    default:
+        return false;
+    }
+
+    return madvise(file->data, file->size, flag) == 0;
+#else
+    (void)advice;
+
+    return true;
+#endif
+}
+
+extern const void *pino_file_data(const pino_file_t *file)
+{
+    if (!file) {
+        return NULL;
+    }
+
+    return file->data;
+}
+
+extern size_t pino_file_size(const pino_file_t *file)
+{
+    if (!file) {
+        return 0;
+    }
+
+    return file->size;
+}
+
+extern bool pino_file_view(const pino_file_t *file, size_t offset, size_t size, const void **data)
+{
+    if (!file || !data || offset > file->size || size > file->size - offset) {
+        return false;
+    }
+
+    *data = (const uint8_t *)file->data + offset;
+
+    return true;
+}
+
+extern pino_t *pino_file_unserialize(const pino_file_t *file, size_t offset, size_t size)
+{
+    const void *data;
+
+    if (!pino_file_view(file, offset, size, &data)) {
+        return NULL;
+    }
+
+    return pino_unserialize(data, size);
+}
+
+extern pino_bundle_t *pino_file_bundle(pino_file_t *file)
+{
+    if (!file) {
+        return NULL;
+    }
+
+    /* the footer is validated on first use only */
+    if (!file->bundle_checked) {
+        file->bundle = pino_bundle_open(file->data, file->size);
+        file->bundle_checked = true;
+    }
+
+    return file->bundle;
+}
+
+extern void pino_file_close(pino_file_t *file)
+{
+    if (!file) {
+        return;
+    }
+
+    pino_bundle_close(file->bundle);
+
+#if PINO_FILE_MMAP
+    if (file->mapped) {
+        munmap(file->data, file->size);
+    }
+#else
+    pfree(file->data);
+#endif
+
+    pfree(file);
+}
@@ -17,9 +17,61 @@ static struct {
     size_t capacity;
     size_t usage;
     handler_entry_t **entries;
+    size_t index_mask;
+    handler_entry_t **index;
 } g_handlers;
 
 static void *g_handler_context_entry;
+static checksum_context_t *g_handler_checksum_context;
+static bool g_handler_big_endian;
+
+static inline size_t index_slot(uint32_t key)
+{
+    return (size_t)((key * UINT32_C(0x9E3779B1)) >> 7) & g_handlers.index_mask;
+}
+
+/* open addressing index keyed by the 4 magic bytes, rebuilt on every registry change */
+static inline bool rebuild_index(void)
+{
+    handler_entry_t **index;
+    size_t i, slot, index_capacity;
+
+    index_capacity = g_handlers.index ? g_handlers.index_mask + 1 : HANDLER_STEP;
+    while (index_capacity < g_handlers.usage * 2) {
+        if (index_capacity > SIZE_MAX / 2 / sizeof(handler_entry_t *)) {
+            return false;
+        }
+        index_capacity *= 2;
+    }
+
+    /* the index never shrinks, so removals never allocate */
+    if (g_handlers.index && g_handlers.index_mask + 1 == index_capacity) {
+        index = g_handlers.index;
+        memset(index, 0, index_capacity * sizeof(handler_entry_t *));
+    } else {
+        index = (handler_entry_t **)pcalloc(index_capacity, sizeof(handler_entry_t *));
+        if (!index) {
+            return false;
+        }
+
+        pfree(g_handlers.index);
+    }
+
+    g_handlers.index = index;
+    g_handlers.index_mask = index_capacity - 1;
+
+    for (i = 0; i < g_handlers.capacity; i++) {
+        if (g_handlers.entries[i]) {
+            slot = index_slot(g_handlers.entries[i]->key);
+            while (index[slot]) {
+                slot = (slot + 1) & g_handlers.index_mask;
+            }
+            index[slot] = g_handlers.entries[i];
+        }
+    }
+
+    return true;
+}
 
 static inline handler_entry_t *find_replacement_entry(handler_entry_t *entry)
 {
@@ -53,6 +105,7 @@ static inline void free_entry(handler_entry_t *entry)
     }
 
     pino_memory_manager_obj_free(&entry->mm);
+    pino_dictionary_free_all(entry);
     pfree(entry);
 }
 
@@ -109,6 +162,12 @@ extern bool pino_handler_init(size_t initialize_size)
 
     g_handlers.entries = ents;
 
+    if (!rebuild_index()) {
+        pfree(ents);
+        g_handlers.entries = NULL;
+        return false;
+    }
+
     return g_handlers.initialized = true;
 }
 
@@ -127,6 +186,66 @@ extern void *pino_handler_context_resolve(void *entry)
     return g_handler_context_entry ? g_handler_context_entry : entry;
 }
 
+extern checksum_context_t *pino_handler_checksum_set(checksum_context_t *context)
+{
+    checksum_context_t *previous;
+
+    previous = g_handler_checksum_context;
+    g_handler_checksum_context = context;
+
+    return previous;
+}
+
+extern bool pino_handler_big_endian_set(bool big_endian)
+{
+    bool previous;
+
+    previous = g_handler_big_endian;
+    g_handler_big_endian = big_endian;
+
+    return previous;
+}
+
+static inline void *serialize_data(void *dest, const void *src, size_t size, size_t elem_size, bool big_endian)
+{
+    checksum_context_t *context = g_handler_checksum_context;
+
+    if (!context || !context->next || (uint8_t *)dest > context->next) {
+        /* gaps are covered by the final pass over the rest of the record */
+        return big_endian ? pino_endianness_memcpy_native2be(dest, src, size, elem_size)
+                          : pino_endianness_memcpy_native2le(dest, src, size, elem_size);
+    }
+
+    if ((uint8_t *)dest < context->next) {
+        /* already covered bytes are rewritten, the whole record is hashed again */
+        context->next = NULL;
+        return big_endian ? pino_endianness_memcpy_native2be(dest, src, size, elem_size)
+                          : pino_endianness_memcpy_native2le(dest, src, size, elem_size);
+    }
+
+    context->state = big_endian ? pino_endianness_memcpy_native2be_crc32c(dest, src, size, elem_size, context->state)
+                                : pino_endianness_memcpy_native2le_crc32c(dest, src, size, elem_size, context->state);
+    context->next += size;
+
+    return dest;
+}
+
+extern void *pino_handler_serialize_data_checked(void *dest, const void *src, size_t size, size_t elem_size)
+{
+    return serialize_data(dest, src, size, elem_size, false);
+}
+
+extern void *pino_handler_serialize_data_ordered(void *dest, const void *src, size_t size, size_t elem_size)
+{
+    return serialize_data(dest, src, size, elem_size, g_handler_big_endian);
+}
+
+extern void *pino_handler_unserialize_data_ordered(void *dest, const void *src, size_t size, size_t elem_size)
+{
+    return g_handler_big_endian ? pino_endianness_memcpy_be2native(dest, src, size, elem_size)
+                                : pino_endianness_memcpy_le2native(dest, src, size, elem_size);
+}
+
 extern void pino_handler_free(void)
 {
     size_t i;
@@ -149,8 +268,11 @@ extern void pino_handler_free(void)
     }
 
     pfree(g_handlers.entries);
+    pfree(g_handlers.index);
 
     g_handlers.entries = NULL;
+    g_handlers.index = NULL;
+    g_handlers.index_mask = 0;
     g_handlers.capacity = 0;
     g_handlers.usage = 0;
     g_handlers.initialized = false;
@@ -174,6 +296,11 @@ extern bool pino_handler_register(pino_magic_safe_t magic, pino_handler_t *handl
         return false;
     }
 
+    if (handler->payload_alignment > PINO_PAYLOAD_ALIGNMENT_MAX ||
+        (handler->payload_alignment & (handler->payload_alignment - 1)) != 0) {
+        return false;
+    }
+
     if (pino_handler_find_entry(magic)) {
         return false;
     }
@@ -199,9 +326,16 @@ extern bool pino_handler_register(pino_magic_safe_t magic, pino_handler_t *handl
     }
 
     pmemcpy(entry->magic, magic, sizeof(pino_magic_t));
+    entry->key = magic_key(magic);
     entry->handler = handler;
+    entry->flags = 0;
+    entry->generation = 0;
+    entry->dictionaries = NULL;
     entry->refcount = 0;
     entry->unregistered = false;
+#if PINO_STATS
+    entry->stats_slot = pino_stats_slot(entry->magic);
+#endif
     handler->entry = entry;
 
     for (i = 0; i < g_handlers.capacity; i++) {
@@ -209,6 +343,12 @@ extern bool pino_handler_register(pino_magic_safe_t magic, pino_handler_t *handl
             g_handlers.entries[i] = entry;
             ++g_handlers.usage;
 
+            if (!rebuild_index()) {
+                g_handlers.entries[i] = NULL;
+                --g_handlers.usage;
+                break;
+            }
+
             return true;
         }
     }
@@ -243,6 +383,8 @@ extern bool pino_handler_unregister(pino_magic_safe_t magic)
                 free_entry(entry);
             }
 
+            rebuild_index();
+
             return true;
         }
     }
@@ -250,18 +392,54 @@ extern bool pino_handler_unregister(pino_magic_safe_t magic)
     return false;
 }
 
+extern bool pino_handler_set_flags(pino_magic_safe_t magic, uint32_t flags)
+{
+    handler_entry_t *entry;
+
+    if (flags & ~HANDLER_FLAGS_KNOWN) {
+        return false;
+    }
+
+    entry = pino_handler_find_entry(magic);
+    if (!entry) {
+        return false;
+    }
+
+    entry->flags = flags;
+    entry->generation++;
+
+    return true;
+}
+
+extern uint32_t pino_handler_get_flags(pino_magic_safe_t magic)
+{
+    handler_entry_t *entry;
+
+    entry = pino_handler_find_entry(magic);
+    if (!entry) {
+        return 0;
+    }
+
+    return entry->flags;
+}
+
 extern handler_entry_t *pino_handler_find_entry(pino_magic_safe_t magic)
 {
-    size_t i;
+    handler_entry_t *entry;
+    uint32_t key;
+    size_t slot;
 
-    if (!g_handlers.initialized) {
+    if (!g_handlers.initialized || !magic) {
         return NULL;
     }
 
-    for (i = 0; i < g_handlers.capacity; i++) {
-        if (g_handlers.entries[i] && magic_equal(g_handlers.entries[i]->magic, magic)) {
-            return g_handlers.entries[i];
+    key = magic_key(magic);
+    slot = index_slot(key);
+    while ((entry = g_handlers.index[slot]) != NULL) {
+        if (entry->key == key) {
+            return entry;
         }
+        slot = (slot + 1) & g_handlers.index_mask;
     }
 
     return NULL;
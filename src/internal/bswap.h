@@ -14,13 +14,47 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <pino/endianness.h>
 #include <pino/portable.h>
 
+#include "crc32c.h"
+
 #if PINO_USE_SIMD
 #include "simd.h"
 #endif
 
-static inline void *pino_bswap_memcpy(void *dest, const void *src, size_t size, size_t elem_size)
+/* below this the inline kernel wins, a vector kernel would spend its time on the call and the tail */
+#define PINO_BSWAP_DISPATCH_MIN 32
+
+typedef void *(*pino_bswap_memcpy_fn_t)(void *dest, const void *src, size_t size, size_t elem_size);
+typedef uint32_t (*pino_bswap_memcpy_crc32c_fn_t)(void *dest, const void *src, size_t size, size_t elem_size,
+                                                  uint32_t state);
+
+typedef struct {
+    pino_bswap_kernel_t kernel;
+    pino_bswap_memcpy_fn_t copy;
+    pino_bswap_memcpy_crc32c_fn_t copy_crc32c;
+} pino_bswap_kernels_t;
+
+/* the scalar kernels until pino_bswap_init() has looked at the CPU */
+extern pino_bswap_kernels_t pino_bswap_kernels;
+
+void pino_bswap_init(void);
+const pino_bswap_kernels_t *pino_bswap_kernels_find(pino_bswap_kernel_t kernel);
+
+/* each one lives in its own translation unit, built with only the flags it needs */
+void *pino_bswap_memcpy_scalar(void *dest, const void *src, size_t size, size_t elem_size);
+uint32_t pino_bswap_memcpy_crc32c_scalar(void *dest, const void *src, size_t size, size_t elem_size, uint32_t state);
+#if PINO_SIMD_DISPATCH
+void *pino_bswap_memcpy_ssse3(void *dest, const void *src, size_t size, size_t elem_size);
+void *pino_bswap_memcpy_avx2(void *dest, const void *src, size_t size, size_t elem_size);
+uint32_t pino_bswap_memcpy_crc32c_avx2(void *dest, const void *src, size_t size, size_t elem_size, uint32_t state);
+#if PINO_SIMD_AVX512
+void *pino_bswap_memcpy_avx512(void *dest, const void *src, size_t size, size_t elem_size);
+#endif
+#endif
+
+static inline void *pino_bswap_memcpy_generic(void *dest, const void *src, size_t size, size_t elem_size)
 {
     const uint8_t *sp;
     uint64_t *dest64, *src64;
@@ -29,97 +63,7 @@ static inline void *pino_bswap_memcpy(void *dest, const void *src, size_t size,
     uint8_t *dp;
     size_t i, j, num_elements;
 
-#if PINO_USE_SIMD && defined(PINO_SIMD_AVX2)
-    __m256i shuffle_mask, data;
-    size_t simd_elements;
-
-    dp = (uint8_t *)dest;
-    sp = (const uint8_t *)src;
-
-    if (elem_size == 1 || size == 0) {
-        return memcpy(dest, src, size);
-    }
-
-    if (size % elem_size != 0) {
-        return memcpy(dest, src, size);
-    }
-
-    if (elem_size == 2 && (((uintptr_t)dest | (uintptr_t)src) & 0x1) == 0) {
-        dest16 = (uint16_t *)dest;
-        src16 = (uint16_t *)src;
-        num_elements = size / 2;
-
-        for (i = 0; i < num_elements; i++) {
-            dest16[i] = pino_bswap16(src16[i]);
-        }
-
-        return dest;
-    } else if (elem_size == 4 && (((uintptr_t)dest | (uintptr_t)src) & 0x3) == 0) {
-        dest32 = (uint32_t *)dest;
-        src32 = (uint32_t *)src;
-        num_elements = size / 4;
-
-        simd_elements = num_elements / 8;
-
-        if (simd_elements > 0) {
-            shuffle_mask = _mm256_set_epi8(28, 29, 30, 31, 24, 25, 26, 27, 20, 21, 22, 23, 16, 17, 18, 19, 12, 13, 14,
-                                           15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
-
-            for (i = 0; i < simd_elements; i++) {
-                data = _mm256_loadu_si256((__m256i *)(src32 + i * 8));
-                data = _mm256_shuffle_epi8(data, shuffle_mask);
-                _mm256_storeu_si256((__m256i *)(dest32 + i * 8), data);
-            }
-
-            i = simd_elements * 8;
-        } else {
-            i = 0;
-        }
-
-        for (; i < num_elements; i++) {
-            dest32[i] = pino_bswap32(src32[i]);
-        }
-
-        return dest;
-    } else if (elem_size == 8 && (((uintptr_t)dest | (uintptr_t)src) & 0x7) == 0) {
-        dest64 = (uint64_t *)dest;
-        src64 = (uint64_t *)src;
-        num_elements = size / 8;
-
-        simd_elements = num_elements / 4;
-
-        if (simd_elements > 0) {
-            shuffle_mask = _mm256_set_epi8(24, 25, 26, 27, 28, 29, 30, 31, 16, 17, 18, 19, 20, 21, 22, 23, 8, 9, 10, 11,
-                                           12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
-
-            for (i = 0; i < simd_elements; i++) {
-                data = _mm256_loadu_si256((__m256i *)(src64 + i * 4));
-                data = _mm256_shuffle_epi8(data, shuffle_mask);
-                _mm256_storeu_si256((__m256i *)(dest64 + i * 4), data);
-            }
-
-            i = simd_elements * 4;
-        } else {
-            i = 0;
-        }
-
-        for (; i < num_elements; i++) {
-            dest64[i] = pino_bswap64(src64[i]);
-        }
-
-        return dest;
-    }
-
-    num_elements = size / elem_size;
-    for (i = 0; i < num_elements; i++) {
-        for (j = 0; j < elem_size; j++) {
-            dp[i * elem_size + j] = sp[i * elem_size + (elem_size - 1 - j)];
-        }
-    }
-
-    return dest;
-
-#elif PINO_USE_SIMD && defined(PINO_SIMD_NEON)
+#if PINO_USE_SIMD && defined(PINO_SIMD_NEON)
     uint16x8_t data16;
     uint32x4_t data32;
     uint64x2_t data64;
@@ -344,4 +288,110 @@ static inline void *pino_bswap_memcpy(void *dest, const void *src, size_t size,
 #endif
 }
 
+/* swaps every elem_size byte element inside a 64-bit word, independent of the host byte order */
+static inline uint64_t pino_bswap_word(uint64_t v, size_t elem_size)
+{
+    if (elem_size < 2) {
+        return v;
+    }
+
+    v = ((v & UINT64_C(0x00FF00FF00FF00FF)) << 8) | ((v >> 8) & UINT64_C(0x00FF00FF00FF00FF));
+    if (elem_size == 2) {
+        return v;
+    }
+
+    v = ((v & UINT64_C(0x0000FFFF0000FFFF)) << 16) | ((v >> 16) & UINT64_C(0x0000FFFF0000FFFF));
+    if (elem_size == 4) {
+        return v;
+    }
+
+    return (v << 32) | (v >> 32);
+}
+
+/*
+ * fused kernel: same output as pino_bswap_memcpy() (elem_size 1 is a plain copy), and the written bytes are folded
+ * into the crc32c register state while they are still in registers. returns the new state.
+ */
+static inline uint32_t pino_bswap_memcpy_crc32c_generic(void *dest, const void *src, size_t size, size_t elem_size,
+                                                        uint32_t state)
+{
+    const uint8_t *sp;
+    uint8_t *dp;
+    uint64_t v;
+    size_t j;
+#if PINO_USE_SIMD && defined(PINO_SIMD_NEON) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint8x16_t data;
+    uint64x2_t lanes;
+#endif
+
+    dp = (uint8_t *)dest;
+    sp = (const uint8_t *)src;
+
+    /* uncommon layouts take two passes */
+    if (elem_size == 0 || elem_size > 8 || (elem_size & (elem_size - 1)) != 0 || size % elem_size != 0) {
+        pino_bswap_memcpy_generic(dest, src, size, elem_size == 0 ? 1 : elem_size);
+        return ~pino_crc32c(~state, dest, size);
+    }
+
+#if PINO_USE_SIMD && defined(PINO_SIMD_NEON) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; size >= 16; size -= 16, sp += 16, dp += 16) {
+        data = vld1q_u8(sp);
+        if (elem_size == 2) {
+            data = vrev16q_u8(data);
+        } else if (elem_size == 4) {
+            data = vrev32q_u8(data);
+        } else if (elem_size == 8) {
+            data = vrev64q_u8(data);
+        }
+        vst1q_u8(dp, data);
+
+        lanes = vreinterpretq_u64_u8(data);
+        state = pino_crc32c_step64(state, vgetq_lane_u64(lanes, 0));
+        state = pino_crc32c_step64(state, vgetq_lane_u64(lanes, 1));
+    }
+#endif
+
+    for (; size >= 8; size -= 8, sp += 8, dp += 8) {
+        memcpy(&v, sp, sizeof(uint64_t));
+        v = pino_bswap_word(v, elem_size);
+        memcpy(dp, &v, sizeof(uint64_t));
+        state = pino_crc32c_step64(state, pino_crc32c_load64(dp));
+    }
+
+    for (; size > 0; size -= elem_size, sp += elem_size, dp += elem_size) {
+        for (j = 0; j < elem_size; j++) {
+            dp[j] = sp[elem_size - 1 - j];
+        }
+        for (j = 0; j < elem_size; j++) {
+            state = pino_crc32c_step8(state, dp[j]);
+        }
+    }
+
+    return state;
+}
+
+static inline void *pino_bswap_memcpy(void *dest, const void *src, size_t size, size_t elem_size)
+{
+#if PINO_SIMD_DISPATCH
+    if (size >= PINO_BSWAP_DISPATCH_MIN && elem_size > 1) {
+        return pino_bswap_kernels.copy(dest, src, size, elem_size);
+    }
+#endif
+
+    return pino_bswap_memcpy_generic(dest, src, size, elem_size);
+}
+
+static inline uint32_t pino_bswap_memcpy_crc32c(void *dest, const void *src, size_t size, size_t elem_size,
+                                                uint32_t state)
+{
+#if PINO_SIMD_DISPATCH
+    /* the baseline build has no crc32 instruction, so even short inputs are worth the call */
+    return pino_bswap_kernels.copy_crc32c(dest, src, size, elem_size, state);
+#else
+    return pino_bswap_memcpy_crc32c_generic(dest, src, size, elem_size, state);
+#endif
+}
+
 #endif /* PINO_INTERNAL_BSWAP_H */
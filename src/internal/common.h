@@ -18,6 +18,8 @@
 #include <pino.h>
 #include <pino/endianness.h>
 #include <pino/handler.h>
+#include <pino/stats.h>
+#include <pino/trace.h>
 
 #if PINO_USE_SIMD
 #include "simd.h"
@@ -26,12 +28,95 @@
 #define HANDLER_STEP 8
 #define MM_STEP      16
 
+#define HEADER_SIZE (sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t))
+
+/* compact header: magic with COMPACT_MAGIC_BIT set on the first byte, u8 flags, varint static fields size */
+#define COMPACT_MAGIC_BIT        0x80
+#define COMPACT_HEADER_BASE_SIZE (sizeof(pino_magic_t) + sizeof(uint8_t))
+#define VARINT_MAX_SIZE          10
+#define HEADER_MIN_SIZE          (COMPACT_HEADER_BASE_SIZE + 1)
+#define HEADER_MAX_SIZE          (COMPACT_HEADER_BASE_SIZE + VARINT_MAX_SIZE)
+
+#define FORMAT_FLAGS_SHIFT 56
+#define FORMAT_FLAGS_KNOWN                                                                    \
+    (PINO_FORMAT_FLAG_COMPRESSED | PINO_FORMAT_FLAG_DICTIONARY | PINO_FORMAT_FLAG_CHECKSUM | \
+     PINO_FORMAT_FLAG_ALIGNED | PINO_FORMAT_FLAG_BIG_ENDIAN)
+#define FIELDS_SIZE_MASK   ((UINT64_C(1) << FORMAT_FLAGS_SHIFT) - 1)
+
+#define HANDLER_FLAGS_KNOWN                                                                         \
+    (PINO_HANDLER_FLAG_COMPRESS | PINO_HANDLER_FLAG_CHECKSUM | PINO_HANDLER_FLAG_COMPACT_HEADER | \
+     PINO_HANDLER_FLAG_NATIVE_ORDER)
+
 #define PINO_VERSION_ID 10000000
 
 #ifndef PINO_BUILDTIME
 #define PINO_BUILDTIME 0
 #endif
 
+#ifndef PINO_STATS
+#define PINO_STATS 0
+#endif
+
+#ifndef PINO_ALLOC_STATS
+#define PINO_ALLOC_STATS 0
+#endif
+
+/* per handler instrumentation, expands to nothing unless built with PINO_USE_STATS */
+#if PINO_STATS
+#define STATS_DECLARE(start)                            uint64_t start
+#define STATS_START(start)                              start = pino_stats_now()
+#define STATS_RECORD(entry, op, bytes, success, start) \
+    pino_stats_record((entry)->stats_slot, op, bytes, success, start)
+#else
+#define STATS_DECLARE(start)
+#define STATS_START(start)
+#define STATS_RECORD(entry, op, bytes, success, start)
+#endif
+
+#ifndef PINO_TRACE
+#define PINO_TRACE 0
+#endif
+
+#ifndef PINO_TRACE_USDT
+#define PINO_TRACE_USDT 0
+#endif
+
+/* USDT probes are a nop until a tracer attaches, the hook costs one load and branch while unset */
+#if PINO_TRACE && PINO_TRACE_USDT
+#include <sys/sdt.h>
+#define TRACE_PROBE(probe, magic, size, result) DTRACE_PROBE3(libpino, probe, magic, size, result)
+#else
+#define TRACE_PROBE(probe, magic, size, result)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TRACE_HOOKED() __builtin_expect(pino_trace_hook != NULL, 0)
+#else
+#define TRACE_HOOKED() (pino_trace_hook != NULL)
+#endif
+
+#if PINO_TRACE
+#define TRACE_BEGIN(probe, op, magic, size)                                  \
+    do {                                                                     \
+        TRACE_PROBE(probe##_begin, magic, size, 0);                          \
+        if (TRACE_HOOKED()) {                                                \
+            pino_trace_emit(op, PINO_TRACE_PHASE_BEGIN, magic, size, false); \
+        }                                                                    \
+    } while (0)
+#define TRACE_END(probe, op, magic, size, result)                           \
+    do {                                                                    \
+        TRACE_PROBE(probe##_end, magic, size, result);                      \
+        if (TRACE_HOOKED()) {                                               \
+            pino_trace_emit(op, PINO_TRACE_PHASE_END, magic, size, result); \
+        }                                                                   \
+    } while (0)
+#else
+#define TRACE_BEGIN(probe, op, magic, size)
+#define TRACE_END(probe, op, magic, size, result)
+#endif
+
+#define TRACE_MAGIC(pino) ((pino) ? (const char *)(pino)->magic : (const char *)NULL)
+
 #define pmemcpy(dest, src, size)     memcpy(dest, src, size)
 #define pmemcpy_n2l(dest, src, size) pino_endianness_memcpy_native2le(dest, src, size, size)
 #define pmemcpy_n2b(dest, src, size) pino_endianness_memcpy_native2be(dest, src, size, size)
@@ -39,10 +124,27 @@
 #define pmemcpy_b2n(dest, src, size) pino_endianness_memcpy_be2native(dest, src, size, size)
 #define pmemmove(dest, src, size)    memmove(dest, src, size)
 #define pmemcmp(s1, s2, size)        memcmp(s1, s2, size)
-#define pmalloc(size)                malloc(size)
-#define pcalloc(count, size)         calloc(count, size)
-#define prealloc(ptr, size)          realloc(ptr, size)
-#define pfree(ptr)                   free(ptr)
+
+/* allocation counting, only compiled in with PINO_USE_ALLOC_STATS or the test suite */
+#if PINO_ALLOC_STATS
+#define pmalloc(size)                   pino_alloc_malloc(size)
+#define pcalloc(count, size)            pino_alloc_calloc(count, size)
+#define prealloc(ptr, size)             pino_alloc_realloc(ptr, size)
+#define pfree(ptr)                      pino_alloc_free(ptr)
+#define pmemalign(ptr, alignment, size) pino_alloc_memalign(ptr, alignment, size)
+
+void *pino_alloc_malloc(size_t size);
+void *pino_alloc_calloc(size_t count, size_t size);
+void *pino_alloc_realloc(void *ptr, size_t size);
+void pino_alloc_free(void *ptr);
+int pino_alloc_memalign(void **ptr, size_t alignment, size_t size);
+#else
+#define pmalloc(size)                   malloc(size)
+#define pcalloc(count, size)            calloc(count, size)
+#define prealloc(ptr, size)             realloc(ptr, size)
+#define pfree(ptr)                      free(ptr)
+#define pmemalign(ptr, alignment, size) posix_memalign(ptr, alignment, size)
+#endif
 
 typedef struct {
     size_t usage;
@@ -50,14 +152,43 @@ typedef struct {
     void **ptrs;
 } mm_t;
 
+typedef struct _dictionary_t {
+    struct _dictionary_t *next;
+    uint16_t id;
+    size_t size;
+    size_t *table;
+    uint8_t data[];
+} dictionary_t;
+
 typedef struct {
     pino_magic_t magic;
+    uint32_t key;
     mm_t mm;
     pino_handler_t *handler;
+    uint32_t flags;
+    uint32_t generation;
+    dictionary_t *dictionaries; /* most recent first, used for encoding */
     size_t refcount;
     bool unregistered;
+#if PINO_STATS
+    size_t stats_slot;
+#endif
 } handler_entry_t;
 
+typedef struct {
+    size_t raw_size;
+    size_t size;
+    size_t capacity;
+    const dictionary_t *dictionary;
+    uint8_t data[];
+} encoded_payload_t;
+
+/* running crc32c of a record being serialized, next is where the covered prefix ends (NULL once invalidated) */
+typedef struct {
+    uint8_t *next;
+    uint32_t state;
+} checksum_context_t;
+
 static inline bool validate_magic(pino_magic_safe_t magic)
 {
     size_t i;
@@ -91,11 +222,126 @@ static inline bool magic_equal(pino_magic_t magic, pino_magic_safe_t smagic)
     return strncmp(magic, smagic, sizeof(pino_magic_t)) == 0;
 }
 
+static inline uint32_t magic_key(const char *magic)
+{
+    uint32_t key;
+
+    pmemcpy(&key, magic, sizeof(key));
+
+    return key;
+}
+
+static inline size_t varint_size(uint64_t value)
+{
+    size_t size = 1;
+
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+
+    return size;
+}
+
+static inline size_t varint_write(uint8_t *dest, uint64_t value)
+{
+    size_t size = 0;
+
+    while (value >= 0x80) {
+        dest[size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    dest[size++] = (uint8_t)value;
+
+    return size;
+}
+
+static inline bool varint_read(const uint8_t **p, const uint8_t *end, uint64_t *value)
+{
+    unsigned int shift;
+
+    /* single byte values are the common case */
+    if (*p < end && **p < 0x80) {
+        *value = *(*p)++;
+        return true;
+    }
+
+    *value = 0;
+    for (shift = 0; shift < 64 && *p < end; shift += 7) {
+        *value |= (uint64_t)(**p & 0x7F) << shift;
+        if (!(*(*p)++ & 0x80)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* decodes either header layout, header_size receives the offset of the first extension field */
+static inline bool header_decode(const uint8_t *src, size_t size, pino_magic_safe_t magic, uint8_t *flags,
+                                 uint64_t *fields_size, size_t *header_size)
+{
+    const uint8_t *p;
+    pino_static_fields_size_t word;
+
+    if (!src || size < HEADER_MIN_SIZE) {
+        return false;
+    }
+
+    pmemcpy(magic, src, sizeof(pino_magic_t));
+    magic[0] = (char)(src[0] & ~COMPACT_MAGIC_BIT);
+    magic[sizeof(pino_magic_t)] = '\0';
+
+    if (src[0] & COMPACT_MAGIC_BIT) {
+        *flags = src[sizeof(pino_magic_t)];
+        p = src + COMPACT_HEADER_BASE_SIZE;
+        if (!varint_read(&p, src + size, fields_size)) {
+            return false;
+        }
+        *header_size = (size_t)(p - src);
+    } else {
+        if (size < HEADER_SIZE) {
+            return false;
+        }
+        pmemcpy_l2n(&word, src + sizeof(pino_magic_t), sizeof(pino_static_fields_size_t));
+        *flags = (uint8_t)(word >> FORMAT_FLAGS_SHIFT);
+        *fields_size = word & FIELDS_SIZE_MASK;
+        *header_size = HEADER_SIZE;
+    }
+
+    return (*flags & ~FORMAT_FLAGS_KNOWN) == 0;
+}
+
 bool pino_handler_init(size_t initialize_size);
 void pino_handler_free(void);
 handler_entry_t *pino_handler_find_entry(pino_magic_safe_t magic);
+checksum_context_t *pino_handler_checksum_set(checksum_context_t *context);
+bool pino_handler_big_endian_set(bool big_endian);
+
+uint32_t pino_endianness_memcpy_native2le_crc32c(void *dest, const void *src, size_t size, size_t elem_size,
+                                                 uint32_t state);
+uint32_t pino_endianness_memcpy_native2be_crc32c(void *dest, const void *src, size_t size, size_t elem_size,
+                                                 uint32_t state);
+bool pino_endianness_is_big(void);
+
+bool pino_payload_decode(const handler_entry_t *entry, const pino_peek_info_t *info, const void *src, uint8_t **raw);
+
+const dictionary_t *pino_dictionary_find(const handler_entry_t *entry, uint16_t id);
+void pino_dictionary_free_all(handler_entry_t *entry);
 
 bool pino_memory_manager_obj_init(mm_t *mm, size_t initialize_size);
 void pino_memory_manager_obj_free(mm_t *mm);
 
+#if PINO_STATS
+size_t pino_stats_slot(pino_magic_t magic);
+uint64_t pino_stats_now(void);
+void pino_stats_record(size_t slot, pino_stats_op_t op, uint64_t bytes, bool success, uint64_t start);
+void pino_stats_free(void);
+#endif
+
+#if PINO_TRACE
+extern pino_trace_hook_t pino_trace_hook;
+void pino_trace_emit(pino_trace_op_t op, pino_trace_phase_t phase, const char *magic, size_t size, bool result);
+#endif
+
 #endif /* PINO_INTERNAL_COMMON_H */
@@ -0,0 +1,23 @@
+/*
+ * libpino - cpu.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_INTERNAL_CPU_H
+#define PINO_INTERNAL_CPU_H
+
+#include <stdint.h>
+
+#define PINO_CPU_SSSE3  (1U << 0)
+#define PINO_CPU_SSE42  (1U << 1)
+#define PINO_CPU_AVX2   (1U << 2)
+#define PINO_CPU_AVX512 (1U << 3) /* F and BW */
+
+/* what both the CPU and the OS support, always 0 outside x86-64 */
+uint32_t pino_cpu_features(void);
+
+#endif /* PINO_INTERNAL_CPU_H */
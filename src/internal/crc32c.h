@@ -0,0 +1,104 @@
+/*
+ * libpino - crc32c.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_INTERNAL_CRC32C_H
+#define PINO_INTERNAL_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <pino/portable.h>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && \
+    (defined(__SSE4_2__) || defined(__AVX2__) || defined(PINO_CRC32C_FORCE_SSE42))
+#define PINO_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define PINO_CRC32C_ARM 1
+#include <arm_acle.h>
+#endif
+
+#define CRC32C_SIZE sizeof(uint32_t)
+
+/* slicing-by-8 tables for the Castagnoli polynomial, filled by pino_crc32c_init() */
+extern uint32_t pino_crc32c_table[8][256];
+
+void pino_crc32c_init(void);
+uint32_t pino_crc32c(uint32_t crc, const void *data, size_t size);
+#if PINO_SIMD_DISPATCH
+uint32_t pino_crc32c_sse42(uint32_t crc, const void *data, size_t size);
+#endif
+
+static inline uint64_t pino_crc32c_load64(const uint8_t *p)
+{
+    uint64_t v;
+
+    memcpy(&v, p, sizeof(uint64_t));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = pino_bswap64(v);
+#endif
+
+    return v;
+}
+
+/*
+ * register level steps: the state is the inverted crc and v holds 8 bytes in
+ * memory order read as little endian.
+ */
+static inline uint32_t pino_crc32c_step8(uint32_t state, uint8_t v)
+{
+#if defined(PINO_CRC32C_SSE42)
+    return _mm_crc32_u8(state, v);
+#elif defined(PINO_CRC32C_ARM)
+    return __crc32cb(state, v);
+#else
+    return pino_crc32c_table[0][(state ^ v) & 0xFF] ^ (state >> 8);
+#endif
+}
+
+static inline uint32_t pino_crc32c_step64(uint32_t state, uint64_t v)
+{
+#if defined(PINO_CRC32C_SSE42)
+    return (uint32_t)_mm_crc32_u64(state, v);
+#elif defined(PINO_CRC32C_ARM)
+    return __crc32cd(state, v);
+#else
+    uint32_t lo = state ^ (uint32_t)v, hi = (uint32_t)(v >> 32);
+
+    return pino_crc32c_table[7][lo & 0xFF] ^ pino_crc32c_table[6][(lo >> 8) & 0xFF] ^
+           pino_crc32c_table[5][(lo >> 16) & 0xFF] ^ pino_crc32c_table[4][lo >> 24] ^
+           pino_crc32c_table[3][hi & 0xFF] ^ pino_crc32c_table[2][(hi >> 8) & 0xFF] ^
+           pino_crc32c_table[1][(hi >> 16) & 0xFF] ^ pino_crc32c_table[0][hi >> 24];
+#endif
+}
+
+/* the body of pino_crc32c(), built once per instruction set */
+static inline uint32_t pino_crc32c_update(uint32_t crc, const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t state = ~crc;
+
+    /* one byte at a time until the input is 8-byte aligned */
+    for (; size > 0 && ((uintptr_t)p & 7) != 0; size--) {
+        state = pino_crc32c_step8(state, *p++);
+    }
+
+    for (; size >= 8; size -= 8, p += 8) {
+        state = pino_crc32c_step64(state, pino_crc32c_load64(p));
+    }
+
+    for (; size > 0; size--) {
+        state = pino_crc32c_step8(state, *p++);
+    }
+
+    return ~state;
+}
+
+#endif /* PINO_INTERNAL_CRC32C_H */
@@ -0,0 +1,31 @@
+/*
+ * libpino - lz.h
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_INTERNAL_LZ_H
+#define PINO_INTERNAL_LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* a single literal or match byte never expands to more than this */
+#define LZ_MAX_RATIO 255
+
+#define LZ_MAX_OFFSET     65535
+#define LZ_HASH_LOG_MAX   12
+#define LZ_DICT_MAX_SIZE  LZ_MAX_OFFSET
+#define LZ_DICT_TABLE_LEN (1 << LZ_HASH_LOG_MAX)
+
+size_t pino_lz_bound(size_t size);
+void pino_lz_prepare_dict(const void *dict, size_t dict_size, size_t *table);
+size_t pino_lz_compress(const void *src, size_t size, const void *dict, size_t dict_size, const size_t *dict_table,
+                        void *dest, size_t capacity);
+bool pino_lz_decompress(const void *src, size_t size, const void *dict, size_t dict_size, void *dest, size_t raw_size);
+
+#endif /* PINO_INTERNAL_LZ_H */
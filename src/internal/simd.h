@@ -13,8 +13,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#if defined(PINO_SIMD_AVX2)
-#include <immintrin.h>
+/* x86-64 code outside the dispatched kernels may only assume SSE2 */
+#if defined(PINO_SIMD_DISPATCH)
+#define PINO_SIMD_SSE2 1
+#include <emmintrin.h>
 #elif defined(PINO_SIMD_NEON)
 #include <arm_neon.h>
 #elif defined(PINO_SIMD_WASM)
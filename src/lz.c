@@ -0,0 +1,346 @@
+/*
+ * libpino - lz.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pino.h>
+
+#include "internal/common.h"
+#include "internal/lz.h"
+
+/*
+ * byte oriented LZ77 block format:
+ *   token (literal length << 4 | match length - LZ_MIN_MATCH), [literal length ext], literals,
+ *   u16 LE offset, [match length ext]
+ * the last sequence has literals only. a nibble of 15 is followed by 255-run length bytes.
+ * with a dictionary, offsets may reach back past the output start into the end of the dictionary.
+ */
+
+#define LZ_MIN_MATCH     4
+#define LZ_LAST_LITERALS 5
+#define LZ_MFLIMIT       12
+#define LZ_HASH_LOG_MIN  8
+#define LZ_SKIP_TRIGGER  6
+#define LZ_NIBBLE_MAX    15
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t v;
+
+    pmemcpy(&v, p, sizeof(v));
+
+    return v;
+}
+
+static inline uint32_t hash32(uint32_t v, unsigned int hash_log)
+{
+    return (v * UINT32_C(2654435761)) >> (32 - hash_log);
+}
+
+static inline unsigned int select_hash_log(size_t size)
+{
+    unsigned int hash_log = LZ_HASH_LOG_MIN;
+
+    /* small inputs do not pay for clearing a large table */
+    while (hash_log < LZ_HASH_LOG_MAX && ((size_t)1 << hash_log) < size) {
+        hash_log++;
+    }
+
+    return hash_log;
+}
+
+static inline uint8_t *write_length(uint8_t *op, size_t length)
+{
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (uint8_t)length;
+
+    return op;
+}
+
+static inline bool read_length(const uint8_t **ip, const uint8_t *iend, size_t *length)
+{
+    uint8_t b;
+
+    do {
+        if (*ip >= iend || *length > SIZE_MAX - 255) {
+            return false;
+        }
+        b = *(*ip)++;
+        *length += b;
+    } while (b == 255);
+
+    return true;
+}
+
+static inline uint8_t *write_sequence(uint8_t *op, const uint8_t *oend, const uint8_t *literals, size_t literal_length,
+                                      size_t offset, size_t match_length)
+{
+    uint8_t *token;
+
+    if ((size_t)(oend - op) < 1 + literal_length / 255 + 1 + literal_length + 2 + match_length / 255 + 1) {
+        return NULL;
+    }
+
+    token = op++;
+    *token = (uint8_t)((literal_length < LZ_NIBBLE_MAX ? literal_length : LZ_NIBBLE_MAX) << 4);
+    if (literal_length >= LZ_NIBBLE_MAX) {
+        op = write_length(op, literal_length - LZ_NIBBLE_MAX);
+    }
+
+    pmemcpy(op, literals, literal_length);
+    op += literal_length;
+
+    if (offset == 0) {
+        return op;
+    }
+
+    match_length -= LZ_MIN_MATCH;
+    *token |= (uint8_t)(match_length < LZ_NIBBLE_MAX ? match_length : LZ_NIBBLE_MAX);
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+    if (match_length >= LZ_NIBBLE_MAX) {
+        op = write_length(op, match_length - LZ_NIBBLE_MAX);
+    }
+
+    return op;
+}
+
+extern size_t pino_lz_bound(size_t size)
+{
+    if (size > (SIZE_MAX - 16) / 256 * 255) {
+        return 0;
+    }
+
+    return size + size / 255 + 16;
+}
+
+extern void pino_lz_prepare_dict(const void *dict, size_t dict_size, size_t *table)
+{
+    const uint8_t *dbase;
+    size_t pos;
+
+    memset(table, 0, sizeof(size_t) * LZ_DICT_TABLE_LEN);
+
+    if (!dict) {
+        return;
+    }
+
+    dbase = (const uint8_t *)dict;
+    for (pos = 0; pos + sizeof(uint32_t) <= dict_size; pos++) {
+        table[hash32(read32(dbase + pos), LZ_HASH_LOG_MAX)] = pos;
+    }
+}
+
+/* resolves a virtual position and checks that it starts a match for ip within reach */
+static inline bool find_ref(size_t vpos, size_t vip, const uint8_t *ip, const uint8_t *base, const uint8_t *iend,
+                            const uint8_t *dbase, size_t dict_size, const uint8_t **ref, const uint8_t **ref_start,
+                            const uint8_t **ref_end)
+{
+    if (vpos >= vip || vip - vpos > LZ_MAX_OFFSET) {
+        return false;
+    }
+
+    if (vpos < dict_size) {
+        *ref = dbase + vpos;
+        *ref_start = dbase;
+        *ref_end = dbase + dict_size;
+    } else {
+        *ref = base + (vpos - dict_size);
+        *ref_start = base;
+        *ref_end = iend;
+    }
+
+    return *ref_end - *ref >= (ptrdiff_t)sizeof(uint32_t) && read32(*ref) == read32(ip);
+}
+
+extern size_t pino_lz_compress(const void *src, size_t size, const void *dict, size_t dict_size,
+                               const size_t *dict_table, void *dest, size_t capacity)
+{
+    size_t table[LZ_DICT_TABLE_LEN];
+    const uint8_t *base, *dbase, *ip, *anchor, *iend, *mflimit, *matchlimit, *ref, *ref_start, *ref_end;
+    uint8_t *op, *oend;
+    size_t match_length, vpos, vip;
+    unsigned int hash_log;
+    uint32_t v, h;
+    bool found;
+
+    if (!src || !dest || dict_size > LZ_DICT_MAX_SIZE || (!dict && dict_size > 0) || (!dict_table && dict_size > 0)) {
+        return 0;
+    }
+
+    base = (const uint8_t *)src;
+    dbase = (const uint8_t *)dict;
+    ip = anchor = base;
+    iend = base + size;
+    op = (uint8_t *)dest;
+    oend = op + capacity;
+
+    if (size >= LZ_MFLIMIT + LZ_MIN_MATCH) {
+        /*
+         * positions are virtual: [0, dict_size) is the dictionary and the input follows it. the input gets a table
+         * sized for it, the prepared dictionary table is only read.
+         */
+        hash_log = select_hash_log(size);
+        memset(table, 0, sizeof(size_t) << hash_log);
+
+        mflimit = iend - LZ_MFLIMIT;
+        matchlimit = iend - LZ_LAST_LITERALS;
+
+        if (dict_size == 0) {
+            ip++;
+        }
+
+        while (ip < mflimit) {
+            v = read32(ip);
+            h = hash32(v, hash_log);
+            vip = dict_size + (size_t)(ip - base);
+            vpos = table[h];
+            table[h] = vip;
+
+            /* recent input first, then the dictionary */
+            found = find_ref(vpos, vip, ip, base, iend, dbase, dict_size, &ref, &ref_start, &ref_end);
+            if (!found && dict_size > 0) {
+                vpos = dict_table[hash32(v, LZ_HASH_LOG_MAX)];
+                found = find_ref(vpos, vip, ip, base, iend, dbase, dict_size, &ref, &ref_start, &ref_end);
+            }
+
+            if (!found) {
+                /* skip faster through incompressible data */
+                ip += 1 + ((size_t)(ip - anchor) >> LZ_SKIP_TRIGGER);
+                continue;
+            }
+
+            while (ip > anchor && ref > ref_start && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+                vpos--;
+                vip--;
+            }
+
+            match_length = LZ_MIN_MATCH;
+            while (ip + match_length < matchlimit && ref + match_length < ref_end &&
+                   ip[match_length] == ref[match_length]) {
+                match_length++;
+            }
+
+            op = write_sequence(op, oend, anchor, (size_t)(ip - anchor), vip - vpos, match_length);
+            if (!op) {
+                return 0;
+            }
+
+            ip += match_length;
+            anchor = ip;
+
+            if (ip < mflimit) {
+                table[hash32(read32(ip - 2), hash_log)] = dict_size + (size_t)(ip - 2 - base);
+            }
+        }
+    }
+
+    op = write_sequence(op, oend, anchor, (size_t)(iend - anchor), 0, 0);
+    if (!op) {
+        return 0;
+    }
+
+    return (size_t)(op - (uint8_t *)dest);
+}
+
+extern bool pino_lz_decompress(const void *src, size_t size, const void *dict, size_t dict_size, void *dest,
+                               size_t raw_size)
+{
+    const uint8_t *ip, *iend, *ref, *dbase;
+    uint8_t *op, *ostart, *oend;
+    size_t literal_length, match_length, offset, chunk, back;
+    uint8_t token;
+
+    if (!src || (!dest && raw_size > 0) || (!dict && dict_size > 0)) {
+        return false;
+    }
+
+    dbase = (const uint8_t *)dict;
+
+    ip = (const uint8_t *)src;
+    iend = ip + size;
+    ostart = op = (uint8_t *)dest;
+    oend = op + raw_size;
+
+    while (ip < iend) {
+        token = *ip++;
+
+        literal_length = token >> 4;
+        if (literal_length == LZ_NIBBLE_MAX && !read_length(&ip, iend, &literal_length)) {
+            return false;
+        }
+
+        if (literal_length > (size_t)(iend - ip) || literal_length > (size_t)(oend - op)) {
+            return false;
+        }
+
+        pmemcpy(op, ip, literal_length);
+        op += literal_length;
+        ip += literal_length;
+
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+
+        offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - ostart) + dict_size) {
+            return false;
+        }
+
+        match_length = token & LZ_NIBBLE_MAX;
+        if (match_length == LZ_NIBBLE_MAX && !read_length(&ip, iend, &match_length)) {
+            return false;
+        }
+        match_length += LZ_MIN_MATCH;
+
+        if (match_length > (size_t)(oend - op)) {
+            return false;
+        }
+
+        if (offset > (size_t)(op - ostart)) {
+            /* the match starts inside the dictionary and may run on into the output */
+            back = offset - (size_t)(op - ostart);
+            chunk = match_length < back ? match_length : back;
+            pmemcpy(op, dbase + dict_size - back, chunk);
+            op += chunk;
+            match_length -= chunk;
+        }
+
+        /* a match that ended inside the dictionary has no reference in the output */
+        if (match_length == 0) {
+            continue;
+        }
+
+        ref = op - offset;
+        if (offset == 1) {
+            memset(op, *ref, match_length);
+            op += match_length;
+            continue;
+        }
+
+        /* overlapping matches repeat the last offset bytes, copy them in non-overlapping chunks */
+        while (match_length > 0) {
+            chunk = match_length < offset ? match_length : offset;
+            pmemcpy(op, ref, chunk);
+            op += chunk;
+            ref += chunk;
+            match_length -= chunk;
+        }
+    }
+
+    return op == oend;
+}
@@ -15,9 +15,12 @@
 #include <pino.h>
 #include <pino/handler.h>
 
+#include "internal/bswap.h"
 #include "internal/common.h"
+#include "internal/crc32c.h"
+#include "internal/lz.h"
 
-static inline pino_t *pino_create(pino_magic_safe_t magic, handler_entry_t *entry, size_t size)
+static inline pino_t *create_object(pino_magic_safe_t magic, handler_entry_t *entry, size_t size)
 {
     pino_t *pino;
     pino_handler_t *handler;
@@ -47,9 +50,15 @@ static inline pino_t *pino_create(pino_magic_safe_t magic, handler_entry_t *entr
 
     pino->handler = handler;
     pino->entry = entry;
+    pino->serialize_size_cache = 0;
+    pino->serialize_generation = 0;
+    pino->encoded = NULL;
+    pino->dirty = true;
+    TRACE_BEGIN(handler_create, PINO_TRACE_OP_HANDLER_CREATE, pino->magic, size);
     previous_entry = pino_handler_context_set(entry);
     pino->this = handler->create(size, pino->static_fields);
     pino_handler_context_set(previous_entry);
+    TRACE_END(handler_create, PINO_TRACE_OP_HANDLER_CREATE, pino->magic, size, pino->this != NULL);
     if (!pino->this) {
         pfree(pino->static_fields);
         pfree(pino);
@@ -61,111 +70,599 @@ static inline pino_t *pino_create(pino_magic_safe_t magic, handler_entry_t *entr
     return pino;
 }
 
+static inline pino_t *pino_create(pino_magic_safe_t magic, handler_entry_t *entry, size_t size)
+{
+    pino_t *pino;
+    STATS_DECLARE(start);
+
+    STATS_START(start);
+    pino = create_object(magic, entry, size);
+    STATS_RECORD(entry, PINO_STATS_OP_CREATE, size, pino != NULL, start);
+
+    return pino;
+}
+
+/* extension fields follow the fixed header in flag bit order */
+static inline bool read_header(const void *src, size_t size, pino_peek_info_t *info)
+{
+    uint64_t raw_size = 0;
+    uint16_t dictionary_id = 0;
+    size_t offset;
+
+    if (!header_decode((const uint8_t *)src, size, info->magic, &info->flags, &info->static_fields_size, &offset) ||
+        ((info->flags & PINO_FORMAT_FLAG_DICTIONARY) && !(info->flags & PINO_FORMAT_FLAG_COMPRESSED))) {
+        return false;
+    }
+
+    if (info->flags & PINO_FORMAT_FLAG_COMPRESSED) {
+        if (size - offset < sizeof(uint64_t)) {
+            return false;
+        }
+        pmemcpy_l2n(&raw_size, ((const char *)src) + offset, sizeof(uint64_t));
+        offset += sizeof(uint64_t);
+    }
+
+    if (info->flags & PINO_FORMAT_FLAG_DICTIONARY) {
+        if (size - offset < sizeof(uint16_t)) {
+            return false;
+        }
+        pmemcpy_l2n(&dictionary_id, ((const char *)src) + offset, sizeof(uint16_t));
+        offset += sizeof(uint16_t);
+    }
+
+    /* u8 count followed by that many padding bytes */
+    if (info->flags & PINO_FORMAT_FLAG_ALIGNED) {
+        if (size - offset < sizeof(uint8_t) || ((const uint8_t *)src)[offset] >= PINO_PAYLOAD_ALIGNMENT_MAX ||
+            ((const uint8_t *)src)[offset] > size - offset - sizeof(uint8_t)) {
+            return false;
+        }
+        offset += sizeof(uint8_t) + ((const uint8_t *)src)[offset];
+    }
+
+    /* the checksum trailer is not part of the payload */
+    if (info->flags & PINO_FORMAT_FLAG_CHECKSUM) {
+        if (size - offset < CRC32C_SIZE) {
+            return false;
+        }
+        size -= CRC32C_SIZE;
+    }
+
+    if (info->static_fields_size > size - offset) {
+        return false;
+    }
+
+    info->static_fields = ((const char *)src) + offset;
+    info->payload_offset = offset + (size_t)info->static_fields_size;
+    info->payload_size = size - info->payload_offset;
+    info->raw_payload_size = info->payload_size;
+    info->dictionary_id = dictionary_id;
+    info->registered = false;
+
+    if (info->flags & PINO_FORMAT_FLAG_COMPRESSED) {
+        /* reject sizes the codec can never produce before anything is allocated */
+        if (raw_size > SIZE_MAX || raw_size / LZ_MAX_RATIO > info->payload_size) {
+            return false;
+        }
+        info->raw_payload_size = (size_t)raw_size;
+    }
+
+    return true;
+}
+
+static inline size_t extension_size(const encoded_payload_t *encoded)
+{
+    return sizeof(uint64_t) + (encoded->dictionary ? sizeof(uint16_t) : 0);
+}
+
+/* payloads are LE unless the handler opts into the native order of a BE writer */
+static inline bool writes_big_endian(const pino_t *pino)
+{
+    return (((const handler_entry_t *)pino->entry)->flags & PINO_HANDLER_FLAG_NATIVE_ORDER) && pino_endianness_is_big();
+}
+
+static inline bool encode_payload(pino_t *pino, size_t raw_size, const dictionary_t *dictionary)
+{
+    encoded_payload_t *encoded;
+    uint8_t *raw;
+    size_t bound, size;
+    bool result, previous_big_endian;
+    void *previous_entry;
+
+    bound = pino_lz_bound(raw_size);
+    if (bound == 0 || bound > SIZE_MAX - sizeof(encoded_payload_t)) {
+        return false;
+    }
+
+    encoded = (encoded_payload_t *)pino->encoded;
+    if (!encoded || encoded->capacity < bound) {
+        encoded = (encoded_payload_t *)prealloc(pino->encoded, sizeof(encoded_payload_t) + bound);
+        if (!encoded) {
+            return false;
+        }
+        encoded->size = 0;
+        encoded->capacity = bound;
+        pino->encoded = encoded;
+    }
+
+    encoded->dictionary = dictionary;
+
+    raw = (uint8_t *)pmalloc(raw_size > 0 ? raw_size : 1);
+    if (!raw) {
+        return false;
+    }
+
+    TRACE_BEGIN(handler_serialize, PINO_TRACE_OP_HANDLER_SERIALIZE, pino->magic, raw_size);
+    previous_entry = pino_handler_context_set(pino->entry);
+    previous_big_endian = pino_handler_big_endian_set(writes_big_endian(pino));
+    result = pino->handler->serialize(pino->this, pino->static_fields, raw);
+    pino_handler_big_endian_set(previous_big_endian);
+    pino_handler_context_set(previous_entry);
+    TRACE_END(handler_serialize, PINO_TRACE_OP_HANDLER_SERIALIZE, pino->magic, raw_size, result);
+
+    size = 0;
+    if (result) {
+        size = pino_lz_compress(raw, raw_size, dictionary ? dictionary->data : NULL, dictionary ? dictionary->size : 0,
+                                dictionary ? dictionary->table : NULL, encoded->data, encoded->capacity);
+    }
+    pfree(raw);
+
+    /* keep the raw form when compression does not pay for its extension */
+    if (size == 0 || size + extension_size(encoded) >= raw_size) {
+        return false;
+    }
+
+    encoded->raw_size = raw_size;
+    encoded->size = size;
+
+    return true;
+}
+
+static inline size_t header_size(const pino_t *pino)
+{
+    if (((const handler_entry_t *)pino->entry)->flags & PINO_HANDLER_FLAG_COMPACT_HEADER) {
+        return COMPACT_HEADER_BASE_SIZE + varint_size(pino->static_fields_size);
+    }
+
+    return HEADER_SIZE;
+}
+
+static inline bool is_encoded(const pino_t *pino)
+{
+    return pino->encoded && ((const encoded_payload_t *)pino->encoded)->size > 0;
+}
+
+/* padding count and padding that put a raw payload on the handler boundary, relative to the record start */
+static inline size_t alignment_size(const pino_t *pino)
+{
+    size_t alignment = pino->handler->payload_alignment, offset;
+
+    if (alignment <= 1 || is_encoded(pino)) {
+        return 0;
+    }
+
+    offset = header_size(pino) + sizeof(uint8_t) + (size_t)pino->static_fields_size;
+
+    return sizeof(uint8_t) + ((alignment - offset % alignment) % alignment);
+}
+
 extern bool pino_init(void)
 {
+    pino_crc32c_init();
+    pino_bswap_init();
+
     return pino_handler_init(HANDLER_STEP);
 }
 
 extern void pino_free(void)
 {
     pino_handler_free();
+#if PINO_STATS
+    pino_stats_free();
+#endif
 }
 
-extern size_t pino_serialize_size(const pino_t *pino)
+extern bool pino_peek(const void *src, size_t size, pino_peek_info_t *info)
+{
+    bool result;
+
+    TRACE_BEGIN(peek, PINO_TRACE_OP_PEEK, NULL, size);
+
+    result = info && read_header(src, size, info);
+    if (result) {
+        info->registered = pino_handler_find_entry(info->magic) != NULL;
+    }
+
+    TRACE_END(peek, PINO_TRACE_OP_PEEK, result ? (const char *)info->magic : NULL, size, result);
+
+    return result;
+}
+
+/* the record size around a payload of payload_size bytes, 0 on overflow */
+static inline size_t record_size(const pino_t *pino, size_t payload_size)
+{
+    size_t total_size, fixed_size;
+
+    fixed_size = header_size(pino) + (size_t)pino->static_fields_size;
+    if (is_encoded(pino)) {
+        fixed_size += extension_size((const encoded_payload_t *)pino->encoded);
+    }
+
+    if (payload_size > SIZE_MAX - fixed_size) {
+        return 0;
+    }
+    total_size = payload_size + fixed_size;
+
+    if (total_size > SIZE_MAX - alignment_size(pino)) {
+        return 0;
+    }
+    total_size += alignment_size(pino);
+
+    if (((const handler_entry_t *)pino->entry)->flags & PINO_HANDLER_FLAG_CHECKSUM) {
+        if (total_size > SIZE_MAX - CRC32C_SIZE) {
+            return 0;
+        }
+        total_size += CRC32C_SIZE;
+    }
+
+    return total_size;
+}
+
+/*
+ * refresh asks the handler again even when the cached size is current. the size bounds what write_record() lays out,
+ * so the serialize paths refresh it in case the payload changed without pino_touch().
+ */
+static inline size_t serialize_size(const pino_t *pino, bool refresh)
 {
+    pino_t *mutable_pino;
+    const handler_entry_t *entry;
+    const encoded_payload_t *encoded;
     size_t handler_size, total_size;
     void *previous_entry;
+    bool cached;
 
-    if (!pino || !pino->handler || !pino->handler->serialize_size) {
+    if (!pino || !pino->handler || !pino->handler->serialize_size || !pino->entry) {
         return 0;
     }
 
+    /* handler options may change after the size was cached */
+    entry = (const handler_entry_t *)pino->entry;
+    cached = !pino->dirty && pino->serialize_generation == entry->generation;
+    if (cached && !refresh) {
+        return pino->serialize_size_cache;
+    }
+
+    /* the object itself is never const, only the view through the public API */
+    mutable_pino = (pino_t *)pino;
+
+    TRACE_BEGIN(handler_serialize_size, PINO_TRACE_OP_HANDLER_SERIALIZE_SIZE, pino->magic, 0);
     previous_entry = pino_handler_context_set(pino->entry);
     handler_size = pino->handler->serialize_size(pino->this, pino->static_fields);
     pino_handler_context_set(previous_entry);
-    if (handler_size > SIZE_MAX - sizeof(pino_magic_t) - sizeof(pino_static_fields_size_t) - pino->static_fields_size) {
+    TRACE_END(handler_serialize_size, PINO_TRACE_OP_HANDLER_SERIALIZE_SIZE, pino->magic, handler_size,
+              handler_size != 0);
+
+    /* a payload that kept its size keeps its layout, and a compressed one is not encoded again */
+    if (cached) {
+        encoded = is_encoded(pino) ? (const encoded_payload_t *)pino->encoded : NULL;
+        if (encoded ? encoded->raw_size == handler_size
+                    : record_size(pino, handler_size) == pino->serialize_size_cache) {
+            return pino->serialize_size_cache;
+        }
+    }
+
+    if (mutable_pino->encoded) {
+        ((encoded_payload_t *)mutable_pino->encoded)->size = 0;
+    }
+
+    if (handler_size > SIZE_MAX - header_size(pino) - pino->static_fields_size) {
         return 0;
     }
 
-    total_size = handler_size + sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t) + pino->static_fields_size;
+    if ((entry->flags & PINO_HANDLER_FLAG_COMPRESS) &&
+        encode_payload(mutable_pino, handler_size, entry->dictionaries)) {
+        encoded = (const encoded_payload_t *)pino->encoded;
+        total_size = record_size(pino, encoded->size);
+    } else {
+        total_size = record_size(pino, handler_size);
+    }
+
+    if (total_size == 0) {
+        return 0;
+    }
+
+    mutable_pino->serialize_size_cache = total_size;
+    mutable_pino->serialize_generation = entry->generation;
+    mutable_pino->dirty = false;
 
     return total_size;
 }
 
-extern bool pino_serialize(const pino_t *pino, void *dest)
+extern size_t pino_serialize_size(const pino_t *pino)
 {
-    bool result;
+    size_t size;
+
+    TRACE_BEGIN(serialize_size, PINO_TRACE_OP_SERIALIZE_SIZE, TRACE_MAGIC(pino), 0);
+    size = serialize_size(pino, false);
+    TRACE_END(serialize_size, PINO_TRACE_OP_SERIALIZE_SIZE, TRACE_MAGIC(pino), size, size != 0);
+
+    return size;
+}
+
+static inline bool write_record(const pino_t *pino, void *dest)
+{
+    const encoded_payload_t *encoded;
+    checksum_context_t context, *previous_context;
+    pino_static_fields_size_t word;
+    uint64_t raw_size;
+    uint32_t crc;
+    uint8_t *p, *end, flags;
+    size_t padding;
+    bool checksum, big_endian, result, previous_big_endian;
     void *previous_entry;
+#if PINO_TRACE
+    size_t payload_size;
+#endif
+
+    p = (uint8_t *)dest;
+    encoded = is_encoded(pino) ? (const encoded_payload_t *)pino->encoded : NULL;
+    checksum = (((const handler_entry_t *)pino->entry)->flags & PINO_HANDLER_FLAG_CHECKSUM) != 0;
+    padding = alignment_size(pino);
+    big_endian = writes_big_endian(pino);
+
+    flags = 0;
+    if (checksum) {
+        flags |= PINO_FORMAT_FLAG_CHECKSUM;
+    }
+    if (encoded) {
+        flags |= PINO_FORMAT_FLAG_COMPRESSED;
+        if (encoded->dictionary) {
+            flags |= PINO_FORMAT_FLAG_DICTIONARY;
+        }
+    }
+    if (padding > 0) {
+        flags |= PINO_FORMAT_FLAG_ALIGNED;
+    }
+    if (big_endian) {
+        flags |= PINO_FORMAT_FLAG_BIG_ENDIAN;
+    }
 
-    if (!pino || !dest || !pino->handler || !pino->handler->serialize) {
-        return false;
+    pmemcpy(p, pino->magic, sizeof(pino_magic_t));
+    if (((const handler_entry_t *)pino->entry)->flags & PINO_HANDLER_FLAG_COMPACT_HEADER) {
+        p[0] |= COMPACT_MAGIC_BIT;
+        p[sizeof(pino_magic_t)] = flags;
+        p += COMPACT_HEADER_BASE_SIZE;
+        p += varint_write(p, pino->static_fields_size);
+    } else {
+        word = pino->static_fields_size | (pino_static_fields_size_t)flags << FORMAT_FLAGS_SHIFT;
+        p += sizeof(pino_magic_t);
+        pmemcpy_n2l(p, &word, sizeof(pino_static_fields_size_t));
+        p += sizeof(pino_static_fields_size_t);
+    }
+
+    if (encoded) {
+        raw_size = (uint64_t)encoded->raw_size;
+        pmemcpy_n2l(p, &raw_size, sizeof(uint64_t));
+        p += sizeof(uint64_t);
+
+        if (encoded->dictionary) {
+            pmemcpy_n2l(p, &encoded->dictionary->id, sizeof(uint16_t));
+            p += sizeof(uint16_t);
+        }
     }
 
-    pmemcpy(dest, pino->magic, sizeof(pino_magic_t));
-    pmemcpy_n2l(((char *)dest) + sizeof(pino_magic_t), &pino->static_fields_size, sizeof(pino_static_fields_size_t));
+    if (padding > 0) {
+        p[0] = (uint8_t)(padding - sizeof(uint8_t));
+        memset(p + sizeof(uint8_t), 0, padding - sizeof(uint8_t));
+        p += padding;
+    }
 
     /* fields always use LE */
-    pmemcpy(((char *)dest) + sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t), pino->static_fields,
-            pino->static_fields_size);
+    pmemcpy(p, pino->static_fields, pino->static_fields_size);
+    p += pino->static_fields_size;
+
+    /* the header is hashed up front, the payload is folded in while it is written when possible */
+    context.next = NULL;
+    context.state = 0;
+    if (checksum) {
+        context.state = ~pino_crc32c(0, dest, (size_t)(p - (uint8_t *)dest));
+        context.next = p;
+    }
 
-    previous_entry = pino_handler_context_set(pino->entry);
-    result = pino->handler->serialize(pino->this, pino->static_fields,
-                                      ((char *)dest) + sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t) +
-                                          pino->handler->static_fields_size);
-    pino_handler_context_set(previous_entry);
+    if (encoded && checksum) {
+        context.state = pino_bswap_memcpy_crc32c(p, encoded->data, encoded->size, 1, context.state);
+        context.next += encoded->size;
+        result = true;
+    } else if (encoded) {
+        pmemcpy(p, encoded->data, encoded->size);
+        result = true;
+    } else {
+        previous_entry = pino_handler_context_set(pino->entry);
+        previous_context = pino_handler_checksum_set(checksum ? &context : NULL);
+        previous_big_endian = pino_handler_big_endian_set(big_endian);
+#if PINO_TRACE
+        payload_size = pino->serialize_size_cache - (size_t)(p - (uint8_t *)dest) - (checksum ? CRC32C_SIZE : 0);
+#endif
+        TRACE_BEGIN(handler_serialize, PINO_TRACE_OP_HANDLER_SERIALIZE, pino->magic, payload_size);
+        result = pino->handler->serialize(pino->this, pino->static_fields, p);
+        TRACE_END(handler_serialize, PINO_TRACE_OP_HANDLER_SERIALIZE, pino->magic, payload_size, result);
+        pino_handler_big_endian_set(previous_big_endian);
+        pino_handler_checksum_set(previous_context);
+        pino_handler_context_set(previous_entry);
+    }
+
+    /* whatever the handler wrote without PH_SERIALIZE_DATA_CHECKED is hashed here */
+    if (result && checksum) {
+        end = (uint8_t *)dest + pino->serialize_size_cache - CRC32C_SIZE;
+        if (context.next && context.next <= end) {
+            crc = pino_crc32c(~context.state, context.next, (size_t)(end - context.next));
+        } else {
+            crc = pino_crc32c(0, dest, (size_t)(end - (uint8_t *)dest));
+        }
+        pmemcpy_n2l(end, &crc, sizeof(uint32_t));
+    }
 
     return result;
 }
 
-extern pino_t *pino_unserialize(const void *src, size_t size)
+extern bool pino_serialize(const pino_t *pino, void *dest)
 {
-    pino_t *pino;
-    handler_entry_t *entry;
-    pino_handler_t *handler;
-    pino_magic_safe_t magic;
-    pino_static_fields_size_t fields_size;
+    size_t size = 0;
+    bool result = false;
+    STATS_DECLARE(start);
+
+    /* begin reports the cached size, it is refreshed before the record is written */
+    TRACE_BEGIN(serialize, PINO_TRACE_OP_SERIALIZE, TRACE_MAGIC(pino), pino ? pino->serialize_size_cache : 0);
+
+    if (pino && dest && pino->handler && pino->handler->serialize) {
+        STATS_START(start);
+
+        /* refreshes the encoded payload when compression is enabled */
+        size = serialize_size(pino, true);
+        result = size > 0 && write_record(pino, dest);
+
+        STATS_RECORD((handler_entry_t *)pino->entry, PINO_STATS_OP_SERIALIZE, size, result, start);
+    }
+
+    TRACE_END(serialize, PINO_TRACE_OP_SERIALIZE, TRACE_MAGIC(pino), size, result);
+
+    return result;
+}
+
+static inline bool serialize_n(const pino_t *pino, void *dest, size_t capacity, size_t *written)
+{
+    size_t size;
     bool result;
-    void *previous_entry;
+    STATS_DECLARE(start);
 
-    if (!src) {
-        return NULL;
+    *written = 0;
+
+    if (!pino || !pino->handler || !pino->handler->serialize) {
+        return false;
     }
 
-    if (size < sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t)) {
-        return NULL;
+    size = serialize_size(pino, true);
+    if (size == 0) {
+        return false;
     }
 
-    pmemcpy(magic, src, sizeof(pino_magic_t));
-    pmemcpy_l2n(&fields_size, ((char *)src) + sizeof(pino_magic_t), sizeof(pino_static_fields_size_t));
+    /* report the required size so the caller can retry with a larger buffer */
+    if (!dest || size > capacity) {
+        *written = size;
+        return false;
+    }
 
-    if (fields_size > size - sizeof(pino_magic_t) - sizeof(pino_static_fields_size_t)) {
-        return NULL;
+    STATS_START(start);
+    result = write_record(pino, dest);
+    STATS_RECORD((handler_entry_t *)pino->entry, PINO_STATS_OP_SERIALIZE, size, result, start);
+
+    if (!result) {
+        return false;
     }
 
-    entry = pino_handler_find_entry(magic);
-    if (!entry || !entry->handler) {
-        return NULL;
+    *written = size;
+
+    return true;
+}
+
+extern bool pino_serialize_n(const pino_t *pino, void *dest, size_t capacity, size_t *written)
+{
+    bool result;
+
+    if (!written) {
+        return false;
     }
 
+    TRACE_BEGIN(serialize, PINO_TRACE_OP_SERIALIZE, TRACE_MAGIC(pino), capacity);
+    result = serialize_n(pino, dest, capacity, written);
+    TRACE_END(serialize, PINO_TRACE_OP_SERIALIZE, TRACE_MAGIC(pino), *written, result);
+
+    return result;
+}
+
+static inline bool verify_checksum(const void *src, size_t size, const pino_peek_info_t *info)
+{
+    uint32_t crc;
+
+    if (!(info->flags & PINO_FORMAT_FLAG_CHECKSUM)) {
+        return true;
+    }
+
+    pmemcpy_l2n(&crc, ((const char *)src) + size - CRC32C_SIZE, sizeof(uint32_t));
+
+    return pino_crc32c(0, src, size - CRC32C_SIZE) == crc;
+}
+
+extern bool pino_payload_decode(const handler_entry_t *entry, const pino_peek_info_t *info, const void *src,
+                                uint8_t **raw)
+{
+    const dictionary_t *dictionary = NULL;
+
+    *raw = NULL;
+
+    if (!(info->flags & PINO_FORMAT_FLAG_COMPRESSED)) {
+        return true;
+    }
+
+    if (info->flags & PINO_FORMAT_FLAG_DICTIONARY) {
+        dictionary = pino_dictionary_find(entry, info->dictionary_id);
+        if (!dictionary) {
+            return false;
+        }
+    }
+
+    *raw = (uint8_t *)pmalloc(info->raw_payload_size > 0 ? info->raw_payload_size : 1);
+    if (!*raw) {
+        return false;
+    }
+
+    if (!pino_lz_decompress(((const char *)src) + info->payload_offset, info->payload_size,
+                            dictionary ? dictionary->data : NULL, dictionary ? dictionary->size : 0, *raw,
+                            info->raw_payload_size)) {
+        pfree(*raw);
+        *raw = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+static inline pino_t *unserialize_object(handler_entry_t *entry, pino_peek_info_t *info, const void *src, size_t size)
+{
+    pino_t *pino;
+    pino_handler_t *handler;
+    uint8_t *raw;
+    bool result, previous_big_endian;
+    void *previous_entry;
+
     handler = entry->handler;
 
-    if (fields_size != handler->static_fields_size) {
+    if (info->static_fields_size != handler->static_fields_size || !verify_checksum(src, size, info)) {
         return NULL;
     }
 
-    pino = pino_create(magic, entry, size - sizeof(pino_magic_t) - sizeof(pino_static_fields_size_t) - fields_size);
+    if (!pino_payload_decode(entry, info, src, &raw)) {
+        return NULL;
+    }
+
+    pino = pino_create(info->magic, entry, info->raw_payload_size);
     if (!pino) {
+        pfree(raw);
         return NULL;
     }
 
     /* always LE */
-    pmemcpy(pino->static_fields, ((char *)src) + sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t), fields_size);
+    pmemcpy(pino->static_fields, info->static_fields, (size_t)info->static_fields_size);
     previous_entry = pino_handler_context_set(pino->entry);
-    result =
-        handler->unserialize(pino->this, pino->static_fields,
-                             ((char *)src) + sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t) + fields_size,
-                             size - sizeof(pino_magic_t) - sizeof(pino_static_fields_size_t) - fields_size);
+    previous_big_endian = pino_handler_big_endian_set((info->flags & PINO_FORMAT_FLAG_BIG_ENDIAN) != 0);
+    TRACE_BEGIN(handler_unserialize, PINO_TRACE_OP_HANDLER_UNSERIALIZE, pino->magic, info->raw_payload_size);
+    result = handler->unserialize(pino->this, pino->static_fields,
+                                  raw ? (const void *)raw : ((const char *)src) + info->payload_offset,
+                                  info->raw_payload_size);
+    TRACE_END(handler_unserialize, PINO_TRACE_OP_HANDLER_UNSERIALIZE, pino->magic, info->raw_payload_size, result);
+    pino_handler_big_endian_set(previous_big_endian);
     pino_handler_context_set(previous_entry);
+    pino->dirty = true;
+    pfree(raw);
     if (!result) {
         pino_destroy(pino);
         return NULL;
@@ -174,19 +671,37 @@ extern pino_t *pino_unserialize(const void *src, size_t size)
     return pino;
 }
 
-extern pino_t *pino_pack(pino_magic_safe_t magic, const void *src, size_t size)
+extern pino_t *pino_unserialize(const void *src, size_t size)
 {
     pino_t *pino;
     handler_entry_t *entry;
+    pino_peek_info_t info;
+    bool known;
+    STATS_DECLARE(start);
+
+    TRACE_BEGIN(unserialize, PINO_TRACE_OP_UNSERIALIZE, NULL, size);
+
+    pino = NULL;
+    known = read_header(src, size, &info);
+    entry = known ? pino_handler_find_entry(info.magic) : NULL;
+    if (entry && entry->handler) {
+        STATS_START(start);
+        pino = unserialize_object(entry, &info, src, size);
+        STATS_RECORD(entry, PINO_STATS_OP_UNSERIALIZE, size, pino != NULL, start);
+    }
+
+    TRACE_END(unserialize, PINO_TRACE_OP_UNSERIALIZE, known ? (const char *)info.magic : NULL, size, pino != NULL);
+
+    return pino;
+}
+
+static inline pino_t *pack_object(handler_entry_t *entry, pino_magic_safe_t magic, const void *src, size_t size)
+{
+    pino_t *pino;
     pino_handler_t *handler;
     bool result;
     void *previous_entry;
 
-    entry = pino_handler_find_entry(magic);
-    if (!entry || !entry->handler) {
-        return NULL;
-    }
-
     handler = entry->handler;
 
     pino = pino_create(magic, entry, size);
@@ -194,9 +709,12 @@ extern pino_t *pino_pack(pino_magic_safe_t magic, const void *src, size_t size)
         return NULL;
     }
 
+    TRACE_BEGIN(handler_pack, PINO_TRACE_OP_HANDLER_PACK, pino->magic, size);
     previous_entry = pino_handler_context_set(pino->entry);
     result = handler->pack(pino->this, pino->static_fields, src, size);
     pino_handler_context_set(previous_entry);
+    TRACE_END(handler_pack, PINO_TRACE_OP_HANDLER_PACK, pino->magic, size, result);
+    pino->dirty = true;
     if (!result) {
         pino_destroy(pino);
         return NULL;
@@ -205,7 +723,28 @@ extern pino_t *pino_pack(pino_magic_safe_t magic, const void *src, size_t size)
     return pino;
 }
 
-extern size_t pino_unpack_size(const pino_t *pino)
+extern pino_t *pino_pack(pino_magic_safe_t magic, const void *src, size_t size)
+{
+    pino_t *pino;
+    handler_entry_t *entry;
+    STATS_DECLARE(start);
+
+    TRACE_BEGIN(pack, PINO_TRACE_OP_PACK, magic, size);
+
+    pino = NULL;
+    entry = pino_handler_find_entry(magic);
+    if (entry && entry->handler) {
+        STATS_START(start);
+        pino = pack_object(entry, magic, src, size);
+        STATS_RECORD(entry, PINO_STATS_OP_PACK, size, pino != NULL, start);
+    }
+
+    TRACE_END(pack, PINO_TRACE_OP_PACK, magic, size, pino != NULL);
+
+    return pino;
+}
+
+static inline size_t unpack_size(const pino_t *pino)
 {
     size_t size;
     void *previous_entry;
@@ -214,25 +753,53 @@ extern size_t pino_unpack_size(const pino_t *pino)
         return 0;
     }
 
+    TRACE_BEGIN(handler_unpack_size, PINO_TRACE_OP_HANDLER_UNPACK_SIZE, pino->magic, 0);
     previous_entry = pino_handler_context_set(pino->entry);
     size = pino->handler->unpack_size(pino->this, pino->static_fields);
     pino_handler_context_set(previous_entry);
+    TRACE_END(handler_unpack_size, PINO_TRACE_OP_HANDLER_UNPACK_SIZE, pino->magic, size, size != 0);
+
+    return size;
+}
+
+extern size_t pino_unpack_size(const pino_t *pino)
+{
+    size_t size;
+
+    TRACE_BEGIN(unpack_size, PINO_TRACE_OP_UNPACK_SIZE, TRACE_MAGIC(pino), 0);
+    size = unpack_size(pino);
+    TRACE_END(unpack_size, PINO_TRACE_OP_UNPACK_SIZE, TRACE_MAGIC(pino), size, size != 0);
 
     return size;
 }
 
 extern bool pino_unpack(const pino_t *pino, void *dest)
 {
-    bool result;
+#if PINO_STATS || PINO_TRACE
+    size_t size;
+#endif
+    bool result = false;
     void *previous_entry;
+    STATS_DECLARE(start);
 
-    if (!pino || !dest || !pino->handler || !pino->handler->unpack) {
-        return false;
+#if PINO_STATS || PINO_TRACE
+    /* sized up front so the stats measure the unpack alone and every event carries the size */
+    size = dest ? unpack_size(pino) : 0;
+#endif
+
+    TRACE_BEGIN(unpack, PINO_TRACE_OP_UNPACK, TRACE_MAGIC(pino), size);
+
+    if (pino && dest && pino->handler && pino->handler->unpack) {
+        STATS_START(start);
+        TRACE_BEGIN(handler_unpack, PINO_TRACE_OP_HANDLER_UNPACK, pino->magic, size);
+        previous_entry = pino_handler_context_set(pino->entry);
+        result = pino->handler->unpack(pino->this, pino->static_fields, dest);
+        pino_handler_context_set(previous_entry);
+        TRACE_END(handler_unpack, PINO_TRACE_OP_HANDLER_UNPACK, pino->magic, size, result);
+        STATS_RECORD((handler_entry_t *)pino->entry, PINO_STATS_OP_UNPACK, size, result, start);
     }
 
-    previous_entry = pino_handler_context_set(pino->entry);
-    result = pino->handler->unpack(pino->this, pino->static_fields, dest);
-    pino_handler_context_set(previous_entry);
+    TRACE_END(unpack, PINO_TRACE_OP_UNPACK, TRACE_MAGIC(pino), size, result);
 
     return result;
 }
@@ -241,35 +808,64 @@ extern void pino_destroy(pino_t *pino)
 {
     handler_entry_t *entry;
     void *previous_entry;
+#if PINO_TRACE
+    pino_magic_safe_t magic;
+#endif
+    STATS_DECLARE(start);
 
     if (!pino) {
         return;
     }
 
+    TRACE_BEGIN(destroy, PINO_TRACE_OP_DESTROY, pino->magic, 0);
+#if PINO_TRACE
+    /* the end event fires after the object is gone */
+    pmemcpy(magic, pino->magic, sizeof(pino_magic_safe_t));
+#endif
+
+    STATS_START(start);
     entry = (handler_entry_t *)pino->entry;
 
     if (pino->this) {
+        TRACE_BEGIN(handler_destroy, PINO_TRACE_OP_HANDLER_DESTROY, pino->magic, 0);
         previous_entry = pino_handler_context_set(entry);
         pino->handler->destroy(pino->this, pino->static_fields);
         pino_handler_context_set(previous_entry);
+        TRACE_END(handler_destroy, PINO_TRACE_OP_HANDLER_DESTROY, pino->magic, 0, true);
     }
 
     if (pino->static_fields) {
         pfree(pino->static_fields);
     }
 
+    pfree(pino->encoded);
     pfree(pino);
 
     if (entry) {
+        STATS_RECORD(entry, PINO_STATS_OP_DESTROY, 0, true, start);
         entry->refcount--;
         if (entry->refcount == 0 && entry->unregistered) {
             pino_memory_manager_obj_free(&entry->mm);
+            pino_dictionary_free_all(entry);
             if (entry->handler && entry->handler->entry == entry) {
                 entry->handler->entry = NULL;
             }
             pfree(entry);
         }
     }
+
+    TRACE_END(destroy, PINO_TRACE_OP_DESTROY, magic, 0, true);
+}
+
+extern void pino_touch(pino_t *pino)
+{
+    if (!pino) {
+        return;
+    }
+
+    TRACE_BEGIN(touch, PINO_TRACE_OP_TOUCH, pino->magic, 0);
+    pino->dirty = true;
+    TRACE_END(touch, PINO_TRACE_OP_TOUCH, pino->magic, 0, true);
 }
 
 extern uint32_t pino_version_id()
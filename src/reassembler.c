@@ -0,0 +1,259 @@
+/*
+ * libpino - reassembler.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pino.h>
+#include <pino/reassembler.h>
+#include <pino/handler.h>
+
+#include "internal/common.h"
+
+struct _pino_reassembler_t {
+    pino_reassembler_callback_t callback;
+    void *userdata;
+    size_t max_record_size;
+    uint8_t prefix[PINO_REASSEMBLER_PREFIX_SIZE];
+    size_t prefix_usage;
+    size_t record_size;
+    bool header_checked;
+    bool failed;
+    size_t usage;
+    size_t capacity;
+    uint8_t *buffer;
+};
+
+static inline bool check_header(const uint8_t *src, size_t available, size_t record_size)
+{
+    handler_entry_t *entry;
+    pino_magic_safe_t magic;
+    uint64_t fields_size;
+    size_t header_size;
+    uint8_t flags;
+
+    if (!header_decode(src, available, magic, &flags, &fields_size, &header_size)) {
+        return false;
+    }
+
+    if (fields_size > record_size - header_size) {
+        return false;
+    }
+
+    entry = pino_handler_find_entry(magic);
+    if (!entry || !entry->handler) {
+        return false;
+    }
+
+    return fields_size == entry->handler->static_fields_size;
+}
+
+static inline bool emit_record(pino_reassembler_t *reassembler, const uint8_t *src)
+{
+    pino_t *pino;
+
+    if (!reassembler->header_checked && !check_header(src, reassembler->record_size, reassembler->record_size)) {
+        return false;
+    }
+
+    pino = pino_unserialize(src, reassembler->record_size);
+    if (!pino) {
+        return false;
+    }
+
+    reassembler->prefix_usage = 0;
+    reassembler->usage = 0;
+    reassembler->header_checked = false;
+    reassembler->callback(pino, reassembler->userdata);
+
+    return true;
+}
+
+static inline bool glow_buffer(pino_reassembler_t *reassembler, size_t required)
+{
+    uint8_t *buffer;
+    size_t new_capacity;
+
+    if (required <= reassembler->capacity) {
+        return true;
+    }
+
+    new_capacity = reassembler->capacity > 0 ? reassembler->capacity : MM_STEP;
+    while (new_capacity < required) {
+        if (new_capacity > SIZE_MAX / 2) {
+            new_capacity = required;
+            break;
+        }
+        new_capacity *= 2;
+    }
+
+    if (new_capacity > reassembler->record_size) {
+        new_capacity = reassembler->record_size;
+    }
+
+    buffer = (uint8_t *)prealloc(reassembler->buffer, new_capacity);
+    if (!buffer) {
+        return false;
+    }
+
+    reassembler->buffer = buffer;
+    reassembler->capacity = new_capacity;
+
+    return true;
+}
+
+static inline bool read_prefix(pino_reassembler_t *reassembler)
+{
+    uint64_t record_size;
+
+    pmemcpy_l2n(&record_size, reassembler->prefix, sizeof(uint64_t));
+
+    if (record_size < HEADER_MIN_SIZE || record_size > SIZE_MAX) {
+        return false;
+    }
+
+    if (reassembler->max_record_size > 0 && record_size > reassembler->max_record_size) {
+        return false;
+    }
+
+    reassembler->record_size = (size_t)record_size;
+    reassembler->usage = 0;
+    reassembler->header_checked = false;
+
+    return true;
+}
+
+extern pino_reassembler_t *pino_reassembler_create(pino_reassembler_callback_t callback, void *userdata,
+                                                   size_t max_record_size)
+{
+    pino_reassembler_t *reassembler;
+
+    if (!callback) {
+        return NULL;
+    }
+
+    reassembler = (pino_reassembler_t *)pcalloc(1, sizeof(pino_reassembler_t));
+    if (!reassembler) {
+        return NULL;
+    }
+
+    reassembler->callback = callback;
+    reassembler->userdata = userdata;
+    reassembler->max_record_size = max_record_size;
+
+    return reassembler;
+}
+
+extern bool pino_reassembler_feed(pino_reassembler_t *reassembler, const void *bytes, size_t size)
+{
+    const uint8_t *src;
+    size_t copy_size;
+
+    if (!reassembler || reassembler->failed || (!bytes && size > 0)) {
+        return false;
+    }
+
+    src = (const uint8_t *)bytes;
+
+    while (size > 0) {
+        if (reassembler->prefix_usage < sizeof(reassembler->prefix)) {
+            copy_size = sizeof(reassembler->prefix) - reassembler->prefix_usage;
+            if (copy_size > size) {
+                copy_size = size;
+            }
+
+            pmemcpy(reassembler->prefix + reassembler->prefix_usage, src, copy_size);
+            reassembler->prefix_usage += copy_size;
+            src += copy_size;
+            size -= copy_size;
+
+            if (reassembler->prefix_usage == sizeof(reassembler->prefix) && !read_prefix(reassembler)) {
+                reassembler->failed = true;
+                return false;
+            }
+
+            continue;
+        }
+
+        /* the whole record is available in the caller buffer, no reassembly needed */
+        if (reassembler->usage == 0 && size >= reassembler->record_size) {
+            copy_size = reassembler->record_size;
+            if (!emit_record(reassembler, src)) {
+                reassembler->failed = true;
+                return false;
+            }
+
+            src += copy_size;
+            size -= copy_size;
+
+            continue;
+        }
+
+        copy_size = reassembler->record_size - reassembler->usage;
+        if (copy_size > size) {
+            copy_size = size;
+        }
+
+        if (!glow_buffer(reassembler, reassembler->usage + copy_size)) {
+            reassembler->failed = true;
+            return false;
+        }
+
+        pmemcpy(reassembler->buffer + reassembler->usage, src, copy_size);
+        reassembler->usage += copy_size;
+        src += copy_size;
+        size -= copy_size;
+
+        /* reject unknown or malformed records as soon as the header arrives, either layout fits in the maximum */
+        if (!reassembler->header_checked && reassembler->usage >= HEADER_MAX_SIZE) {
+            if (!check_header(reassembler->buffer, reassembler->usage, reassembler->record_size)) {
+                reassembler->failed = true;
+                return false;
+            }
+
+            reassembler->header_checked = true;
+        }
+
+        if (reassembler->usage == reassembler->record_size && !emit_record(reassembler, reassembler->buffer)) {
+            reassembler->failed = true;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+extern size_t pino_reassembler_buffered(const pino_reassembler_t *reassembler)
+{
+    if (!reassembler) {
+        return 0;
+    }
+
+    return reassembler->prefix_usage + reassembler->usage;
+}
+
+extern void pino_reassembler_reset(pino_reassembler_t *reassembler)
+{
+    if (!reassembler) {
+        return;
+    }
+
+    reassembler->prefix_usage = 0;
+    reassembler->record_size = 0;
+    reassembler->header_checked = false;
+    reassembler->failed = false;
+    reassembler->usage = 0;
+}
+
+extern void pino_reassembler_destroy(pino_reassembler_t *reassembler)
+{
+    if (!reassembler) {
+        return;
+    }
+
+    pfree(reassembler->buffer);
+    pfree(reassembler);
+}
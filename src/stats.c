@@ -0,0 +1,408 @@
+/*
+ * libpino - stats.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pino.h>
+#include <pino/stats.h>
+
+#include "internal/common.h"
+
+#if PINO_ALLOC_STATS
+
+#if defined(__GNUC__) || defined(__clang__)
+#define ALLOC_COUNT(counter, value) __atomic_fetch_add(&(counter), (uint64_t)(value), __ATOMIC_RELAXED)
+#define ALLOC_READ(counter)         __atomic_load_n(&(counter), __ATOMIC_RELAXED)
+#else
+#define ALLOC_COUNT(counter, value) ((counter) += (uint64_t)(value))
+#define ALLOC_READ(counter)         (counter)
+#endif
+
+static pino_stats_alloc_t g_alloc = {0, 0, 0, 0};
+
+/* failed calls are counted as well, a caller that retries still asked for the memory */
+extern void *pino_alloc_malloc(size_t size)
+{
+    ALLOC_COUNT(g_alloc.allocations, 1);
+    ALLOC_COUNT(g_alloc.bytes, size);
+
+    return malloc(size);
+}
+
+extern void *pino_alloc_calloc(size_t count, size_t size)
+{
+    ALLOC_COUNT(g_alloc.allocations, 1);
+    ALLOC_COUNT(g_alloc.bytes, count * size);
+
+    return calloc(count, size);
+}
+
+extern void *pino_alloc_realloc(void *ptr, size_t size)
+{
+    if (ptr) {
+        ALLOC_COUNT(g_alloc.reallocations, 1);
+    } else {
+        ALLOC_COUNT(g_alloc.allocations, 1);
+    }
+    ALLOC_COUNT(g_alloc.bytes, size);
+
+    return realloc(ptr, size);
+}
+
+extern void pino_alloc_free(void *ptr)
+{
+    if (ptr) {
+        ALLOC_COUNT(g_alloc.frees, 1);
+    }
+
+    free(ptr);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+extern int pino_alloc_memalign(void **ptr, size_t alignment, size_t size)
+{
+    ALLOC_COUNT(g_alloc.allocations, 1);
+    ALLOC_COUNT(g_alloc.bytes, size);
+
+    return posix_memalign(ptr, alignment, size);
+}
+#endif
+
+extern bool pino_stats_alloc(pino_stats_alloc_t *alloc)
+{
+    if (!alloc) {
+        return false;
+    }
+
+    alloc->allocations = ALLOC_READ(g_alloc.allocations);
+    alloc->reallocations = ALLOC_READ(g_alloc.reallocations);
+    alloc->frees = ALLOC_READ(g_alloc.frees);
+    alloc->bytes = ALLOC_READ(g_alloc.bytes);
+
+    return true;
+}
+
+#else
+
+extern bool pino_stats_alloc(pino_stats_alloc_t *alloc)
+{
+    if (alloc) {
+        memset(alloc, 0, sizeof(pino_stats_alloc_t));
+    }
+
+    return false;
+}
+
+#endif
+
+#if PINO_STATS
+
+#if defined(_WIN32)
+#include <windows.h>
+#define STATS_THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#include <time.h>
+#define STATS_THREAD_LOCAL __thread
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define STATS_LOAD(ptr)         __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#define STATS_STORE(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELAXED)
+#define STATS_LOAD_PTR(ptr)     __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define STATS_STORE_PTR(ptr, v) __atomic_store_n(ptr, v, __ATOMIC_RELEASE)
+#else
+/* aligned 64-bit accesses are single instructions on the targets MSVC builds for */
+#define STATS_LOAD(ptr)         (*(volatile uint64_t *)(ptr))
+#define STATS_STORE(ptr, value) (*(volatile uint64_t *)(ptr) = (value))
+#define STATS_LOAD_PTR(ptr)     (*(void *volatile *)(ptr))
+#define STATS_STORE_PTR(ptr, v) (*(void *volatile *)(ptr) = (v))
+#endif
+
+#define STATS_CACHE_LINE 64
+#define STATS_BLOCK_SIZE ((sizeof(stats_block_t) + STATS_CACHE_LINE - 1) / STATS_CACHE_LINE * STATS_CACHE_LINE)
+
+/* one thread's counters for one magic, only that thread ever writes them */
+typedef struct {
+    pino_stats_counters_t ops[PINO_STATS_OP_COUNT];
+} stats_block_t;
+
+typedef struct _stats_table_t {
+    struct _stats_table_t *next;
+    stats_block_t *blocks[PINO_STATS_MAGIC_MAX];
+    void *raw[PINO_STATS_MAGIC_MAX];
+} stats_table_t;
+
+static struct {
+#if defined(_WIN32)
+    SRWLOCK lock;
+#else
+    pthread_mutex_t lock;
+#endif
+    stats_table_t *tables;
+    pino_magic_t magics[PINO_STATS_MAGIC_MAX];
+    size_t count;
+    uint64_t generation;
+} g_stats = {
+#if defined(_WIN32)
+    SRWLOCK_INIT,
+#else
+    PTHREAD_MUTEX_INITIALIZER,
+#endif
+    NULL,
+    {{0}},
+    0,
+    1,
+};
+
+static STATS_THREAD_LOCAL stats_table_t *t_stats_table;
+static STATS_THREAD_LOCAL uint64_t t_stats_generation;
+
+static inline void stats_lock(void)
+{
+#if defined(_WIN32)
+    AcquireSRWLockExclusive(&g_stats.lock);
+#else
+    pthread_mutex_lock(&g_stats.lock);
+#endif
+}
+
+static inline void stats_unlock(void)
+{
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive(&g_stats.lock);
+#else
+    pthread_mutex_unlock(&g_stats.lock);
+#endif
+}
+
+static inline size_t bucket_of(uint64_t ns)
+{
+    size_t bucket = 0;
+
+#if defined(__GNUC__) || defined(__clang__)
+    if (ns > 1) {
+        bucket = 63 - (size_t)__builtin_clzll(ns);
+    }
+#else
+    while (ns > 1) {
+        ns >>= 1;
+        bucket++;
+    }
+#endif
+
+    return bucket < PINO_STATS_BUCKETS ? bucket : PINO_STATS_BUCKETS - 1;
+}
+
+static inline void add(uint64_t *counter, uint64_t value)
+{
+    STATS_STORE(counter, STATS_LOAD(counter) + value);
+}
+
+/* tables from before the last pino_free() have been released, the generation tells the thread to start over */
+static inline stats_table_t *current_table(void)
+{
+    stats_table_t *table;
+    uint64_t generation;
+
+    stats_lock();
+    generation = g_stats.generation;
+    if (t_stats_table && t_stats_generation == generation) {
+        stats_unlock();
+        return t_stats_table;
+    }
+
+    /* the counters never go through pcalloc(), they would show up in the allocation counts */
+    table = (stats_table_t *)calloc(1, sizeof(stats_table_t));
+    if (table) {
+        table->next = g_stats.tables;
+        g_stats.tables = table;
+    }
+    stats_unlock();
+
+    t_stats_table = table;
+    t_stats_generation = generation;
+
+    return table;
+}
+
+static inline stats_block_t *current_block(size_t slot)
+{
+    stats_table_t *table;
+    stats_block_t *block;
+    void *raw;
+
+    table = t_stats_table;
+    if (!table || t_stats_generation != STATS_LOAD(&g_stats.generation)) {
+        table = current_table();
+        if (!table) {
+            return NULL;
+        }
+    }
+
+    block = table->blocks[slot];
+    if (block) {
+        return block;
+    }
+
+    /* whole lines of its own, so neighbouring threads never share one */
+    raw = calloc(1, STATS_BLOCK_SIZE + STATS_CACHE_LINE);
+    if (!raw) {
+        return NULL;
+    }
+
+    block = (stats_block_t *)(((uintptr_t)raw + STATS_CACHE_LINE - 1) & ~(uintptr_t)(STATS_CACHE_LINE - 1));
+    table->raw[slot] = raw;
+    STATS_STORE_PTR(&table->blocks[slot], block);
+
+    return block;
+}
+
+extern size_t pino_stats_slot(pino_magic_t magic)
+{
+    size_t i, slot = PINO_STATS_MAGIC_MAX;
+
+    stats_lock();
+    for (i = 0; i < g_stats.count; i++) {
+        if (pmemcmp(g_stats.magics[i], magic, sizeof(pino_magic_t)) == 0) {
+            slot = i;
+            break;
+        }
+    }
+
+    /* the counters of a magic survive unregistering it, so slots are only handed out */
+    if (slot == PINO_STATS_MAGIC_MAX && g_stats.count < PINO_STATS_MAGIC_MAX) {
+        slot = g_stats.count++;
+        pmemcpy(g_stats.magics[slot], magic, sizeof(pino_magic_t));
+    }
+    stats_unlock();
+
+    return slot;
+}
+
+extern uint64_t pino_stats_now(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter, frequency;
+
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+extern void pino_stats_record(size_t slot, pino_stats_op_t op, uint64_t bytes, bool success, uint64_t start)
+{
+    stats_block_t *block;
+    pino_stats_counters_t *counters;
+    uint64_t now;
+
+    if (slot >= PINO_STATS_MAGIC_MAX) {
+        return;
+    }
+
+    now = pino_stats_now();
+
+    block = current_block(slot);
+    if (!block) {
+        return;
+    }
+
+    counters = &block->ops[op];
+    add(&counters->calls, 1);
+    if (success) {
+        add(&counters->bytes, bytes);
+    } else {
+        add(&counters->failures, 1);
+    }
+    add(&counters->histogram[bucket_of(now > start ? now - start : 0)], 1);
+}
+
+extern void pino_stats_free(void)
+{
+    stats_table_t *table, *next;
+    size_t i;
+
+    stats_lock();
+    for (table = g_stats.tables; table; table = next) {
+        next = table->next;
+        for (i = 0; i < PINO_STATS_MAGIC_MAX; i++) {
+            free(table->raw[i]);
+        }
+        free(table);
+    }
+
+    g_stats.tables = NULL;
+    g_stats.count = 0;
+    STATS_STORE(&g_stats.generation, g_stats.generation + 1);
+    stats_unlock();
+}
+
+extern bool pino_stats_enabled(void)
+{
+    return true;
+}
+
+extern size_t pino_stats_snapshot(pino_stats_t *stats, size_t capacity)
+{
+    stats_table_t *table;
+    stats_block_t *block;
+    const uint64_t *src;
+    uint64_t *dest;
+    size_t i, j, count, words;
+
+    words = sizeof(stats_block_t) / sizeof(uint64_t);
+
+    stats_lock();
+    count = g_stats.count;
+    for (i = 0; stats && i < count && i < capacity; i++) {
+        memset(&stats[i], 0, sizeof(pino_stats_t));
+        pmemcpy(stats[i].magic, g_stats.magics[i], sizeof(pino_magic_t));
+        stats[i].magic[sizeof(pino_magic_t)] = '\0';
+
+        /* owners keep counting while this runs, each counter is read whole but they are not read together */
+        for (table = g_stats.tables; table; table = table->next) {
+            block = (stats_block_t *)STATS_LOAD_PTR(&table->blocks[i]);
+            if (!block) {
+                continue;
+            }
+
+            src = (const uint64_t *)block->ops;
+            dest = (uint64_t *)stats[i].ops;
+            for (j = 0; j < words; j++) {
+                dest[j] += STATS_LOAD(&src[j]);
+            }
+        }
+    }
+    stats_unlock();
+
+    return count;
+}
+
+#else
+
+extern bool pino_stats_enabled(void)
+{
+    return false;
+}
+
+extern size_t pino_stats_snapshot(pino_stats_t *stats, size_t capacity)
+{
+    (void)stats;
+    (void)capacity;
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ * libpino - trace.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pino.h>
+#include <pino/trace.h>
+
+#include "internal/common.h"
+
+/* also the USDT probe names, with _begin and _end appended */
+static const char *g_trace_op_names[PINO_TRACE_OP_COUNT] = {
+    "peek",
+    "serialize_size",
+    "serialize",
+    "unserialize",
+    "pack",
+    "unpack_size",
+    "unpack",
+    "destroy",
+    "touch",
+    "handler_create",
+    "handler_destroy",
+    "handler_pack",
+    "handler_unpack_size",
+    "handler_unpack",
+    "handler_serialize_size",
+    "handler_serialize",
+    "handler_unserialize",
+};
+
+extern const char *pino_trace_op_name(pino_trace_op_t op)
+{
+    if ((size_t)op >= PINO_TRACE_OP_COUNT) {
+        return NULL;
+    }
+
+    return g_trace_op_names[op];
+}
+
+#if PINO_TRACE
+
+pino_trace_hook_t pino_trace_hook = NULL;
+static void *g_trace_user_data = NULL;
+
+extern void pino_trace_emit(pino_trace_op_t op, pino_trace_phase_t phase, const char *magic, size_t size,
+                            bool result)
+{
+    pino_trace_event_t event;
+    pino_trace_hook_t hook;
+    size_t i;
+
+    hook = pino_trace_hook;
+    if (!hook) {
+        return;
+    }
+
+    event.op = op;
+    event.phase = phase;
+    event.size = size;
+    event.result = result;
+
+    memset(event.magic, 0, sizeof(pino_magic_safe_t));
+    for (i = 0; magic && i < sizeof(pino_magic_t) && magic[i] != '\0'; i++) {
+        event.magic[i] = magic[i];
+    }
+
+    hook(&event, g_trace_user_data);
+}
+
+extern bool pino_trace_enabled(void)
+{
+    return true;
+}
+
+extern bool pino_trace_set_hook(pino_trace_hook_t hook, void *user_data)
+{
+    g_trace_user_data = user_data;
+    pino_trace_hook = hook;
+
+    return true;
+}
+
+#else
+
+extern bool pino_trace_enabled(void)
+{
+    return false;
+}
+
+extern bool pino_trace_set_hook(pino_trace_hook_t hook, void *user_data)
+{
+    (void)hook;
+    (void)user_data;
+
+    return false;
+}
+
+#endif
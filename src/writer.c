@@ -0,0 +1,785 @@
+/*
+ * libpino - writer.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <pino.h>
+#include <pino/buffer.h>
+#include <pino/writer.h>
+
+#include "internal/common.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define PINO_WRITER_POSIX 1
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#else
+#define PINO_WRITER_POSIX 0
+#endif
+
+#ifndef PINO_WRITER_THREADS
+#define PINO_WRITER_THREADS 0
+#endif
+
+#ifndef PINO_WRITER_IO_URING
+#define PINO_WRITER_IO_URING 0
+#endif
+
+#if PINO_WRITER_POSIX && PINO_WRITER_THREADS
+#include <pthread.h>
+#endif
+
+#if PINO_WRITER_POSIX && PINO_WRITER_IO_URING && defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define WRITER_URING 1
+#endif
+#endif
+
+#ifndef WRITER_URING
+#define WRITER_URING 0
+#endif
+
+/* a single write is in flight at a time, the ring never needs more */
+#define WRITER_URING_ENTRIES 4
+
+#if PINO_WRITER_POSIX
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t done;
+    uint64_t offset;
+    struct iovec iov;
+} batch_t;
+
+#if WRITER_URING
+typedef struct {
+    int fd;
+    void *sq_ring;
+    void *cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+} uring_t;
+#endif
+
+struct _pino_writer_t {
+    int fd;
+    pino_writer_backend_t backend;
+    pino_writer_sync_t sync;
+    size_t buffer_size;
+    uint64_t offset;      /* end of the accepted bytes */
+    uint64_t file_offset; /* end of the submitted bytes */
+    batch_t batches[2];
+    size_t current;
+    batch_t *in_flight;
+    pino_buffer_t scratch;
+    bool failed;
+#if WRITER_URING
+    uring_t ring;
+#endif
+#if PINO_WRITER_THREADS
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    batch_t *pending;
+    bool stop;
+    bool thread_failed;
+#endif
+};
+
+static inline bool writev_all(int fd, struct iovec *iov, int count, uint64_t offset)
+{
+    ssize_t written;
+    size_t left;
+
+    while (count > 0) {
+        written = pwritev(fd, iov, count, (off_t)offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (written == 0) {
+            return false;
+        }
+
+        offset += (uint64_t)written;
+        left = (size_t)written;
+        while (count > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+
+    return true;
+}
+
+static inline bool write_batch(int fd, batch_t *batch)
+{
+    batch->iov.iov_base = batch->data + batch->done;
+    batch->iov.iov_len = batch->size - batch->done;
+
+    return writev_all(fd, &batch->iov, 1, batch->offset + batch->done);
+}
+
+#if WRITER_URING
+static inline int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static inline void uring_free(uring_t *ring)
+{
+    if (ring->sqes) {
+        munmap(ring->sqes, ring->sqes_size);
+    }
+    if (ring->cq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sq_ring) {
+        munmap(ring->sq_ring, ring->sq_ring_size);
+    }
+    if (ring->fd >= 0) {
+        close(ring->fd);
+    }
+
+    ring->fd = -1;
+}
+
+static inline bool uring_init(uring_t *ring)
+{
+    struct io_uring_params params;
+    void *p;
+
+    memset(ring, 0, sizeof(uring_t));
+    memset(&params, 0, sizeof(params));
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, WRITER_URING_ENTRIES, &params);
+    if (ring->fd < 0) {
+        return false;
+    }
+
+    /* the rings are mapped separately, which every kernel with io_uring accepts */
+    ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    p = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, IORING_OFF_SQ_RING);
+    if (p == MAP_FAILED) {
+        uring_free(ring);
+        return false;
+    }
+    ring->sq_ring = p;
+
+    p = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, IORING_OFF_CQ_RING);
+    if (p == MAP_FAILED) {
+        uring_free(ring);
+        return false;
+    }
+    ring->cq_ring = p;
+
+    p = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, IORING_OFF_SQES);
+    if (p == MAP_FAILED) {
+        uring_free(ring);
+        return false;
+    }
+    ring->sqes = (struct io_uring_sqe *)p;
+
+    ring->sq_tail = (unsigned *)((uint8_t *)ring->sq_ring + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)((uint8_t *)ring->sq_ring + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)((uint8_t *)ring->sq_ring + params.sq_off.array);
+    ring->cq_head = (unsigned *)((uint8_t *)ring->cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned *)((uint8_t *)ring->cq_ring + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)((uint8_t *)ring->cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)((uint8_t *)ring->cq_ring + params.cq_off.cqes);
+
+    return true;
+}
+
+static inline bool uring_submit(uring_t *ring, int fd, batch_t *batch)
+{
+    struct io_uring_sqe *sqe;
+    unsigned tail, index;
+    int result;
+
+    batch->iov.iov_base = batch->data + batch->done;
+    batch->iov.iov_len = batch->size - batch->done;
+
+    /* only this thread produces entries, the kernel reads the tail */
+    tail = *ring->sq_tail;
+    index = tail & *ring->sq_mask;
+    sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)&batch->iov;
+    sqe->len = 1;
+    sqe->off = batch->offset + batch->done;
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    do {
+        result = uring_enter(ring->fd, 1, 0, 0);
+    } while (result < 0 && errno == EINTR);
+
+    return result == 1;
+}
+
+static inline bool uring_wait(uring_t *ring, int32_t *res)
+{
+    unsigned head;
+
+    for (;;) {
+        head = *ring->cq_head;
+        if (head != __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+            *res = ring->cqes[head & *ring->cq_mask].res;
+            __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+
+        if (uring_enter(ring->fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+/* entries left in a ring whose submission failed are dropped with it, later writes are synchronous */
+static inline void uring_degrade(pino_writer_t *writer)
+{
+    uring_free(&writer->ring);
+    writer->backend = PINO_WRITER_BACKEND_SYNC;
+}
+
+static inline bool uring_complete(pino_writer_t *writer, batch_t *batch)
+{
+    int32_t res;
+
+    while (batch->done < batch->size) {
+        if (!uring_wait(&writer->ring, &res)) {
+            return false;
+        }
+
+        if (res == -EINTR || res == -EAGAIN) {
+            res = 0;
+        } else if (res <= 0) {
+            /* the plain syscall retries the remainder and reports the real error */
+            return write_batch(writer->fd, batch);
+        }
+
+        /* short writes are resubmitted from where they stopped */
+        batch->done += (size_t)res;
+        if (batch->done < batch->size && !uring_submit(&writer->ring, writer->fd, batch)) {
+            uring_degrade(writer);
+            return write_batch(writer->fd, batch);
+        }
+    }
+
+    return true;
+}
+#endif
+
+#if PINO_WRITER_THREADS
+static void *worker_main(void *arg)
+{
+    pino_writer_t *writer = (pino_writer_t *)arg;
+    batch_t *batch;
+    bool result;
+
+    pthread_mutex_lock(&writer->mutex);
+    for (;;) {
+        while (!writer->pending && !writer->stop) {
+            pthread_cond_wait(&writer->cond, &writer->mutex);
+        }
+
+        if (!writer->pending) {
+            break;
+        }
+
+        batch = writer->pending;
+        pthread_mutex_unlock(&writer->mutex);
+        result = write_batch(writer->fd, batch);
+        pthread_mutex_lock(&writer->mutex);
+
+        if (!result) {
+            writer->thread_failed = true;
+        }
+        writer->pending = NULL;
+        pthread_cond_broadcast(&writer->cond);
+    }
+    pthread_mutex_unlock(&writer->mutex);
+
+    return NULL;
+}
+
+static inline bool thread_init(pino_writer_t *writer)
+{
+    if (pthread_mutex_init(&writer->mutex, NULL) != 0) {
+        return false;
+    }
+
+    if (pthread_cond_init(&writer->cond, NULL) != 0) {
+        pthread_mutex_destroy(&writer->mutex);
+        return false;
+    }
+
+    if (pthread_create(&writer->thread, NULL, worker_main, writer) != 0) {
+        pthread_cond_destroy(&writer->cond);
+        pthread_mutex_destroy(&writer->mutex);
+        return false;
+    }
+
+    return true;
+}
+
+static inline void thread_free(pino_writer_t *writer)
+{
+    pthread_mutex_lock(&writer->mutex);
+    writer->stop = true;
+    pthread_cond_broadcast(&writer->cond);
+    pthread_mutex_unlock(&writer->mutex);
+
+    pthread_join(writer->thread, NULL);
+    pthread_cond_destroy(&writer->cond);
+    pthread_mutex_destroy(&writer->mutex);
+}
+#endif
+
+/* waits for the batch in flight, the other buffer is free afterwards */
+static inline bool complete(pino_writer_t *writer)
+{
+    batch_t *batch = writer->in_flight;
+    bool result = true;
+
+    if (!batch) {
+        return true;
+    }
+
+    writer->in_flight = NULL;
+
+    switch (writer->backend) {
+#if WRITER_URING
+    case PINO_WRITER_BACKEND_IO_URING:
+        result = uring_complete(writer, batch);
+        break;
+#endif
+#if PINO_WRITER_THREADS
+    case PINO_WRITER_BACKEND_THREAD:
+        pthread_mutex_lock(&writer->mutex);
+        while (writer->pending) {
+            pthread_cond_wait(&writer->cond, &writer->mutex);
+        }
+        result = !writer->thread_failed;
+        writer->thread_failed = false;
+        pthread_mutex_unlock(&writer->mutex);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    if (!result) {
+        writer->failed = true;
+    }
+
+    return result;
+}
+
+static inline bool submit(pino_writer_t *writer)
+{
+    batch_t *batch = &writer->batches[writer->current];
+    bool result = true;
+
+    if (batch->size == 0) {
+        return true;
+    }
+
+    if (!complete(writer)) {
+        return false;
+    }
+
+    batch->done = 0;
+    batch->offset = writer->file_offset;
+    writer->file_offset += batch->size;
+
+    switch (writer->backend) {
+#if WRITER_URING
+    case PINO_WRITER_BACKEND_IO_URING:
+        if (uring_submit(&writer->ring, writer->fd, batch)) {
+            writer->in_flight = batch;
+        } else {
+            uring_degrade(writer);
+            result = write_batch(writer->fd, batch);
+        }
+        break;
+#endif
+#if PINO_WRITER_THREADS
+    case PINO_WRITER_BACKEND_THREAD:
+        pthread_mutex_lock(&writer->mutex);
+        writer->pending = batch;
+        pthread_cond_broadcast(&writer->cond);
+        pthread_mutex_unlock(&writer->mutex);
+        writer->in_flight = batch;
+        break;
+#endif
+    default:
+        result = write_batch(writer->fd, batch);
+        break;
+    }
+
+    if (!result) {
+        writer->failed = true;
+        return false;
+    }
+
+    /* serialization continues into the other buffer while this one is written */
+    writer->current ^= 1;
+    writer->batches[writer->current].size = 0;
+
+    return true;
+}
+
+/* records larger than a buffer are written right after the pending bytes in one call */
+static inline bool write_direct(pino_writer_t *writer, const void *src, size_t size)
+{
+    batch_t *batch = &writer->batches[writer->current];
+    struct iovec iov[2];
+    int count = 0;
+
+    if (!complete(writer)) {
+        return false;
+    }
+
+    if (batch->size > 0) {
+        iov[count].iov_base = batch->data;
+        iov[count].iov_len = batch->size;
+        count++;
+    }
+    iov[count].iov_base = (void *)src;
+    iov[count].iov_len = size;
+    count++;
+
+    if (!writev_all(writer->fd, iov, count, writer->file_offset)) {
+        writer->failed = true;
+        return false;
+    }
+
+    writer->file_offset += batch->size + size;
+    writer->offset += size;
+    batch->size = 0;
+
+    return true;
+}
+
+static inline bool select_backend(pino_writer_t *writer, pino_writer_backend_t backend)
+{
+#if WRITER_URING
+    if (backend == PINO_WRITER_BACKEND_AUTO || backend == PINO_WRITER_BACKEND_IO_URING) {
+        if (uring_init(&writer->ring)) {
+            writer->backend = PINO_WRITER_BACKEND_IO_URING;
+            return true;
+        }
+    }
+#endif
+
+#if PINO_WRITER_THREADS
+    if (backend == PINO_WRITER_BACKEND_AUTO || backend == PINO_WRITER_BACKEND_THREAD) {
+        if (thread_init(writer)) {
+            writer->backend = PINO_WRITER_BACKEND_THREAD;
+            return true;
+        }
+    }
+#endif
+
+    if (backend == PINO_WRITER_BACKEND_AUTO || backend == PINO_WRITER_BACKEND_SYNC) {
+        writer->backend = PINO_WRITER_BACKEND_SYNC;
+        return true;
+    }
+
+    return false;
+}
+
+extern pino_writer_t *pino_writer_create(int fd, const pino_writer_options_t *options)
+{
+    pino_writer_t *writer;
+    pino_writer_options_t defaults = {0};
+    off_t position;
+    size_t i;
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (!options) {
+        options = &defaults;
+    }
+
+    /* records are written with explicit offsets, so the file must be seekable */
+    position = lseek(fd, 0, SEEK_CUR);
+    if (position < 0) {
+        return NULL;
+    }
+
+    writer = (pino_writer_t *)pcalloc(1, sizeof(pino_writer_t));
+    if (!writer) {
+        return NULL;
+    }
+
+    writer->fd = fd;
+    writer->sync = options->sync;
+    writer->offset = (uint64_t)position;
+    writer->file_offset = (uint64_t)position;
+    writer->buffer_size = options->buffer_size > 0 ? options->buffer_size : PINO_WRITER_BUFFER_SIZE_DEFAULT;
+    if (writer->buffer_size > SIZE_MAX - PINO_WRITER_BUFFER_ALIGNMENT) {
+        pfree(writer);
+        return NULL;
+    }
+    writer->buffer_size = (writer->buffer_size + PINO_WRITER_BUFFER_ALIGNMENT - 1) &
+                          ~((size_t)PINO_WRITER_BUFFER_ALIGNMENT - 1);
+
+    for (i = 0; i < 2; i++) {
+        if (pmemalign((void **)&writer->batches[i].data, PINO_WRITER_BUFFER_ALIGNMENT, writer->buffer_size) != 0) {
+            writer->batches[i].data = NULL;
+            pfree(writer->batches[0].data);
+            pfree(writer);
+            return NULL;
+        }
+    }
+
+    if (!select_backend(writer, options->backend)) {
+        pfree(writer->batches[0].data);
+        pfree(writer->batches[1].data);
+        pfree(writer);
+        return NULL;
+    }
+
+    return writer;
+}
+
+extern bool pino_writer_add_raw(pino_writer_t *writer, const void *src, size_t size)
+{
+    batch_t *batch;
+
+    if (!writer || writer->failed || (!src && size > 0)) {
+        return false;
+    }
+
+    if (size == 0) {
+        return true;
+    }
+
+    if (size > writer->buffer_size) {
+        return write_direct(writer, src, size);
+    }
+
+    if (size > writer->buffer_size - writer->batches[writer->current].size && !submit(writer)) {
+        return false;
+    }
+
+    batch = &writer->batches[writer->current];
+    pmemcpy(batch->data + batch->size, src, size);
+    batch->size += size;
+    writer->offset += size;
+
+    return true;
+}
+
+extern bool pino_writer_add(pino_writer_t *writer, const pino_t *pino)
+{
+    batch_t *batch;
+    size_t size;
+
+    if (!writer || writer->failed) {
+        return false;
+    }
+
+    size = pino_serialize_size(pino);
+    if (size == 0) {
+        return false;
+    }
+
+    if (size > writer->buffer_size) {
+        pino_buffer_reset(&writer->scratch);
+        return pino_buffer_append(&writer->scratch, pino) &&
+               write_direct(writer, writer->scratch.data, writer->scratch.size);
+    }
+
+    if (size > writer->buffer_size - writer->batches[writer->current].size && !submit(writer)) {
+        return false;
+    }
+
+    /* serialized straight into the batch buffer, bounded in case the payload changed since it was sized */
+    batch = &writer->batches[writer->current];
+    if (!pino_serialize_n(pino, batch->data + batch->size, writer->buffer_size - batch->size, &size)) {
+        return false;
+    }
+    batch->size += size;
+    writer->offset += size;
+
+    return true;
+}
+
+extern bool pino_writer_flush(pino_writer_t *writer)
+{
+    int result = 0;
+
+    if (!writer || writer->failed) {
+        return false;
+    }
+
+    if (!submit(writer) || !complete(writer)) {
+        return false;
+    }
+
+    switch (writer->sync) {
+    case PINO_WRITER_SYNC_DATA:
+#if defined(__APPLE__)
+        result = fsync(writer->fd);
+#else
+        result = fdatasync(writer->fd);
+#endif
+        break;
+    case PINO_WRITER_SYNC_FULL:
+        result = fsync(writer->fd);
+        break;
+    default:
+        break;
+    }
+
+    if (result != 0) {
+        writer->failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+extern bool pino_writer_close(pino_writer_t *writer)
+{
+    bool result;
+
+    if (!writer) {
+        return false;
+    }
+
+    result = pino_writer_flush(writer);
+
+    /* a failed flush may leave a batch in flight, it must finish before the buffers go away */
+    complete(writer);
+
+#if WRITER_URING
+    if (writer->backend == PINO_WRITER_BACKEND_IO_URING) {
+        uring_free(&writer->ring);
+    }
+#endif
+#if PINO_WRITER_THREADS
+    if (writer->backend == PINO_WRITER_BACKEND_THREAD) {
+        thread_free(writer);
+    }
+#endif
+
+    pfree(writer->batches[0].data);
+    pfree(writer->batches[1].data);
+    pino_buffer_free(&writer->scratch);
+    pfree(writer);
+
+    return result;
+}
+
+extern pino_writer_backend_t pino_writer_backend(const pino_writer_t *writer)
+{
+    if (!writer) {
+        return PINO_WRITER_BACKEND_AUTO;
+    }
+
+    return writer->backend;
+}
+
+extern uint64_t pino_writer_offset(const pino_writer_t *writer)
+{
+    if (!writer) {
+        return 0;
+    }
+
+    return writer->offset;
+}
+#else
+struct _pino_writer_t {
+    int unused;
+};
+
+extern pino_writer_t *pino_writer_create(int fd, const pino_writer_options_t *options)
+{
+    (void)fd;
+    (void)options;
+
+    return NULL;
+}
+
+extern bool pino_writer_add_raw(pino_writer_t *writer, const void *src, size_t size)
+{
+    (void)writer;
+    (void)src;
+    (void)size;
+
+    return false;
+}
+
+extern bool pino_writer_add(pino_writer_t *writer, const pino_t *pino)
+{
+    (void)writer;
+    (void)pino;
+
+    return false;
+}
+
+extern bool pino_writer_flush(pino_writer_t *writer)
+{
+    (void)writer;
+
+    return false;
+}
+
+extern bool pino_writer_close(pino_writer_t *writer)
+{
+    (void)writer;
+
+    return false;
+}
+
+extern pino_writer_backend_t pino_writer_backend(const pino_writer_t *writer)
+{
+    (void)writer;
+
+    return PINO_WRITER_BACKEND_AUTO;
+}
+
+extern uint64_t pino_writer_offset(const pino_writer_t *writer)
+{
+    (void)writer;
+
+    return 0;
+}
+#endif
@@ -0,0 +1,104 @@
+/*
+ * libpino - handler_f64a.h
+ *
+ * This file is part of libpino.
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef PINO_TESTS_HANDLER_F64A_H
+#define PINO_TESTS_HANDLER_F64A_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+#define F64A_ALIGNMENT 32
+
+PH_BEGIN(f64a);
+
+PH_DEF_STATIC_FIELDS_STRUCT(f64a)
+{
+    uint8_t count;
+}
+PH_DEF_STATIC_FIELDS_STRUCT_END;
+
+PH_DEF_STRUCT(f64a)
+{
+    double *values;
+    size_t size;
+}
+PH_DEF_STRUCT_END;
+
+PH_DEFUN_SERIALIZE_SIZE(f64a)
+{
+    return PH_THIS(f64a)->size;
+}
+
+PH_DEFUN_SERIALIZE(f64a)
+{
+    PH_SERIALIZE_DATA_ORDERED(f64a, values, PH_THIS(f64a)->size);
+    return true;
+}
+
+PH_DEFUN_UNSERIALIZE(f64a)
+{
+    PH_UNSERIALIZE_DATA_ORDERED(f64a, values, PH_THIS(f64a)->size);
+    return true;
+}
+
+PH_DEFUN_PACK(f64a)
+{
+    if (PH_ARG_SIZE != PH_THIS(f64a)->size) {
+        return false;
+    }
+
+    PH_PACK_DATA(f64a, values, PH_ARG_SIZE);
+    return true;
+}
+
+PH_DEFUN_UNPACK_SIZE(f64a)
+{
+    return PH_THIS(f64a)->size;
+}
+
+PH_DEFUN_UNPACK(f64a)
+{
+    PH_UNPACK_DATA(f64a, values, PH_THIS(f64a)->size);
+    return true;
+}
+
+PH_DEFUN_CREATE(f64a)
+{
+    uint8_t count = (uint8_t)(PH_ARG_SIZE / sizeof(double));
+
+    PH_CREATE_THIS(f64a);
+
+    if (PH_ARG_SIZE % sizeof(double) != 0 || PH_ARG_SIZE / sizeof(double) > UINT8_MAX) {
+        PH_DESTROY_THIS(f64a);
+        return NULL;
+    }
+
+    PH_THIS(f64a)->values = (double *)PH_CALLOC(f64a, 1, PH_ARG_SIZE);
+    if (!PH_THIS(f64a)->values) {
+        PH_DESTROY_THIS(f64a);
+        return NULL;
+    }
+
+    PH_THIS(f64a)->size = PH_ARG_SIZE;
+    PH_THIS_STATIC_SET(f64a, count, &count);
+
+    return PH_THIS(f64a);
+}
+
+PH_DEFUN_DESTROY(f64a)
+{
+    PH_FREE(f64a, PH_THIS(f64a)->values);
+    PH_DESTROY_THIS(f64a);
+}
+
+PH_END_ALIGNED(f64a, F64A_ALIGNMENT);
+
+#endif /* PINO_TESTS_HANDLER_F64A_H */
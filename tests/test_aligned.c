@@ -0,0 +1,188 @@
+/*
+ * libpino - test_aligned.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+#include "handler_f64a.h"
+#include "handler_spl1.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_VALUES 32
+
+/* records are laid out relative to their start, so the buffer itself must be on the boundary */
+static uint8_t *serialize_aligned(const pino_t *pino, uint8_t **base, size_t *size)
+{
+    uint8_t *record;
+
+    *size = pino_serialize_size(pino);
+    TEST_ASSERT_GREATER_THAN_size_t(0, *size);
+
+    *base = (uint8_t *)malloc(*size + PINO_PAYLOAD_ALIGNMENT_MAX);
+    TEST_ASSERT_NOT_NULL(*base);
+
+    record = *base + (PINO_PAYLOAD_ALIGNMENT_MAX - (uintptr_t)*base % PINO_PAYLOAD_ALIGNMENT_MAX);
+    TEST_ASSERT_TRUE(pino_serialize(pino, record));
+
+    return record;
+}
+
+static pino_t *pack_values(double *values, size_t count)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        values[i] = (double)i * 0.5 - 3.0;
+    }
+
+    return pino_pack("f64a", values, count * sizeof(double));
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(f64a) || !PH_REG(spl1)) {
+        TEST_FAIL();
+    }
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(f64a) || !PH_UNREG(spl1)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_layout(void)
+{
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    double values[TEST_VALUES], decoded[TEST_VALUES];
+    uint32_t flags[] = {0, PINO_HANDLER_FLAG_CHECKSUM, PINO_HANDLER_FLAG_COMPACT_HEADER,
+                        PINO_HANDLER_FLAG_COMPACT_HEADER | PINO_HANDLER_FLAG_CHECKSUM};
+    uint8_t *base, *record;
+    size_t size, count, i;
+
+    for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+        TEST_ASSERT_TRUE(pino_handler_set_flags("f64a", flags[i]));
+
+        for (count = 1; count <= TEST_VALUES; count += 3) {
+            pino = pack_values(values, count);
+            TEST_ASSERT_NOT_NULL(pino);
+
+            record = serialize_aligned(pino, &base, &size);
+            TEST_ASSERT_TRUE(pino_peek(record, size, &info));
+            TEST_ASSERT_EQUAL_HEX8(PINO_FORMAT_FLAG_ALIGNED, info.flags & PINO_FORMAT_FLAG_ALIGNED);
+            TEST_ASSERT_EQUAL_size_t(0, info.payload_offset % F64A_ALIGNMENT);
+            TEST_ASSERT_EQUAL_size_t(count * sizeof(double), info.payload_size);
+            TEST_ASSERT_EQUAL_UINT8(count, *(const uint8_t *)info.static_fields);
+            TEST_ASSERT_EQUAL_size_t(0, (uintptr_t)(record + info.payload_offset) % F64A_ALIGNMENT);
+
+            /* the payload is readable in place */
+            PH_MEMCPY_L2N(decoded, record + info.payload_offset, info.payload_size);
+            TEST_ASSERT_EQUAL_MEMORY(values, decoded, info.payload_size);
+
+            restored = pino_unserialize(record, size);
+            TEST_ASSERT_NOT_NULL(restored);
+            TEST_ASSERT_EQUAL_size_t(count * sizeof(double), pino_unpack_size(restored));
+            TEST_ASSERT_TRUE(pino_unpack(restored, decoded));
+            TEST_ASSERT_EQUAL_MEMORY(values, decoded, count * sizeof(double));
+            pino_destroy(restored);
+
+            free(base);
+            pino_destroy(pino);
+        }
+    }
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("f64a", 0));
+}
+
+void test_unaligned_handlers(void)
+{
+    pino_t *pino;
+    pino_peek_info_t info;
+    double values[TEST_VALUES];
+    uint8_t data[16], *base, *record;
+    size_t size;
+
+    /* handlers without a boundary keep the plain layout */
+    memset(data, 'a', sizeof(data));
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+    record = serialize_aligned(pino, &base, &size);
+    TEST_ASSERT_TRUE(pino_peek(record, size, &info));
+    TEST_ASSERT_EQUAL_HEX8(0, info.flags);
+    free(base);
+    pino_destroy(pino);
+
+    /* compressed payloads are not typed, no padding is spent on them */
+    TEST_ASSERT_TRUE(pino_handler_set_flags("f64a", PINO_HANDLER_FLAG_COMPRESS));
+    memset(values, 0, sizeof(values));
+    pino = pino_pack("f64a", values, sizeof(values));
+    TEST_ASSERT_NOT_NULL(pino);
+    record = serialize_aligned(pino, &base, &size);
+    TEST_ASSERT_TRUE(pino_peek(record, size, &info));
+    TEST_ASSERT_EQUAL_HEX8(0, info.flags & PINO_FORMAT_FLAG_ALIGNED);
+    free(base);
+    pino_destroy(pino);
+    TEST_ASSERT_TRUE(pino_handler_set_flags("f64a", 0));
+}
+
+void test_invalid(void)
+{
+    pino_handler_t handler;
+    pino_t *pino;
+    pino_peek_info_t info;
+    double values[TEST_VALUES];
+    uint8_t *base, *record, padding;
+    size_t size;
+
+    /* boundaries must be a power of two no larger than PINO_PAYLOAD_ALIGNMENT_MAX */
+    handler = PH_NAME_HANDLER(f64a);
+    handler.payload_alignment = 24;
+    TEST_ASSERT_FALSE(pino_handler_register("f64b", &handler));
+    handler.payload_alignment = PINO_PAYLOAD_ALIGNMENT_MAX * 2;
+    TEST_ASSERT_FALSE(pino_handler_register("f64b", &handler));
+
+    pino = pack_values(values, TEST_VALUES);
+    TEST_ASSERT_NOT_NULL(pino);
+    record = serialize_aligned(pino, &base, &size);
+
+    /* the padding count follows the fixed header */
+    padding = record[sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t)];
+    TEST_ASSERT_TRUE(padding < F64A_ALIGNMENT);
+
+    record[sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t)] = PINO_PAYLOAD_ALIGNMENT_MAX;
+    TEST_ASSERT_FALSE(pino_peek(record, size, &info));
+    TEST_ASSERT_NULL(pino_unserialize(record, size));
+    record[sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t)] = padding;
+
+    /* truncated inside the padding */
+    TEST_ASSERT_FALSE(pino_peek(record, sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t) + padding, &info));
+    TEST_ASSERT_TRUE(pino_peek(record, size, &info));
+
+    free(base);
+    pino_destroy(pino);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_layout);
+    RUN_TEST(test_unaligned_handlers);
+    RUN_TEST(test_invalid);
+
+    return UNITY_END();
+}
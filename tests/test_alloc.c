@@ -0,0 +1,199 @@
+/*
+ * libpino - test_alloc.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+#include <pino/stats.h>
+
+#include "handler_f64a.h"
+#include "handler_u32a.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_VALUES 32
+
+static pino_stats_alloc_t g_mark;
+
+static void mark(void)
+{
+    TEST_ASSERT_TRUE(pino_stats_alloc(&g_mark));
+}
+
+/* the counts since the last mark() must match exactly, any new allocation on these paths is a regression */
+static void assert_allocs(uint64_t allocations, uint64_t frees)
+{
+    pino_stats_alloc_t now;
+
+    TEST_ASSERT_TRUE(pino_stats_alloc(&now));
+    TEST_ASSERT_EQUAL_UINT64(allocations, now.allocations - g_mark.allocations);
+    TEST_ASSERT_EQUAL_UINT64(0, now.reallocations - g_mark.reallocations);
+    TEST_ASSERT_EQUAL_UINT64(frees, now.frees - g_mark.frees);
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(u32a) || !PH_REG(f64a)) {
+        TEST_FAIL();
+    }
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(u32a) || !PH_UNREG(f64a)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_counting(void)
+{
+    pino_stats_alloc_t before, after;
+    pino_t *pino;
+    uint32_t words[2] = {1, 2};
+
+    TEST_ASSERT_FALSE(pino_stats_alloc(NULL));
+    TEST_ASSERT_TRUE(pino_stats_alloc(&before));
+
+    pino = pino_pack("u32a", words, sizeof(words));
+    TEST_ASSERT_NOT_NULL(pino);
+    pino_destroy(pino);
+
+    TEST_ASSERT_TRUE(pino_stats_alloc(&after));
+    TEST_ASSERT_TRUE(after.allocations > before.allocations);
+    TEST_ASSERT_TRUE(after.bytes > before.bytes);
+    TEST_ASSERT_EQUAL_UINT64(after.allocations - before.allocations, after.frees - before.frees);
+}
+
+void test_inline(void)
+{
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    uint32_t words[2] = {0x01234567, 0x89abcdef}, unpacked[2];
+    uint8_t buffer[256];
+    size_t size;
+
+    /* the object, its static fields and the handler struct */
+    mark();
+    pino = pino_pack("u32a", words, sizeof(words));
+    TEST_ASSERT_NOT_NULL(pino);
+    assert_allocs(3, 0);
+
+    mark();
+    size = pino_serialize_size(pino);
+    TEST_ASSERT_TRUE(size <= sizeof(buffer));
+    TEST_ASSERT_TRUE(pino_serialize(pino, buffer));
+    TEST_ASSERT_TRUE(pino_peek(buffer, size, &info));
+    assert_allocs(0, 0);
+
+    mark();
+    restored = pino_unserialize(buffer, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    assert_allocs(3, 0);
+
+    mark();
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(words, unpacked, sizeof(words));
+    assert_allocs(0, 0);
+
+    mark();
+    pino_destroy(restored);
+    pino_destroy(pino);
+    assert_allocs(0, 6);
+}
+
+void test_external(void)
+{
+    pino_t *pino, *restored;
+    double values[TEST_VALUES], unpacked[TEST_VALUES];
+    uint8_t buffer[1024];
+    size_t size, i;
+
+    for (i = 0; i < TEST_VALUES; i++) {
+        values[i] = (double)i * 0.25;
+    }
+
+    /* the values live in a block of their own */
+    mark();
+    pino = pino_pack("f64a", values, sizeof(values));
+    TEST_ASSERT_NOT_NULL(pino);
+    assert_allocs(4, 0);
+
+    mark();
+    size = pino_serialize_size(pino);
+    TEST_ASSERT_TRUE(size <= sizeof(buffer));
+    TEST_ASSERT_TRUE(pino_serialize(pino, buffer));
+    assert_allocs(0, 0);
+
+    mark();
+    restored = pino_unserialize(buffer, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(values, unpacked, sizeof(values));
+    assert_allocs(4, 0);
+
+    mark();
+    pino_destroy(restored);
+    pino_destroy(pino);
+    assert_allocs(0, 8);
+}
+
+void test_compressed(void)
+{
+    pino_t *pino, *restored;
+    double values[TEST_VALUES];
+    uint8_t buffer[1024];
+    size_t size;
+
+    memset(values, 0, sizeof(values));
+    TEST_ASSERT_TRUE(pino_handler_set_flags("f64a", PINO_HANDLER_FLAG_COMPRESS));
+
+    pino = pino_pack("f64a", values, sizeof(values));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    /* the encoded payload is kept on the object, the raw payload is scratch */
+    mark();
+    size = pino_serialize_size(pino);
+    TEST_ASSERT_TRUE(size <= sizeof(buffer));
+    assert_allocs(2, 1);
+
+    mark();
+    TEST_ASSERT_TRUE(pino_serialize(pino, buffer));
+    assert_allocs(0, 0);
+
+    /* re-encoding reuses the encoded payload */
+    pino_touch(pino);
+    mark();
+    TEST_ASSERT_TRUE(pino_serialize(pino, buffer));
+    assert_allocs(1, 1);
+
+    /* the decoded payload is scratch as well */
+    mark();
+    restored = pino_unserialize(buffer, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    assert_allocs(5, 1);
+
+    pino_destroy(restored);
+    pino_destroy(pino);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_counting);
+    RUN_TEST(test_inline);
+    RUN_TEST(test_external);
+    RUN_TEST(test_compressed);
+
+    return UNITY_END();
+}
@@ -7,6 +7,8 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <string.h>
+
 #include <pino.h>
 #include <pino/handler.h>
 
@@ -83,6 +85,21 @@ void test_register_glowing(void)
         sprintf(magic, "%04zu", i);
         TEST_ASSERT_TRUE(pino_handler_register(magic, &g_ph_handler_spl1_obj));
     }
+
+    for (i = 0; i < 1000; i += 2) {
+        sprintf(magic, "%04zu", i);
+        TEST_ASSERT_TRUE(pino_handler_unregister(magic));
+    }
+
+    for (i = 0; i < 1000; i++) {
+        sprintf(magic, "%04zu", i);
+        if (i % 2) {
+            TEST_ASSERT_NOT_NULL(pino_handler_find_entry(magic));
+            TEST_ASSERT_EQUAL_MEMORY(magic, pino_handler_find_entry(magic)->magic, sizeof(pino_magic_t));
+        } else {
+            TEST_ASSERT_NULL(pino_handler_find_entry(magic));
+        }
+    }
 }
 
 void test_register_identity(void)
@@ -278,6 +295,245 @@ void test_typed_array_serialization(void)
     TEST_ASSERT_TRUE(PH_UNREG(u32a));
 }
 
+void test_peek(void)
+{
+    pino_t *pino;
+    pino_peek_info_t info;
+    uint8_t data[TEST_DATA_SIZE], *serialized;
+    size_t serialize_size;
+
+    generate_random_data(data, TEST_DATA_SIZE);
+
+    pino = pino_pack("spl1", data, TEST_DATA_SIZE);
+    TEST_ASSERT_NOT_NULL(pino);
+    set_u32(pino, 0xCAFEBABE);
+
+    serialize_size = pino_serialize_size(pino);
+    serialized = (uint8_t *)malloc(serialize_size);
+    TEST_ASSERT_NOT_NULL(serialized);
+    TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+
+    TEST_ASSERT_TRUE(pino_peek(serialized, serialize_size, &info));
+    TEST_ASSERT_EQUAL_MEMORY("spl1", info.magic, sizeof(pino_magic_safe_t));
+    TEST_ASSERT_EQUAL_size_t(PH_SIZE_STATIC(spl1), info.static_fields_size);
+    TEST_ASSERT_EQUAL_PTR(serialized + sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t), info.static_fields);
+    TEST_ASSERT_EQUAL_MEMORY(pino->static_fields, info.static_fields, PH_SIZE_STATIC(spl1));
+    TEST_ASSERT_EQUAL_size_t(serialize_size - TEST_DATA_SIZE, info.payload_offset);
+    TEST_ASSERT_EQUAL_size_t(TEST_DATA_SIZE, info.payload_size);
+    TEST_ASSERT_EQUAL_MEMORY(data, serialized + info.payload_offset, TEST_DATA_SIZE);
+    TEST_ASSERT_TRUE(info.registered);
+
+    TEST_ASSERT_TRUE(PH_UNREG(spl1));
+    TEST_ASSERT_TRUE(pino_peek(serialized, serialize_size, &info));
+    TEST_ASSERT_FALSE(info.registered);
+    TEST_ASSERT_TRUE(PH_REG(spl1));
+
+    TEST_ASSERT_FALSE(pino_peek(serialized, sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t) +
+                                                PH_SIZE_STATIC(spl1) - 1,
+                                &info));
+    TEST_ASSERT_FALSE(pino_peek(serialized, serialize_size, NULL));
+    TEST_ASSERT_FALSE(pino_peek(NULL, serialize_size, &info));
+
+    pino_destroy(pino);
+    free(serialized);
+}
+
+void test_serialize_size_cache(void)
+{
+    pino_t *pino;
+    uint8_t data[TEST_DATA_SIZE];
+    size_t serialize_size;
+    spl1_size_t shrunk_size = TEST_DATA_SIZE / 2;
+
+    generate_random_data(data, TEST_DATA_SIZE);
+
+    pino = pino_pack("spl1", data, TEST_DATA_SIZE);
+    TEST_ASSERT_NOT_NULL(pino);
+    TEST_ASSERT_TRUE(pino->dirty);
+
+    serialize_size = pino_serialize_size(pino);
+    TEST_ASSERT_FALSE(pino->dirty);
+    TEST_ASSERT_EQUAL_size_t(serialize_size, pino->serialize_size_cache);
+
+    /* untracked changes are not observed until touched */
+    PH_THIS_STATIC_SET_P(spl1, pino->static_fields, size, &shrunk_size);
+    TEST_ASSERT_EQUAL_size_t(serialize_size, pino_serialize_size(pino));
+    pino_touch(pino);
+    TEST_ASSERT_TRUE(pino->dirty);
+    TEST_ASSERT_EQUAL_size_t(serialize_size - TEST_DATA_SIZE / 2, pino_serialize_size(pino));
+
+    /* static field setters touch the object */
+    set_u32(pino, 1);
+    TEST_ASSERT_TRUE(pino->dirty);
+    TEST_ASSERT_EQUAL_size_t(serialize_size - TEST_DATA_SIZE / 2, pino_serialize_size(pino));
+    TEST_ASSERT_FALSE(pino->dirty);
+
+    pino_touch(NULL);
+    pino_destroy(pino);
+}
+
+void test_serialize_n(void)
+{
+    pino_t *pino, *restored;
+    uint8_t data[TEST_DATA_SIZE], unpacked[TEST_DATA_SIZE], *serialized;
+    size_t serialize_size, written;
+
+    generate_random_data(data, TEST_DATA_SIZE);
+
+    pino = pino_pack("spl1", data, TEST_DATA_SIZE);
+    TEST_ASSERT_NOT_NULL(pino);
+
+    serialize_size = TEST_DATA_SIZE + sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t) + PH_SIZE_STATIC(spl1);
+    serialized = (uint8_t *)malloc(serialize_size);
+    TEST_ASSERT_NOT_NULL(serialized);
+
+    /* too small: nothing is written and the required size is reported */
+    memset(serialized, 0, serialize_size);
+    TEST_ASSERT_FALSE(pino_serialize_n(pino, serialized, serialize_size - 1, &written));
+    TEST_ASSERT_EQUAL_size_t(serialize_size, written);
+    TEST_ASSERT_EQUAL_HEX8(0, serialized[0]);
+    TEST_ASSERT_FALSE(pino_serialize_n(pino, NULL, 0, &written));
+    TEST_ASSERT_EQUAL_size_t(serialize_size, written);
+
+    TEST_ASSERT_TRUE(pino_serialize_n(pino, serialized, serialize_size, &written));
+    TEST_ASSERT_EQUAL_size_t(serialize_size, written);
+
+    restored = pino_unserialize(serialized, written);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(data, unpacked, TEST_DATA_SIZE);
+
+    TEST_ASSERT_FALSE(pino_serialize_n(pino, serialized, serialize_size, NULL));
+    TEST_ASSERT_FALSE(pino_serialize_n(NULL, serialized, serialize_size, &written));
+    TEST_ASSERT_EQUAL_size_t(0, written);
+
+    pino_destroy(restored);
+    pino_destroy(pino);
+    free(serialized);
+}
+
+void test_serialize_n_untouched(void)
+{
+    pino_t *pino, *restored;
+    uint8_t data[TEST_DATA_SIZE], unpacked[TEST_DATA_SIZE], *serialized;
+    size_t small_size, serialize_size, written, i;
+    spl1_size_t size = TEST_DATA_SIZE / 2;
+    uint32_t flags[] = {0, PINO_HANDLER_FLAG_CHECKSUM};
+
+    generate_random_data(data, TEST_DATA_SIZE);
+
+    for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+        TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", flags[i]));
+
+        pino = pino_pack("spl1", data, TEST_DATA_SIZE);
+        TEST_ASSERT_NOT_NULL(pino);
+
+        size = TEST_DATA_SIZE / 2;
+        PH_THIS_STATIC_SET_P(spl1, pino->static_fields, size, &size);
+        pino_touch(pino);
+        small_size = pino_serialize_size(pino);
+        TEST_ASSERT_NOT_EQUAL(0, small_size);
+
+        /* the payload grows back without a touch, the cached size is stale */
+        size = TEST_DATA_SIZE;
+        PH_THIS_STATIC_SET_P(spl1, pino->static_fields, size, &size);
+        TEST_ASSERT_EQUAL_size_t(small_size, pino_serialize_size(pino));
+
+        serialize_size = small_size + TEST_DATA_SIZE / 2;
+        serialized = (uint8_t *)malloc(serialize_size);
+        TEST_ASSERT_NOT_NULL(serialized);
+
+        /* the bound is checked against the real size, nothing past capacity is written */
+        memset(serialized, 0, serialize_size);
+        TEST_ASSERT_FALSE(pino_serialize_n(pino, serialized, small_size, &written));
+        TEST_ASSERT_EQUAL_size_t(serialize_size, written);
+        TEST_ASSERT_EQUAL_HEX8(0, serialized[0]);
+
+        TEST_ASSERT_TRUE(pino_serialize_n(pino, serialized, serialize_size, &written));
+        TEST_ASSERT_EQUAL_size_t(serialize_size, written);
+        TEST_ASSERT_EQUAL_size_t(serialize_size, pino_serialize_size(pino));
+
+        restored = pino_unserialize(serialized, written);
+        TEST_ASSERT_NOT_NULL(restored);
+        TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+        TEST_ASSERT_EQUAL_MEMORY(data, unpacked, TEST_DATA_SIZE);
+
+        pino_destroy(restored);
+        pino_destroy(pino);
+        free(serialized);
+    }
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", 0));
+}
+
+void test_compact_header(void)
+{
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    uint8_t data[32], unpacked[32], *serialized;
+    uint32_t flags[] = {PINO_HANDLER_FLAG_COMPACT_HEADER,
+                        PINO_HANDLER_FLAG_COMPACT_HEADER | PINO_HANDLER_FLAG_CHECKSUM,
+                        PINO_HANDLER_FLAG_COMPACT_HEADER | PINO_HANDLER_FLAG_COMPRESS};
+    size_t fixed_size, serialize_size, i;
+
+    memset(data, 'a', sizeof(data));
+
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+    set_u32(pino, 0xCAFEBABE);
+    fixed_size = pino_serialize_size(pino);
+
+    for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+        TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", flags[i]));
+        serialize_size = pino_serialize_size(pino);
+        if (i == 0) {
+            /* magic, flags byte and a single byte varint */
+            TEST_ASSERT_EQUAL_size_t(fixed_size - sizeof(pino_static_fields_size_t) + 2, serialize_size);
+        }
+
+        serialized = (uint8_t *)malloc(serialize_size);
+        TEST_ASSERT_NOT_NULL(serialized);
+        TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+        TEST_ASSERT_EQUAL_HEX8('s' | COMPACT_MAGIC_BIT, serialized[0]);
+
+        TEST_ASSERT_TRUE(pino_peek(serialized, serialize_size, &info));
+        TEST_ASSERT_EQUAL_STRING("spl1", info.magic);
+        TEST_ASSERT_EQUAL_size_t(PH_SIZE_STATIC(spl1), info.static_fields_size);
+        TEST_ASSERT_TRUE(info.registered);
+        if (i == 0) {
+            TEST_ASSERT_EQUAL_PTR(serialized + COMPACT_HEADER_BASE_SIZE + 1, info.static_fields);
+        }
+
+        restored = pino_unserialize(serialized, serialize_size);
+        TEST_ASSERT_NOT_NULL(restored);
+        TEST_ASSERT_EQUAL_UINT32(0xCAFEBABE, get_u32(restored));
+        TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+        TEST_ASSERT_EQUAL_MEMORY(data, unpacked, sizeof(data));
+        pino_destroy(restored);
+
+        free(serialized);
+    }
+
+    serialized = (uint8_t *)malloc(fixed_size);
+    TEST_ASSERT_NOT_NULL(serialized);
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_COMPACT_HEADER));
+    serialize_size = pino_serialize_size(pino);
+    TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+
+    /* truncated varint, unknown flags */
+    TEST_ASSERT_FALSE(pino_peek(serialized, COMPACT_HEADER_BASE_SIZE, &info));
+    serialized[COMPACT_HEADER_BASE_SIZE] |= 0x80;
+    TEST_ASSERT_NULL(pino_unserialize(serialized, COMPACT_HEADER_BASE_SIZE + 1));
+    serialized[COMPACT_HEADER_BASE_SIZE] &= 0x7F;
+    serialized[sizeof(pino_magic_t)] = 0x80;
+    TEST_ASSERT_FALSE(pino_peek(serialized, serialize_size, &info));
+    TEST_ASSERT_NULL(pino_unserialize(serialized, serialize_size));
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", 0));
+    pino_destroy(pino);
+    free(serialized);
+}
+
 void test_version_id(void)
 {
     TEST_ASSERT_EQUAL_UINT32(PINO_VERSION_ID, pino_version_id());
@@ -351,6 +607,11 @@ int main(void)
     RUN_TEST(test_pack_glowing);
     RUN_TEST(test_pino_serialize);
     RUN_TEST(test_typed_array_serialization);
+    RUN_TEST(test_peek);
+    RUN_TEST(test_serialize_size_cache);
+    RUN_TEST(test_serialize_n);
+    RUN_TEST(test_serialize_n_untouched);
+    RUN_TEST(test_compact_header);
 
     RUN_TEST(test_version_id);
     RUN_TEST(test_buildtime);
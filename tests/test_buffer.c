@@ -0,0 +1,187 @@
+/*
+ * libpino - test_buffer.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <pino.h>
+#include <pino/buffer.h>
+#include <pino/handler.h>
+
+#include "handler_spl1.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_DATA_SIZE 1024
+#define TEST_RECORDS   64
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(spl1)) {
+        TEST_FAIL();
+    }
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(spl1)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_append(void)
+{
+    pino_buffer_t buffer;
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    uint8_t data[TEST_DATA_SIZE], unpacked[TEST_DATA_SIZE];
+    size_t i, offset, record_size;
+
+    generate_random_data(data, sizeof(data));
+
+    TEST_ASSERT_TRUE(pino_buffer_init(&buffer, 0));
+    TEST_ASSERT_NULL(buffer.data);
+
+    for (i = 0; i < TEST_RECORDS; i++) {
+        pino = pino_pack("spl1", data, i + 1);
+        TEST_ASSERT_NOT_NULL(pino);
+        TEST_ASSERT_TRUE(pino_buffer_append(&buffer, pino));
+        pino_destroy(pino);
+    }
+
+    TEST_ASSERT_LESS_OR_EQUAL_size_t(buffer.capacity, buffer.size);
+
+    offset = 0;
+    for (i = 0; i < TEST_RECORDS; i++) {
+        record_size = sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t) + PH_SIZE_STATIC(spl1) + i + 1;
+        TEST_ASSERT_TRUE(pino_peek(buffer.data + offset, record_size, &info));
+        TEST_ASSERT_EQUAL_size_t(i + 1, info.payload_size);
+
+        restored = pino_unserialize(buffer.data + offset, record_size);
+        TEST_ASSERT_NOT_NULL(restored);
+        TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+        TEST_ASSERT_EQUAL_MEMORY(data, unpacked, i + 1);
+        pino_destroy(restored);
+
+        offset += record_size;
+    }
+    TEST_ASSERT_EQUAL_size_t(buffer.size, offset);
+
+    pino_buffer_free(&buffer);
+    TEST_ASSERT_NULL(buffer.data);
+    TEST_ASSERT_EQUAL_size_t(0, buffer.capacity);
+}
+
+void test_reserve_reset(void)
+{
+    pino_buffer_t buffer;
+    pino_t *pino;
+    uint8_t data[TEST_DATA_SIZE], *reserved;
+    size_t capacity;
+
+    generate_random_data(data, sizeof(data));
+
+    TEST_ASSERT_TRUE(pino_buffer_init(&buffer, 16));
+    TEST_ASSERT_EQUAL_size_t(16, buffer.capacity);
+
+    TEST_ASSERT_TRUE(pino_buffer_reserve(&buffer, TEST_DATA_SIZE * 4));
+    TEST_ASSERT_GREATER_OR_EQUAL_size_t(TEST_DATA_SIZE * 4, buffer.capacity);
+    capacity = buffer.capacity;
+    reserved = buffer.data;
+
+    pino = pino_pack("spl1", data, TEST_DATA_SIZE);
+    TEST_ASSERT_NOT_NULL(pino);
+
+    /* appends within the reservation never reallocate */
+    TEST_ASSERT_TRUE(pino_buffer_append(&buffer, pino));
+    TEST_ASSERT_TRUE(pino_buffer_append(&buffer, pino));
+    TEST_ASSERT_TRUE(pino_buffer_append_bytes(&buffer, data, 16));
+    TEST_ASSERT_EQUAL_PTR(reserved, buffer.data);
+    TEST_ASSERT_EQUAL_size_t(capacity, buffer.capacity);
+
+    /* reset keeps the storage for the next batch */
+    pino_buffer_reset(&buffer);
+    TEST_ASSERT_EQUAL_size_t(0, buffer.size);
+    TEST_ASSERT_EQUAL_size_t(capacity, buffer.capacity);
+    TEST_ASSERT_TRUE(pino_buffer_append(&buffer, pino));
+    TEST_ASSERT_EQUAL_PTR(reserved, buffer.data);
+
+    pino_destroy(pino);
+    pino_buffer_free(&buffer);
+}
+
+void test_release(void)
+{
+    pino_buffer_t buffer;
+    pino_t *pino, *restored;
+    void *released;
+    uint8_t data[TEST_DATA_SIZE];
+    size_t size;
+
+    generate_random_data(data, sizeof(data));
+
+    pino = pino_pack("spl1", data, TEST_DATA_SIZE);
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_TRUE(pino_buffer_init(&buffer, 0));
+    TEST_ASSERT_TRUE(pino_buffer_append(&buffer, pino));
+
+    released = pino_buffer_release(&buffer, &size);
+    TEST_ASSERT_NOT_NULL(released);
+    TEST_ASSERT_EQUAL_size_t(pino_serialize_size(pino), size);
+    TEST_ASSERT_NULL(buffer.data);
+    TEST_ASSERT_EQUAL_size_t(0, buffer.size);
+
+    restored = pino_unserialize(released, size);
+    TEST_ASSERT_NOT_NULL(restored);
+
+    /* the buffer can be reused after a release */
+    TEST_ASSERT_TRUE(pino_buffer_append(&buffer, restored));
+    TEST_ASSERT_EQUAL_size_t(size, buffer.size);
+    TEST_ASSERT_EQUAL_MEMORY(released, buffer.data, size);
+
+    pino_buffer_data_free(released);
+    pino_destroy(restored);
+    pino_destroy(pino);
+    pino_buffer_free(&buffer);
+}
+
+void test_invalid(void)
+{
+    pino_buffer_t buffer;
+
+    TEST_ASSERT_FALSE(pino_buffer_init(NULL, 0));
+    TEST_ASSERT_FALSE(pino_buffer_reserve(NULL, 0));
+    TEST_ASSERT_FALSE(pino_buffer_append(NULL, NULL));
+    TEST_ASSERT_FALSE(pino_buffer_append_bytes(NULL, NULL, 0));
+    TEST_ASSERT_NULL(pino_buffer_release(NULL, NULL));
+    pino_buffer_reset(NULL);
+    pino_buffer_free(NULL);
+
+    TEST_ASSERT_TRUE(pino_buffer_init(&buffer, 0));
+    TEST_ASSERT_FALSE(pino_buffer_append(&buffer, NULL));
+    TEST_ASSERT_FALSE(pino_buffer_append_bytes(&buffer, NULL, 1));
+    TEST_ASSERT_TRUE(pino_buffer_append_bytes(&buffer, NULL, 0));
+    TEST_ASSERT_TRUE(pino_buffer_append_bytes(&buffer, "pino", 4));
+    TEST_ASSERT_FALSE(pino_buffer_reserve(&buffer, SIZE_MAX));
+    pino_buffer_free(&buffer);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_append);
+    RUN_TEST(test_reserve_reset);
+    RUN_TEST(test_release);
+    RUN_TEST(test_invalid);
+
+    return UNITY_END();
+}
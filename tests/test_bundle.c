@@ -0,0 +1,240 @@
+/*
+ * libpino - test_bundle.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/bundle.h>
+#include <pino/handler.h>
+
+#include "handler_spl1.h"
+#include "handler_u32a.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_DATA_SIZE 256
+#define TEST_RECORDS   100
+
+static uint8_t *read_stream(FILE *fp, size_t *size)
+{
+    uint8_t *data;
+    long end;
+
+    TEST_ASSERT_EQUAL_INT(0, fseek(fp, 0, SEEK_END));
+    end = ftell(fp);
+    TEST_ASSERT_GREATER_THAN(0, end);
+    rewind(fp);
+
+    data = (uint8_t *)malloc((size_t)end);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_EQUAL_size_t((size_t)end, fread(data, 1, (size_t)end, fp));
+
+    *size = (size_t)end;
+
+    return data;
+}
+
+static uint8_t *write_bundle(size_t *size)
+{
+    pino_bundle_writer_t *writer;
+    pino_t *pino;
+    FILE *fp;
+    uint8_t data[TEST_DATA_SIZE], *bundle;
+    uint32_t words[2];
+    size_t i;
+
+    fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    writer = pino_bundle_writer_create(fp);
+    TEST_ASSERT_NOT_NULL(writer);
+
+    for (i = 0; i < TEST_RECORDS; i++) {
+        if (i % 3 == 0) {
+            words[0] = (uint32_t)i;
+            words[1] = (uint32_t)(i * 2);
+            pino = pino_pack("u32a", words, sizeof(words));
+        } else {
+            memset(data, (int)i, sizeof(data));
+            pino = pino_pack("spl1", data, (i % 7) + 1);
+        }
+
+        TEST_ASSERT_NOT_NULL(pino);
+        TEST_ASSERT_TRUE(pino_bundle_writer_add(writer, pino));
+        pino_destroy(pino);
+    }
+
+    TEST_ASSERT_TRUE(pino_bundle_writer_close(writer));
+
+    bundle = read_stream(fp, size);
+    fclose(fp);
+
+    return bundle;
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(spl1) || !PH_REG(u32a)) {
+        TEST_FAIL();
+    }
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(spl1) || !PH_UNREG(u32a)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_random_access(void)
+{
+    pino_bundle_t *bundle;
+    pino_t *pino;
+    pino_magic_safe_t magic;
+    uint8_t *data, unpacked[TEST_DATA_SIZE];
+    uint32_t words[2];
+    size_t size, i;
+
+    data = write_bundle(&size);
+
+    bundle = pino_bundle_open(data, size);
+    TEST_ASSERT_NOT_NULL(bundle);
+    TEST_ASSERT_EQUAL_size_t(TEST_RECORDS, pino_bundle_count(bundle));
+
+    for (i = TEST_RECORDS; i-- > 0;) {
+        TEST_ASSERT_TRUE(pino_bundle_magic(bundle, i, magic));
+        pino = pino_bundle_get(bundle, i);
+        TEST_ASSERT_NOT_NULL(pino);
+
+        if (i % 3 == 0) {
+            TEST_ASSERT_EQUAL_MEMORY("u32a", magic, sizeof(pino_magic_t));
+            TEST_ASSERT_TRUE(pino_unpack(pino, words));
+            TEST_ASSERT_EQUAL_UINT32(i, words[0]);
+            TEST_ASSERT_EQUAL_UINT32(i * 2, words[1]);
+        } else {
+            TEST_ASSERT_EQUAL_MEMORY("spl1", magic, sizeof(pino_magic_t));
+            TEST_ASSERT_EQUAL_size_t((i % 7) + 1, pino_unpack_size(pino));
+            TEST_ASSERT_TRUE(pino_unpack(pino, unpacked));
+            TEST_ASSERT_EQUAL_HEX8((uint8_t)i, unpacked[0]);
+        }
+
+        pino_destroy(pino);
+    }
+
+    TEST_ASSERT_NULL(pino_bundle_get(bundle, TEST_RECORDS));
+    TEST_ASSERT_FALSE(pino_bundle_magic(bundle, TEST_RECORDS, magic));
+
+    pino_bundle_close(bundle);
+    free(data);
+}
+
+void test_find(void)
+{
+    pino_bundle_t *bundle;
+    uint8_t *data;
+    size_t size, i, found;
+
+    data = write_bundle(&size);
+
+    bundle = pino_bundle_open(data, size);
+    TEST_ASSERT_NOT_NULL(bundle);
+
+    found = 0;
+    for (i = pino_bundle_find(bundle, 0, "u32a"); i < pino_bundle_count(bundle);
+         i = pino_bundle_find(bundle, i + 1, "u32a")) {
+        TEST_ASSERT_EQUAL_size_t(0, i % 3);
+        found++;
+    }
+    TEST_ASSERT_EQUAL_size_t((TEST_RECORDS + 2) / 3, found);
+
+    TEST_ASSERT_EQUAL_size_t(pino_bundle_count(bundle), pino_bundle_find(bundle, 0, "none"));
+    TEST_ASSERT_EQUAL_size_t(pino_bundle_count(bundle), pino_bundle_find(bundle, TEST_RECORDS * 2, "spl1"));
+
+    pino_bundle_close(bundle);
+    free(data);
+}
+
+void test_empty(void)
+{
+    pino_bundle_writer_t *writer;
+    pino_bundle_t *bundle;
+    FILE *fp;
+    uint8_t *data;
+    size_t size;
+
+    fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    writer = pino_bundle_writer_create(fp);
+    TEST_ASSERT_NOT_NULL(writer);
+    TEST_ASSERT_TRUE(pino_bundle_writer_close(writer));
+
+    data = read_stream(fp, &size);
+    fclose(fp);
+    TEST_ASSERT_EQUAL_size_t(PINO_BUNDLE_HEADER_SIZE + PINO_BUNDLE_FOOTER_SIZE, size);
+
+    bundle = pino_bundle_open(data, size);
+    TEST_ASSERT_NOT_NULL(bundle);
+    TEST_ASSERT_EQUAL_size_t(0, pino_bundle_count(bundle));
+
+    pino_bundle_close(bundle);
+    free(data);
+}
+
+void test_invalid(void)
+{
+    pino_bundle_t *bundle;
+    const void *record;
+    uint8_t *data;
+    size_t size, record_size;
+
+    TEST_ASSERT_NULL(pino_bundle_writer_create(NULL));
+    TEST_ASSERT_FALSE(pino_bundle_writer_add(NULL, NULL));
+    TEST_ASSERT_FALSE(pino_bundle_writer_add_raw(NULL, NULL, 0));
+    TEST_ASSERT_FALSE(pino_bundle_writer_close(NULL));
+    TEST_ASSERT_NULL(pino_bundle_open(NULL, 0));
+    TEST_ASSERT_EQUAL_size_t(0, pino_bundle_count(NULL));
+    pino_bundle_close(NULL);
+
+    data = write_bundle(&size);
+
+    /* truncated */
+    TEST_ASSERT_NULL(pino_bundle_open(data, size - 1));
+    TEST_ASSERT_NULL(pino_bundle_open(data, PINO_BUNDLE_HEADER_SIZE));
+
+    /* broken header */
+    data[0] ^= 0xFF;
+    TEST_ASSERT_NULL(pino_bundle_open(data, size));
+    data[0] ^= 0xFF;
+
+    /* broken index entry is rejected on access */
+    bundle = pino_bundle_open(data, size);
+    TEST_ASSERT_NOT_NULL(bundle);
+    data[size - PINO_BUNDLE_FOOTER_SIZE - PINO_BUNDLE_INDEX_SIZE + 15] = 0x7F;
+    TEST_ASSERT_FALSE(pino_bundle_record(bundle, TEST_RECORDS - 1, &record, &record_size));
+    TEST_ASSERT_TRUE(pino_bundle_record(bundle, 0, &record, &record_size));
+
+    pino_bundle_close(bundle);
+    free(data);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_random_access);
+    RUN_TEST(test_find);
+    RUN_TEST(test_empty);
+    RUN_TEST(test_invalid);
+
+    return UNITY_END();
+}
@@ -0,0 +1,185 @@
+/*
+ * libpino - test_byte_order.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+#include "handler_f64a.h"
+#include "handler_spl1.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_VALUES 24
+
+/* the format flags are the top byte of the LE size word in the fixed header */
+#define TEST_FLAGS_OFFSET (sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t) - 1)
+
+static bool is_big_endian(void)
+{
+    uint16_t value = 1;
+
+    return *(const uint8_t *)&value == 0;
+}
+
+static pino_t *pack_values(double *values)
+{
+    size_t i;
+
+    for (i = 0; i < TEST_VALUES; i++) {
+        values[i] = (double)i * 1.25 + 0.125;
+    }
+
+    return pino_pack("f64a", values, TEST_VALUES * sizeof(double));
+}
+
+static uint8_t *serialize(const pino_t *pino, size_t *size)
+{
+    uint8_t *serialized;
+
+    *size = pino_serialize_size(pino);
+    TEST_ASSERT_GREATER_THAN_size_t(0, *size);
+
+    serialized = (uint8_t *)malloc(*size);
+    TEST_ASSERT_NOT_NULL(serialized);
+    TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+
+    return serialized;
+}
+
+static void assert_values(const uint8_t *serialized, size_t size, const double *values)
+{
+    pino_t *restored;
+    double decoded[TEST_VALUES];
+
+    restored = pino_unserialize(serialized, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, decoded));
+    TEST_ASSERT_EQUAL_MEMORY(values, decoded, sizeof(decoded));
+    pino_destroy(restored);
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(f64a) || !PH_REG(spl1)) {
+        TEST_FAIL();
+    }
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(f64a) || !PH_UNREG(spl1)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_native_order(void)
+{
+    pino_t *pino;
+    pino_peek_info_t info;
+    double values[TEST_VALUES], native[TEST_VALUES];
+    uint32_t flags[] = {PINO_HANDLER_FLAG_NATIVE_ORDER, PINO_HANDLER_FLAG_NATIVE_ORDER | PINO_HANDLER_FLAG_CHECKSUM,
+                        PINO_HANDLER_FLAG_NATIVE_ORDER | PINO_HANDLER_FLAG_COMPACT_HEADER};
+    uint8_t *serialized;
+    size_t size, i;
+
+    pino = pack_values(values);
+    TEST_ASSERT_NOT_NULL(pino);
+
+    for (i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+        TEST_ASSERT_TRUE(pino_handler_set_flags("f64a", flags[i]));
+        serialized = serialize(pino, &size);
+
+        /* the marker is only needed when the writer is not LE */
+        TEST_ASSERT_TRUE(pino_peek(serialized, size, &info));
+        TEST_ASSERT_EQUAL_HEX8(is_big_endian() ? PINO_FORMAT_FLAG_BIG_ENDIAN : 0,
+                               info.flags & PINO_FORMAT_FLAG_BIG_ENDIAN);
+
+        /* the payload is a plain copy of the native values */
+        memcpy(native, serialized + info.payload_offset, sizeof(native));
+        TEST_ASSERT_EQUAL_MEMORY(values, native, sizeof(native));
+
+        assert_values(serialized, size, values);
+        free(serialized);
+    }
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("f64a", 0));
+    pino_destroy(pino);
+}
+
+void test_foreign_order(void)
+{
+    pino_t *pino;
+    pino_peek_info_t info;
+    double values[TEST_VALUES];
+    uint8_t *serialized, *payload, swapped[sizeof(double)];
+    size_t size, i, j;
+
+    pino = pack_values(values);
+    TEST_ASSERT_NOT_NULL(pino);
+    serialized = serialize(pino, &size);
+    TEST_ASSERT_TRUE(pino_peek(serialized, size, &info));
+    TEST_ASSERT_EQUAL_HEX8(0, info.flags & PINO_FORMAT_FLAG_BIG_ENDIAN);
+
+    /* rewrite the LE record as a BE writer would have produced it */
+    payload = serialized + info.payload_offset;
+    for (i = 0; i < TEST_VALUES; i++) {
+        for (j = 0; j < sizeof(double); j++) {
+            swapped[j] = payload[i * sizeof(double) + sizeof(double) - 1 - j];
+        }
+        memcpy(payload + i * sizeof(double), swapped, sizeof(double));
+    }
+    serialized[TEST_FLAGS_OFFSET] |= PINO_FORMAT_FLAG_BIG_ENDIAN;
+
+    TEST_ASSERT_TRUE(pino_peek(serialized, size, &info));
+    TEST_ASSERT_EQUAL_HEX8(PINO_FORMAT_FLAG_BIG_ENDIAN, info.flags & PINO_FORMAT_FLAG_BIG_ENDIAN);
+    assert_values(serialized, size, values);
+
+    free(serialized);
+    pino_destroy(pino);
+}
+
+void test_byte_payloads(void)
+{
+    pino_t *pino;
+    uint8_t data[64], unpacked[64], *serialized;
+    size_t size;
+
+    /* byte payloads read the same in either order */
+    generate_random_data(data, sizeof(data));
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_NATIVE_ORDER));
+
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+    serialized = serialize(pino, &size);
+    pino_destroy(pino);
+
+    pino = pino_unserialize(serialized, size);
+    TEST_ASSERT_NOT_NULL(pino);
+    TEST_ASSERT_TRUE(pino_unpack(pino, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(data, unpacked, sizeof(data));
+    pino_destroy(pino);
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", 0));
+    free(serialized);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_native_order);
+    RUN_TEST(test_foreign_order);
+    RUN_TEST(test_byte_payloads);
+
+    return UNITY_END();
+}
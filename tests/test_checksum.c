@@ -0,0 +1,332 @@
+/*
+ * libpino - test_checksum.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+#include "../src/internal/bswap.h"
+#include "../src/internal/crc32c.h"
+#include "handler_spl1.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_DATA_SIZE   1024
+#define TEST_HEADER_SIZE (sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t))
+#define TEST_CHECKED_WORDS 64
+
+/* writes its payload with PH_SERIALIZE_DATA_CHECKED, long enough for the vector part of the fused kernel */
+PH_BEGIN(u32c);
+
+PH_DEF_STATIC_FIELDS_STRUCT(u32c)
+{
+    uint32_t count;
+}
+PH_DEF_STATIC_FIELDS_STRUCT_END;
+
+PH_DEF_STRUCT(u32c)
+{
+    uint32_t words[TEST_CHECKED_WORDS];
+}
+PH_DEF_STRUCT_END;
+
+PH_DEFUN_SERIALIZE_SIZE(u32c)
+{
+    return sizeof(PH_THIS(u32c)->words);
+}
+
+PH_DEFUN_SERIALIZE(u32c)
+{
+    PH_SERIALIZE_DATA_CHECKED(u32c, words, sizeof(PH_THIS(u32c)->words));
+    return true;
+}
+
+PH_DEFUN_UNSERIALIZE(u32c)
+{
+    PH_UNSERIALIZE_DATA(u32c, words, sizeof(PH_THIS(u32c)->words));
+    return true;
+}
+
+PH_DEFUN_PACK(u32c)
+{
+    uint32_t count = TEST_CHECKED_WORDS;
+
+    if (PH_ARG_SIZE != sizeof(PH_THIS(u32c)->words)) {
+        return false;
+    }
+
+    PH_THIS_STATIC_SET(u32c, count, &count);
+    PH_PACK_DATA(u32c, words, sizeof(PH_THIS(u32c)->words));
+    return true;
+}
+
+PH_DEFUN_UNPACK_SIZE(u32c)
+{
+    return sizeof(PH_THIS(u32c)->words);
+}
+
+PH_DEFUN_UNPACK(u32c)
+{
+    PH_UNPACK_DATA(u32c, words, sizeof(PH_THIS(u32c)->words));
+    return true;
+}
+
+PH_DEFUN_CREATE(u32c)
+{
+    uint32_t count = TEST_CHECKED_WORDS;
+
+    PH_CREATE_THIS(u32c);
+
+    if (PH_ARG_SIZE != sizeof(PH_THIS(u32c)->words)) {
+        PH_DESTROY_THIS(u32c);
+        return NULL;
+    }
+
+    PH_THIS_STATIC_SET(u32c, count, &count);
+
+    return PH_THIS(u32c);
+}
+
+PH_DEFUN_DESTROY(u32c)
+{
+    PH_DESTROY_THIS(u32c);
+}
+
+PH_END(u32c);
+
+static uint8_t *serialize(const pino_t *pino, size_t *size)
+{
+    uint8_t *serialized;
+
+    *size = pino_serialize_size(pino);
+    TEST_ASSERT_GREATER_THAN_size_t(0, *size);
+
+    serialized = (uint8_t *)malloc(*size);
+    TEST_ASSERT_NOT_NULL(serialized);
+    TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+
+    return serialized;
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(spl1) || !PH_REG(u32c)) {
+        TEST_FAIL();
+    }
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(spl1) || !PH_UNREG(u32c)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_crc32c(void)
+{
+    uint8_t data[TEST_DATA_SIZE + 8];
+    size_t offset, split;
+
+    /* check value of the Castagnoli polynomial */
+    TEST_ASSERT_EQUAL_HEX32(0xE3069283, pino_crc32c(0, "123456789", 9));
+    TEST_ASSERT_EQUAL_HEX32(0, pino_crc32c(0, NULL, 0));
+
+    generate_random_data(data, sizeof(data));
+
+    /* unaligned starts and incremental updates give the same result */
+    for (offset = 0; offset < 8; offset++) {
+        for (split = 0; split < 64; split += 7) {
+            TEST_ASSERT_EQUAL_HEX32(
+                pino_crc32c(0, data + offset, TEST_DATA_SIZE),
+                pino_crc32c(pino_crc32c(0, data + offset, split), data + offset + split, TEST_DATA_SIZE - split));
+        }
+    }
+}
+
+void test_fused_kernel(void)
+{
+    uint8_t src[TEST_DATA_SIZE + 8], fused[TEST_DATA_SIZE + 8], expected[TEST_DATA_SIZE + 8];
+    size_t elem_sizes[] = {1, 2, 3, 4, 8}, sizes[] = {0, 8, 24, 40, 96, TEST_DATA_SIZE}, offset, i, j;
+    uint32_t state;
+
+    generate_random_data(src, sizeof(src));
+
+    for (i = 0; i < sizeof(elem_sizes) / sizeof(elem_sizes[0]); i++) {
+        for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+            for (offset = 0; offset < 8; offset += 3) {
+                memset(fused, 0, sizeof(fused));
+                pino_bswap_memcpy(expected, src + offset, sizes[j], elem_sizes[i]);
+
+                /* same bytes as the plain swap, same crc as a second pass */
+                state = pino_bswap_memcpy_crc32c(fused + offset, src + offset, sizes[j], elem_sizes[i], ~UINT32_C(0));
+                TEST_ASSERT_EQUAL_MEMORY(expected, fused + offset, sizes[j]);
+                TEST_ASSERT_EQUAL_HEX32(pino_crc32c(0, expected, sizes[j]), ~state);
+            }
+        }
+    }
+}
+
+void test_serialize(void)
+{
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    uint8_t data[TEST_DATA_SIZE], unpacked[TEST_DATA_SIZE], *serialized;
+    uint32_t crc;
+    size_t plain_size, size;
+
+    generate_random_data(data, sizeof(data));
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    plain_size = pino_serialize_size(pino);
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_CHECKSUM));
+
+    serialized = serialize(pino, &size);
+    TEST_ASSERT_EQUAL_size_t(plain_size + sizeof(uint32_t), size);
+
+    TEST_ASSERT_TRUE(pino_peek(serialized, size, &info));
+    TEST_ASSERT_EQUAL_HEX8(PINO_FORMAT_FLAG_CHECKSUM, info.flags);
+    TEST_ASSERT_EQUAL_size_t(TEST_HEADER_SIZE + PH_SIZE_STATIC(spl1), info.payload_offset);
+    TEST_ASSERT_EQUAL_size_t(sizeof(data), info.payload_size);
+
+    /* the trailer is the crc of everything before it */
+    PH_MEMCPY_L2N(&crc, serialized + size - sizeof(uint32_t), sizeof(uint32_t));
+    TEST_ASSERT_EQUAL_HEX32(pino_crc32c(0, serialized, size - sizeof(uint32_t)), crc);
+
+    restored = pino_unserialize(serialized, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(data, unpacked, sizeof(data));
+    pino_destroy(restored);
+
+    /* records are decoded by their own flags */
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", 0));
+    TEST_ASSERT_EQUAL_size_t(plain_size, pino_serialize_size(pino));
+    restored = pino_unserialize(serialized, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    pino_destroy(restored);
+
+    pino_destroy(pino);
+    free(serialized);
+}
+
+void test_compressed(void)
+{
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    uint8_t data[TEST_DATA_SIZE], unpacked[TEST_DATA_SIZE], *serialized;
+    size_t size;
+
+    generate_compressible_data(data, sizeof(data));
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_COMPRESS | PINO_HANDLER_FLAG_CHECKSUM));
+    serialized = serialize(pino, &size);
+
+    TEST_ASSERT_TRUE(pino_peek(serialized, size, &info));
+    TEST_ASSERT_EQUAL_HEX8(PINO_FORMAT_FLAG_COMPRESSED | PINO_FORMAT_FLAG_CHECKSUM, info.flags);
+    TEST_ASSERT_EQUAL_size_t(size - info.payload_offset - sizeof(uint32_t), info.payload_size);
+    TEST_ASSERT_EQUAL_size_t(sizeof(data), info.raw_payload_size);
+
+    restored = pino_unserialize(serialized, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(data, unpacked, sizeof(data));
+    pino_destroy(restored);
+
+    pino_destroy(pino);
+    free(serialized);
+}
+
+void test_checked_data(void)
+{
+    pino_t *pino, *restored;
+    uint8_t *serialized;
+    uint32_t words[TEST_CHECKED_WORDS], unpacked[TEST_CHECKED_WORDS], crc;
+    size_t size, i;
+
+    for (i = 0; i < TEST_CHECKED_WORDS; i++) {
+        words[i] = UINT32_C(0x01020304) * (uint32_t)(i + 1);
+    }
+
+    pino = pino_pack("u32c", words, sizeof(words));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("u32c", PINO_HANDLER_FLAG_CHECKSUM));
+    serialized = serialize(pino, &size);
+
+    PH_MEMCPY_L2N(&crc, serialized + size - sizeof(uint32_t), sizeof(uint32_t));
+    TEST_ASSERT_EQUAL_HEX32(pino_crc32c(0, serialized, size - sizeof(uint32_t)), crc);
+
+    restored = pino_unserialize(serialized, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(words, unpacked, sizeof(words));
+    pino_destroy(restored);
+
+    /* without a checksum the macro is a plain LE copy */
+    TEST_ASSERT_TRUE(pino_handler_set_flags("u32c", 0));
+    free(serialized);
+    serialized = serialize(pino, &size);
+    restored = pino_unserialize(serialized, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(words, unpacked, sizeof(words));
+    pino_destroy(restored);
+
+    pino_destroy(pino);
+    free(serialized);
+}
+
+void test_corrupt(void)
+{
+    pino_t *pino;
+    pino_peek_info_t info;
+    uint8_t data[TEST_DATA_SIZE], *serialized;
+    size_t size, i;
+
+    generate_random_data(data, sizeof(data));
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_CHECKSUM));
+    serialized = serialize(pino, &size);
+
+    /* any single bit flip outside the header is caught */
+    for (i = TEST_HEADER_SIZE; i < size; i += 61) {
+        serialized[i] ^= 0x10;
+        TEST_ASSERT_NULL(pino_unserialize(serialized, size));
+        serialized[i] ^= 0x10;
+    }
+
+    /* truncated */
+    TEST_ASSERT_NULL(pino_unserialize(serialized, size - 1));
+    TEST_ASSERT_FALSE(pino_peek(serialized, TEST_HEADER_SIZE + PH_SIZE_STATIC(spl1) + 3, &info));
+
+    pino_destroy(pino);
+    free(serialized);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_crc32c);
+    RUN_TEST(test_fused_kernel);
+    RUN_TEST(test_serialize);
+    RUN_TEST(test_compressed);
+    RUN_TEST(test_checked_data);
+    RUN_TEST(test_corrupt);
+
+    return UNITY_END();
+}
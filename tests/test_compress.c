@@ -0,0 +1,288 @@
+/*
+ * libpino - test_compress.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+
+#include "../src/internal/lz.h"
+#include "handler_spl1.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_DATA_SIZE   4096
+#define TEST_LARGE_SIZE  (1024 * 1024)
+#define TEST_HEADER_SIZE (sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t))
+
+static void assert_codec_roundtrip(const uint8_t *src, size_t size)
+{
+    uint8_t *compressed, *restored;
+    size_t bound, compressed_size;
+
+    bound = pino_lz_bound(size);
+    TEST_ASSERT_GREATER_THAN_size_t(size, bound);
+
+    compressed = (uint8_t *)malloc(bound);
+    restored = (uint8_t *)malloc(size > 0 ? size : 1);
+    TEST_ASSERT_NOT_NULL(compressed);
+    TEST_ASSERT_NOT_NULL(restored);
+
+    compressed_size = pino_lz_compress(src, size, NULL, 0, NULL, compressed, bound);
+    TEST_ASSERT_GREATER_THAN_size_t(0, compressed_size);
+    TEST_ASSERT_LESS_OR_EQUAL_size_t(bound, compressed_size);
+
+    TEST_ASSERT_TRUE(pino_lz_decompress(compressed, compressed_size, NULL, 0, restored, size));
+    if (size > 0) {
+        TEST_ASSERT_EQUAL_MEMORY(src, restored, size);
+    }
+
+    free(compressed);
+    free(restored);
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(spl1)) {
+        TEST_FAIL();
+    }
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(spl1)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_codec(void)
+{
+    uint8_t *data;
+    size_t sizes[] = {0, 1, 4, 15, 16, 17, 100, 255, 256, 4096, 65536 + 100, TEST_LARGE_SIZE};
+    size_t i;
+
+    data = (uint8_t *)malloc(TEST_LARGE_SIZE);
+    TEST_ASSERT_NOT_NULL(data);
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        memset(data, 0, sizes[i]);
+        assert_codec_roundtrip(data, sizes[i]);
+
+        generate_fixed_data(data, sizes[i]);
+        assert_codec_roundtrip(data, sizes[i]);
+
+        generate_compressible_data(data, sizes[i]);
+        assert_codec_roundtrip(data, sizes[i]);
+
+        generate_random_data(data, sizes[i]);
+        assert_codec_roundtrip(data, sizes[i]);
+    }
+
+    free(data);
+}
+
+void test_codec_ratio(void)
+{
+    uint8_t data[TEST_DATA_SIZE], compressed[TEST_DATA_SIZE * 2];
+    size_t compressed_size;
+
+    generate_compressible_data(data, sizeof(data));
+    compressed_size = pino_lz_compress(data, sizeof(data), NULL, 0, NULL, compressed, sizeof(compressed));
+    TEST_ASSERT_GREATER_THAN_size_t(0, compressed_size);
+    TEST_ASSERT_LESS_THAN_size_t(sizeof(data) / 4, compressed_size);
+
+    /* capacity below the output is reported as a failure */
+    TEST_ASSERT_EQUAL_size_t(0, pino_lz_compress(data, sizeof(data), NULL, 0, NULL, compressed, compressed_size - 1));
+}
+
+void test_codec_corrupt(void)
+{
+    uint8_t data[TEST_DATA_SIZE], compressed[TEST_DATA_SIZE * 2], restored[TEST_DATA_SIZE];
+    size_t compressed_size, i;
+
+    generate_compressible_data(data, sizeof(data));
+    compressed_size = pino_lz_compress(data, sizeof(data), NULL, 0, NULL, compressed, sizeof(compressed));
+    TEST_ASSERT_GREATER_THAN_size_t(0, compressed_size);
+
+    TEST_ASSERT_FALSE(pino_lz_decompress(compressed, compressed_size, NULL, 0, restored, sizeof(data) - 1));
+    TEST_ASSERT_FALSE(pino_lz_decompress(compressed, compressed_size - 1, NULL, 0, restored, sizeof(data)));
+    TEST_ASSERT_FALSE(pino_lz_decompress(NULL, compressed_size, NULL, 0, restored, sizeof(data)));
+
+    /* arbitrary damage must never read or write out of bounds */
+    for (i = 0; i < compressed_size; i++) {
+        compressed[i] ^= 0xA5;
+        pino_lz_decompress(compressed, compressed_size, NULL, 0, restored, sizeof(data));
+        compressed[i] ^= 0xA5;
+    }
+
+    TEST_ASSERT_TRUE(pino_lz_decompress(compressed, compressed_size, NULL, 0, restored, sizeof(data)));
+    TEST_ASSERT_EQUAL_MEMORY(data, restored, sizeof(data));
+}
+
+void test_serialize(void)
+{
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    uint8_t data[TEST_DATA_SIZE], unpacked[TEST_DATA_SIZE], *serialized;
+    size_t raw_size, size;
+
+    generate_compressible_data(data, sizeof(data));
+
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+    set_u32(pino, 0xCAFEBABE);
+    raw_size = pino_serialize_size(pino);
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_COMPRESS));
+    TEST_ASSERT_EQUAL_UINT32(PINO_HANDLER_FLAG_COMPRESS, pino_handler_get_flags("spl1"));
+
+    /* changing the handler flags invalidates the cached size */
+    size = pino_serialize_size(pino);
+    TEST_ASSERT_LESS_THAN_size_t(raw_size / 4, size);
+
+    serialized = (uint8_t *)malloc(size);
+    TEST_ASSERT_NOT_NULL(serialized);
+    TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+
+    TEST_ASSERT_TRUE(pino_peek(serialized, size, &info));
+    TEST_ASSERT_EQUAL_HEX8(PINO_FORMAT_FLAG_COMPRESSED, info.flags);
+    TEST_ASSERT_EQUAL_UINT64(PH_SIZE_STATIC(spl1), info.static_fields_size);
+    TEST_ASSERT_EQUAL_size_t(sizeof(data), info.raw_payload_size);
+    TEST_ASSERT_EQUAL_size_t(size - info.payload_offset, info.payload_size);
+
+    /* decoding does not depend on the handler flags */
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", 0));
+    restored = pino_unserialize(serialized, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_EQUAL_size_t(sizeof(data), pino_unpack_size(restored));
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(data, unpacked, sizeof(data));
+    TEST_ASSERT_EQUAL_HEX32(0xCAFEBABE, get_u32(restored));
+    TEST_ASSERT_EQUAL_size_t(raw_size, pino_serialize_size(restored));
+
+    pino_destroy(restored);
+    pino_destroy(pino);
+    free(serialized);
+}
+
+void test_serialize_n(void)
+{
+    pino_t *pino, *restored;
+    uint8_t data[TEST_DATA_SIZE], unpacked[TEST_DATA_SIZE], serialized[TEST_DATA_SIZE];
+    size_t written;
+
+    generate_compressible_data(data, sizeof(data));
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_COMPRESS));
+
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_FALSE(pino_serialize_n(pino, serialized, 8, &written));
+    TEST_ASSERT_EQUAL_size_t(pino_serialize_size(pino), written);
+    TEST_ASSERT_TRUE(pino_serialize_n(pino, serialized, sizeof(serialized), &written));
+    TEST_ASSERT_EQUAL_size_t(pino_serialize_size(pino), written);
+
+    restored = pino_unserialize(serialized, written);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(data, unpacked, sizeof(data));
+
+    pino_destroy(restored);
+    pino_destroy(pino);
+}
+
+void test_incompressible(void)
+{
+    pino_t *pino;
+    pino_peek_info_t info;
+    uint8_t data[TEST_DATA_SIZE], *serialized;
+    size_t size;
+
+    generate_random_data(data, sizeof(data));
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_COMPRESS));
+
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    /* stays in the raw form when compression does not help */
+    size = pino_serialize_size(pino);
+    TEST_ASSERT_EQUAL_size_t(TEST_HEADER_SIZE + PH_SIZE_STATIC(spl1) + sizeof(data), size);
+
+    serialized = (uint8_t *)malloc(size);
+    TEST_ASSERT_NOT_NULL(serialized);
+    TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+    TEST_ASSERT_TRUE(pino_peek(serialized, size, &info));
+    TEST_ASSERT_EQUAL_HEX8(0, info.flags);
+    TEST_ASSERT_EQUAL_size_t(sizeof(data), info.raw_payload_size);
+
+    pino_destroy(pino);
+    free(serialized);
+}
+
+void test_invalid(void)
+{
+    pino_t *pino;
+    pino_peek_info_t info;
+    uint8_t data[TEST_DATA_SIZE], *serialized;
+    uint64_t raw_size;
+    size_t size;
+
+    TEST_ASSERT_FALSE(pino_handler_set_flags("none", PINO_HANDLER_FLAG_COMPRESS));
+    TEST_ASSERT_FALSE(pino_handler_set_flags("spl1", 0x80000000));
+    TEST_ASSERT_EQUAL_UINT32(0, pino_handler_get_flags("none"));
+
+    generate_compressible_data(data, sizeof(data));
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_COMPRESS));
+
+    pino = pino_pack("spl1", data, sizeof(data));
+    TEST_ASSERT_NOT_NULL(pino);
+    size = pino_serialize_size(pino);
+    serialized = (uint8_t *)malloc(size);
+    TEST_ASSERT_NOT_NULL(serialized);
+    TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+
+    /* truncated compressed payload */
+    TEST_ASSERT_NULL(pino_unserialize(serialized, size - 1));
+
+    /* raw size that the codec can never produce is rejected up front */
+    raw_size = UINT64_C(1) << 40;
+    pino_endianness_memcpy_native2le(serialized + TEST_HEADER_SIZE, &raw_size, sizeof(raw_size), sizeof(raw_size));
+    TEST_ASSERT_FALSE(pino_peek(serialized, size, &info));
+    TEST_ASSERT_NULL(pino_unserialize(serialized, size));
+
+    /* mismatching raw size */
+    raw_size = sizeof(data) + 1;
+    pino_endianness_memcpy_native2le(serialized + TEST_HEADER_SIZE, &raw_size, sizeof(raw_size), sizeof(raw_size));
+    TEST_ASSERT_NULL(pino_unserialize(serialized, size));
+
+    /* unknown format flag */
+    serialized[TEST_HEADER_SIZE - 1] = 0x80;
+    TEST_ASSERT_FALSE(pino_peek(serialized, size, &info));
+    TEST_ASSERT_NULL(pino_unserialize(serialized, size));
+
+    pino_destroy(pino);
+    free(serialized);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_codec);
+    RUN_TEST(test_codec_ratio);
+    RUN_TEST(test_codec_corrupt);
+    RUN_TEST(test_serialize);
+    RUN_TEST(test_serialize_n);
+    RUN_TEST(test_incompressible);
+    RUN_TEST(test_invalid);
+
+    return UNITY_END();
+}
@@ -0,0 +1,205 @@
+/*
+ * libpino - test_delta.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <pino.h>
+#include <pino/buffer.h>
+#include <pino/delta.h>
+#include <pino/handler.h>
+
+#include "handler_spl1.h"
+#include "handler_u32a.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_DATA_SIZE 4096
+
+static uint8_t g_data[TEST_DATA_SIZE];
+
+static void serialize(const pino_t *pino, pino_buffer_t *buffer)
+{
+    pino_buffer_reset(buffer);
+    TEST_ASSERT_TRUE(pino_buffer_append(buffer, pino));
+}
+
+/* delta from reference to the current state of pino, applied back and compared */
+static size_t assert_delta_roundtrip(const pino_t *pino, const pino_buffer_t *reference)
+{
+    pino_buffer_t expected, delta, applied;
+    pino_t *restored;
+    uint8_t unpacked[TEST_DATA_SIZE * 2];
+    size_t delta_size;
+
+    TEST_ASSERT_TRUE(pino_buffer_init(&expected, 0));
+    TEST_ASSERT_TRUE(pino_buffer_init(&delta, 0));
+    TEST_ASSERT_TRUE(pino_buffer_init(&applied, 0));
+
+    serialize(pino, &expected);
+    TEST_ASSERT_TRUE(pino_serialize_delta(pino, reference->data, reference->size, &delta));
+    TEST_ASSERT_GREATER_OR_EQUAL_size_t(PINO_DELTA_MIN_HEADER_SIZE, delta.size);
+
+    TEST_ASSERT_TRUE(pino_delta_apply(reference->data, reference->size, delta.data, delta.size, &applied));
+    TEST_ASSERT_EQUAL_size_t(expected.size, applied.size);
+    TEST_ASSERT_EQUAL_MEMORY(expected.data, applied.data, expected.size);
+
+    restored = pino_unserialize_delta(reference->data, reference->size, delta.data, delta.size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_EQUAL_size_t(pino_unpack_size(pino), pino_unpack_size(restored));
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(g_data, unpacked, pino_unpack_size(pino));
+    pino_destroy(restored);
+
+    delta_size = delta.size;
+
+    pino_buffer_free(&expected);
+    pino_buffer_free(&delta);
+    pino_buffer_free(&applied);
+
+    return delta_size;
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(spl1) || !PH_REG(u32a)) {
+        TEST_FAIL();
+    }
+
+    generate_random_data(g_data, sizeof(g_data));
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(spl1) || !PH_UNREG(u32a)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_small_changes(void)
+{
+    pino_buffer_t reference;
+    pino_t *pino;
+    size_t delta_size, positions[] = {0, 1, 31, 32, 33, 1000, 1003, 2048, TEST_DATA_SIZE - 1}, i;
+
+    pino = pino_pack("spl1", g_data, sizeof(g_data));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_TRUE(pino_buffer_init(&reference, 0));
+    serialize(pino, &reference);
+
+    /* identical state is just the header */
+    TEST_ASSERT_LESS_OR_EQUAL_size_t(PINO_DELTA_MIN_HEADER_SIZE + 1, assert_delta_roundtrip(pino, &reference));
+
+    for (i = 0; i < sizeof(positions) / sizeof(positions[0]); i++) {
+        g_data[positions[i]] ^= 0x5A;
+    }
+    pino_destroy(pino);
+    pino = pino_pack("spl1", g_data, sizeof(g_data));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    delta_size = assert_delta_roundtrip(pino, &reference);
+    TEST_ASSERT_LESS_THAN_size_t(reference.size / 10, delta_size);
+
+    pino_destroy(pino);
+    pino_buffer_free(&reference);
+}
+
+void test_resize(void)
+{
+    pino_buffer_t reference;
+    pino_t *pino;
+
+    pino = pino_pack("spl1", g_data, sizeof(g_data) / 2);
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_TRUE(pino_buffer_init(&reference, 0));
+    serialize(pino, &reference);
+    pino_destroy(pino);
+
+    /* grown: the tail is new */
+    pino = pino_pack("spl1", g_data, sizeof(g_data));
+    TEST_ASSERT_NOT_NULL(pino);
+    assert_delta_roundtrip(pino, &reference);
+
+    /* shrunk below the reference */
+    serialize(pino, &reference);
+    pino_destroy(pino);
+    pino = pino_pack("spl1", g_data, 100);
+    TEST_ASSERT_NOT_NULL(pino);
+    assert_delta_roundtrip(pino, &reference);
+
+    pino_destroy(pino);
+    pino_buffer_free(&reference);
+}
+
+void test_invalid(void)
+{
+    pino_buffer_t reference, other, delta, applied;
+    pino_t *pino;
+    uint32_t words[2] = {1, 2};
+
+    pino = pino_pack("spl1", g_data, sizeof(g_data));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_TRUE(pino_buffer_init(&reference, 0));
+    TEST_ASSERT_TRUE(pino_buffer_init(&other, 0));
+    TEST_ASSERT_TRUE(pino_buffer_init(&delta, 0));
+    TEST_ASSERT_TRUE(pino_buffer_init(&applied, 0));
+    serialize(pino, &reference);
+
+    g_data[10] ^= 1;
+    pino_destroy(pino);
+    pino = pino_pack("spl1", g_data, sizeof(g_data));
+    TEST_ASSERT_NOT_NULL(pino);
+    TEST_ASSERT_TRUE(pino_serialize_delta(pino, reference.data, reference.size, &delta));
+
+    /* a different base is detected */
+    serialize(pino, &other);
+    TEST_ASSERT_FALSE(pino_delta_apply(other.data, other.size, delta.data, delta.size, &applied));
+    TEST_ASSERT_NULL(pino_unserialize_delta(other.data, other.size, delta.data, delta.size));
+    TEST_ASSERT_EQUAL_size_t(0, applied.size);
+
+    /* truncated ops */
+    TEST_ASSERT_FALSE(pino_delta_apply(reference.data, reference.size, delta.data, delta.size - 1, &applied));
+    TEST_ASSERT_FALSE(pino_delta_apply(reference.data, reference.size, delta.data, PINO_DELTA_MIN_HEADER_SIZE - 1,
+                                       &applied));
+
+    /* handler mismatch */
+    pino_destroy(pino);
+    pino = pino_pack("u32a", words, sizeof(words));
+    TEST_ASSERT_NOT_NULL(pino);
+    pino_buffer_reset(&delta);
+    TEST_ASSERT_FALSE(pino_serialize_delta(pino, reference.data, reference.size, &delta));
+    TEST_ASSERT_EQUAL_size_t(0, delta.size);
+
+    TEST_ASSERT_FALSE(pino_serialize_delta(NULL, reference.data, reference.size, &delta));
+    TEST_ASSERT_FALSE(pino_serialize_delta(pino, NULL, 0, &delta));
+    TEST_ASSERT_FALSE(pino_serialize_delta(pino, reference.data, reference.size, NULL));
+    TEST_ASSERT_FALSE(pino_delta_apply(NULL, 0, delta.data, delta.size, &applied));
+    TEST_ASSERT_NULL(pino_unserialize_delta(reference.data, reference.size, NULL, 0));
+
+    pino_destroy(pino);
+    pino_buffer_free(&reference);
+    pino_buffer_free(&other);
+    pino_buffer_free(&delta);
+    pino_buffer_free(&applied);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_small_changes);
+    RUN_TEST(test_resize);
+    RUN_TEST(test_invalid);
+
+    return UNITY_END();
+}
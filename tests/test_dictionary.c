@@ -0,0 +1,268 @@
+/*
+ * libpino - test_dictionary.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/dictionary.h>
+#include <pino/handler.h>
+
+#include "handler_spl1.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_SAMPLES         128
+#define TEST_MESSAGE_SIZE    256
+#define TEST_DICTIONARY_SIZE 4096
+#define TEST_HEADER_SIZE     (sizeof(pino_magic_t) + sizeof(pino_static_fields_size_t))
+
+static uint8_t *g_samples[TEST_SAMPLES];
+static size_t g_sample_sizes[TEST_SAMPLES];
+
+static size_t generate_message(uint8_t *out, size_t capacity, unsigned int seed)
+{
+    int length;
+
+    length = snprintf((char *)out, capacity,
+                      "{\"device\":\"sensor-%04u\",\"site\":\"tokyo-dc-%u\",\"temperature\":%u.%u,\"humidity\":%u,"
+                      "\"status\":\"nominal\",\"firmware\":\"v2.14.3\",\"uptime\":%u}",
+                      seed * 7 % 10000, seed % 4, 18 + seed % 9, seed % 10, 40 + seed % 30, seed * 131);
+    TEST_ASSERT_GREATER_THAN(0, length);
+
+    return (size_t)length;
+}
+
+static uint8_t *serialize_message(unsigned int seed, size_t *size)
+{
+    pino_t *pino;
+    uint8_t message[TEST_MESSAGE_SIZE], *serialized;
+
+    pino = pino_pack("spl1", message, generate_message(message, sizeof(message), seed));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    *size = pino_serialize_size(pino);
+    serialized = (uint8_t *)malloc(*size);
+    TEST_ASSERT_NOT_NULL(serialized);
+    TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+    pino_destroy(pino);
+
+    return serialized;
+}
+
+static size_t train(uint8_t *dictionary, size_t capacity)
+{
+    return pino_dictionary_train("spl1", (const void *const *)g_samples, g_sample_sizes, TEST_SAMPLES, dictionary,
+                                 capacity);
+}
+
+void setUp(void)
+{
+    size_t i;
+
+    if (!pino_init() || !PH_REG(spl1)) {
+        TEST_FAIL();
+    }
+
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        g_samples[i] = serialize_message((unsigned int)i, &g_sample_sizes[i]);
+    }
+}
+
+void tearDown(void)
+{
+    size_t i;
+
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        free(g_samples[i]);
+    }
+
+    if (!PH_UNREG(spl1)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_train(void)
+{
+    uint8_t dictionary[TEST_DICTIONARY_SIZE];
+    size_t size;
+
+    size = train(dictionary, sizeof(dictionary));
+    TEST_ASSERT_GREATER_THAN_size_t(0, size);
+    TEST_ASSERT_LESS_OR_EQUAL_size_t(sizeof(dictionary), size);
+
+    /* capacity is honoured */
+    TEST_ASSERT_LESS_OR_EQUAL_size_t(64, train(dictionary, 64));
+
+    /* samples of a different magic are rejected */
+    memcpy(g_samples[0], "none", sizeof(pino_magic_t));
+    TEST_ASSERT_EQUAL_size_t(0, train(dictionary, sizeof(dictionary)));
+}
+
+void test_train_deterministic(void)
+{
+    uint8_t dictionary[TEST_DICTIONARY_SIZE], relocated_dictionary[TEST_DICTIONARY_SIZE], *arena;
+    const void *relocated[TEST_SAMPLES];
+    size_t size, total, offset, i;
+
+    total = 0;
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        total += g_sample_sizes[i];
+    }
+
+    /* the same samples laid out in reverse address order train the same dictionary */
+    arena = (uint8_t *)malloc(total);
+    TEST_ASSERT_NOT_NULL(arena);
+    offset = total;
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        offset -= g_sample_sizes[i];
+        memcpy(arena + offset, g_samples[i], g_sample_sizes[i]);
+        relocated[i] = arena + offset;
+    }
+
+    size = train(dictionary, sizeof(dictionary));
+    TEST_ASSERT_GREATER_THAN_size_t(0, size);
+    TEST_ASSERT_EQUAL_size_t(size, pino_dictionary_train("spl1", relocated, g_sample_sizes, TEST_SAMPLES,
+                                                         relocated_dictionary, sizeof(relocated_dictionary)));
+    TEST_ASSERT_EQUAL_MEMORY(dictionary, relocated_dictionary, size);
+
+    free(arena);
+}
+
+void test_compress(void)
+{
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    uint8_t dictionary[TEST_DICTIONARY_SIZE], message[TEST_MESSAGE_SIZE], unpacked[TEST_MESSAGE_SIZE], *serialized;
+    const void *samples[2];
+    size_t dictionary_size, message_size, plain_size, size, sizes[2];
+
+    dictionary_size = train(dictionary, sizeof(dictionary));
+    TEST_ASSERT_GREATER_THAN_size_t(0, dictionary_size);
+
+    message_size = generate_message(message, sizeof(message), 100000);
+    pino = pino_pack("spl1", message, message_size);
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_COMPRESS));
+    plain_size = pino_serialize_size(pino);
+
+    /* registering a dictionary invalidates the cached size */
+    TEST_ASSERT_TRUE(pino_dictionary_register("spl1", 7, dictionary, dictionary_size));
+    size = pino_serialize_size(pino);
+    TEST_ASSERT_LESS_THAN_size_t(plain_size, size);
+    TEST_ASSERT_LESS_THAN_size_t((TEST_HEADER_SIZE + PH_SIZE_STATIC(spl1) + message_size) / 2, size);
+
+    serialized = (uint8_t *)malloc(size);
+    TEST_ASSERT_NOT_NULL(serialized);
+    TEST_ASSERT_TRUE(pino_serialize(pino, serialized));
+
+    TEST_ASSERT_TRUE(pino_peek(serialized, size, &info));
+    TEST_ASSERT_EQUAL_HEX8(PINO_FORMAT_FLAG_COMPRESSED | PINO_FORMAT_FLAG_DICTIONARY, info.flags);
+    TEST_ASSERT_EQUAL_UINT16(7, info.dictionary_id);
+    TEST_ASSERT_EQUAL_size_t(message_size, info.raw_payload_size);
+
+    restored = pino_unserialize(serialized, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(message, unpacked, message_size);
+    pino_destroy(restored);
+
+    /* compressed samples are decoded before training */
+    samples[0] = samples[1] = serialized;
+    sizes[0] = sizes[1] = size;
+    TEST_ASSERT_GREATER_THAN_size_t(0,
+                                    pino_dictionary_train("spl1", samples, sizes, 2, dictionary, sizeof(dictionary)));
+
+    pino_destroy(pino);
+    free(serialized);
+}
+
+void test_rotation(void)
+{
+    pino_t *pino, *restored;
+    pino_peek_info_t info;
+    uint8_t dictionary[TEST_DICTIONARY_SIZE], message[TEST_MESSAGE_SIZE], *first, *second;
+    size_t dictionary_size, first_size, second_size;
+
+    dictionary_size = train(dictionary, sizeof(dictionary));
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_COMPRESS));
+    TEST_ASSERT_TRUE(pino_dictionary_register("spl1", 1, dictionary, dictionary_size));
+
+    pino = pino_pack("spl1", message, generate_message(message, sizeof(message), 4242));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    first_size = pino_serialize_size(pino);
+    first = (uint8_t *)malloc(first_size);
+    TEST_ASSERT_NOT_NULL(first);
+    TEST_ASSERT_TRUE(pino_serialize(pino, first));
+
+    /* ids are immutable, a new id becomes the one used for encoding */
+    TEST_ASSERT_FALSE(pino_dictionary_register("spl1", 1, dictionary, dictionary_size / 2));
+    TEST_ASSERT_TRUE(pino_dictionary_register("spl1", 2, dictionary, dictionary_size / 2));
+
+    second_size = pino_serialize_size(pino);
+    second = (uint8_t *)malloc(second_size);
+    TEST_ASSERT_NOT_NULL(second);
+    TEST_ASSERT_TRUE(pino_serialize(pino, second));
+    TEST_ASSERT_TRUE(pino_peek(second, second_size, &info));
+    TEST_ASSERT_EQUAL_UINT16(2, info.dictionary_id);
+
+    /* records written with the older dictionary stay decodable */
+    restored = pino_unserialize(first, first_size);
+    TEST_ASSERT_NOT_NULL(restored);
+    pino_destroy(restored);
+    restored = pino_unserialize(second, second_size);
+    TEST_ASSERT_NOT_NULL(restored);
+    pino_destroy(restored);
+
+    /* unknown dictionary id */
+    TEST_ASSERT_TRUE(pino_peek(second, second_size, &info));
+    second[info.payload_offset - PH_SIZE_STATIC(spl1) - sizeof(uint16_t)] = 9;
+    TEST_ASSERT_NULL(pino_unserialize(second, second_size));
+
+    pino_destroy(pino);
+    free(first);
+    free(second);
+}
+
+void test_invalid(void)
+{
+    uint8_t dictionary[16] = {0};
+    const void *samples[1] = {dictionary};
+    size_t sizes[1] = {sizeof(dictionary)};
+
+    TEST_ASSERT_FALSE(pino_dictionary_register("none", 0, dictionary, sizeof(dictionary)));
+    TEST_ASSERT_FALSE(pino_dictionary_register("spl1", 0, NULL, sizeof(dictionary)));
+    TEST_ASSERT_FALSE(pino_dictionary_register("spl1", 0, dictionary, 0));
+    TEST_ASSERT_FALSE(pino_dictionary_register("spl1", 0, dictionary, PINO_DICTIONARY_MAX_SIZE + 1));
+
+    TEST_ASSERT_EQUAL_size_t(0, pino_dictionary_train("none", samples, sizes, 1, dictionary, sizeof(dictionary)));
+    TEST_ASSERT_EQUAL_size_t(0, pino_dictionary_train("spl1", NULL, sizes, 1, dictionary, sizeof(dictionary)));
+    TEST_ASSERT_EQUAL_size_t(0, pino_dictionary_train("spl1", samples, sizes, 0, dictionary, sizeof(dictionary)));
+    TEST_ASSERT_EQUAL_size_t(0, pino_dictionary_train("spl1", samples, sizes, 1, NULL, sizeof(dictionary)));
+
+    /* not a serialized record */
+    TEST_ASSERT_EQUAL_size_t(0, pino_dictionary_train("spl1", samples, sizes, 1, dictionary, sizeof(dictionary)));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_train);
+    RUN_TEST(test_train_deterministic);
+    RUN_TEST(test_compress);
+    RUN_TEST(test_rotation);
+    RUN_TEST(test_invalid);
+
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+/*
+ * libpino - test_file.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <pino.h>
+#include <pino/bundle.h>
+#include <pino/file.h>
+#include <pino/handler.h>
+
+#include "handler_spl1.h"
+#include "handler_u32a.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_BUNDLE_RECORDS 8
+
+static char g_bundle_path[PATH_MAX];
+static char g_broken_path[PATH_MAX];
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(spl1) || !PH_REG(u32a)) {
+        TEST_FAIL();
+    }
+
+    if (!get_asset_path("bundle.bin", g_bundle_path, sizeof(g_bundle_path)) ||
+        !get_asset_path("pack_broken.bin", g_broken_path, sizeof(g_broken_path))) {
+        TEST_FAIL_MESSAGE("Failed to get asset path");
+    }
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(spl1) || !PH_UNREG(u32a)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_open(void)
+{
+    pino_file_t *file;
+    uint8_t *data;
+    size_t size;
+
+    TEST_ASSERT_TRUE(load_file(g_bundle_path, &data, &size));
+
+    file = pino_file_open(g_bundle_path);
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_size_t(size, pino_file_size(file));
+    TEST_ASSERT_EQUAL_MEMORY(data, pino_file_data(file), size);
+
+    TEST_ASSERT_TRUE(pino_file_advise(file, PINO_FILE_ADVICE_SEQUENTIAL));
+    TEST_ASSERT_TRUE(pino_file_advise(file, PINO_FILE_ADVICE_RANDOM));
+    TEST_ASSERT_TRUE(pino_file_advise(file, PINO_FILE_ADVICE_WILLNEED));
+    TEST_ASSERT_TRUE(pino_file_advise(file, PINO_FILE_ADVICE_NORMAL));
+
+    pino_file_close(file);
+    free(data);
+}
+
+void test_bundle(void)
+{
+    pino_file_t *file;
+    pino_bundle_t *bundle;
+    pino_t *pino;
+    const void *record, *view;
+    uint8_t expected[64], unpacked[64];
+    uint32_t words[2];
+    size_t i, record_size;
+
+    generate_fixed_data(expected, sizeof(expected));
+
+    file = pino_file_open(g_bundle_path);
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_TRUE(pino_file_advise(file, PINO_FILE_ADVICE_RANDOM));
+
+    bundle = pino_file_bundle(file);
+    TEST_ASSERT_NOT_NULL(bundle);
+    TEST_ASSERT_EQUAL_PTR(bundle, pino_file_bundle(file));
+    TEST_ASSERT_EQUAL_size_t(TEST_BUNDLE_RECORDS, pino_bundle_count(bundle));
+
+    for (i = 0; i < TEST_BUNDLE_RECORDS; i++) {
+        TEST_ASSERT_TRUE(pino_bundle_record(bundle, i, &record, &record_size));
+
+        /* records point into the mapping */
+        TEST_ASSERT_TRUE(pino_file_view(file, (size_t)((const uint8_t *)record - (const uint8_t *)pino_file_data(file)),
+                                        record_size, &view));
+        TEST_ASSERT_EQUAL_PTR(record, view);
+
+        pino = pino_bundle_get(bundle, i);
+        TEST_ASSERT_NOT_NULL(pino);
+
+        if (i % 2) {
+            TEST_ASSERT_TRUE(pino_unpack(pino, words));
+            TEST_ASSERT_EQUAL_UINT32(i, words[0]);
+            TEST_ASSERT_EQUAL_HEX32(0xDEADBEEF, words[1]);
+        } else {
+            TEST_ASSERT_EQUAL_size_t(16 + i * 4, pino_unpack_size(pino));
+            TEST_ASSERT_TRUE(pino_unpack(pino, unpacked));
+            TEST_ASSERT_EQUAL_MEMORY(expected, unpacked, 16 + i * 4);
+            TEST_ASSERT_EQUAL_UINT32(i, get_u32(pino));
+        }
+
+        pino_destroy(pino);
+    }
+
+    pino_file_close(file);
+}
+
+void test_unserialize(void)
+{
+    pino_file_t *file;
+    pino_t *pino;
+    const void *record;
+    size_t record_size, offset;
+
+    file = pino_file_open(g_bundle_path);
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_TRUE(pino_bundle_record(pino_file_bundle(file), 1, &record, &record_size));
+
+    offset = (size_t)((const uint8_t *)record - (const uint8_t *)pino_file_data(file));
+    pino = pino_file_unserialize(file, offset, record_size);
+    TEST_ASSERT_NOT_NULL(pino);
+    TEST_ASSERT_EQUAL_size_t(sizeof(uint32_t) * 2, pino_unpack_size(pino));
+    pino_destroy(pino);
+
+    TEST_ASSERT_NULL(pino_file_unserialize(file, offset, pino_file_size(file)));
+    TEST_ASSERT_NULL(pino_file_unserialize(file, pino_file_size(file) + 1, 0));
+
+    pino_file_close(file);
+}
+
+void test_invalid(void)
+{
+    pino_file_t *file;
+
+    TEST_ASSERT_NULL(pino_file_open(NULL));
+    TEST_ASSERT_NULL(pino_file_open("/nonexistent/pino.bin"));
+    TEST_ASSERT_FALSE(pino_file_advise(NULL, PINO_FILE_ADVICE_NORMAL));
+    TEST_ASSERT_NULL(pino_file_data(NULL));
+    TEST_ASSERT_EQUAL_size_t(0, pino_file_size(NULL));
+    TEST_ASSERT_NULL(pino_file_bundle(NULL));
+    pino_file_close(NULL);
+
+    /* not a bundle, rejected lazily */
+    file = pino_file_open(g_broken_path);
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_NULL(pino_file_bundle(file));
+    TEST_ASSERT_NULL(pino_file_unserialize(file, 0, pino_file_size(file)));
+    pino_file_close(file);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_open);
+    RUN_TEST(test_bundle);
+    RUN_TEST(test_unserialize);
+    RUN_TEST(test_invalid);
+
+    return UNITY_END();
+}
@@ -0,0 +1,258 @@
+/*
+ * libpino - test_reassembler.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <string.h>
+
+#include <pino.h>
+#include <pino/reassembler.h>
+#include <pino/endianness.h>
+#include <pino/handler.h>
+
+#include "handler_spl1.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_DATA_SIZE   1024
+#define TEST_RECORDS_MAX 8
+
+static pino_t *g_received[TEST_RECORDS_MAX];
+static size_t g_received_count;
+
+static void on_record(pino_t *pino, void *userdata)
+{
+    (void)userdata;
+
+    if (g_received_count < TEST_RECORDS_MAX) {
+        g_received[g_received_count++] = pino;
+    } else {
+        pino_destroy(pino);
+    }
+}
+
+static uint8_t *make_frame(const uint8_t *data, size_t size, size_t *frame_size)
+{
+    pino_t *pino;
+    uint8_t *frame;
+    uint64_t record_size;
+
+    pino = pino_pack("spl1", data, size);
+    TEST_ASSERT_NOT_NULL(pino);
+
+    record_size = (uint64_t)pino_serialize_size(pino);
+    *frame_size = PINO_REASSEMBLER_PREFIX_SIZE + (size_t)record_size;
+    frame = (uint8_t *)malloc(*frame_size);
+    TEST_ASSERT_NOT_NULL(frame);
+
+    pino_endianness_memcpy_native2le(frame, &record_size, sizeof(record_size), sizeof(record_size));
+    TEST_ASSERT_TRUE(pino_serialize(pino, frame + PINO_REASSEMBLER_PREFIX_SIZE));
+
+    pino_destroy(pino);
+
+    return frame;
+}
+
+static void assert_received(size_t index, const uint8_t *data, size_t size)
+{
+    uint8_t *unpacked;
+
+    TEST_ASSERT_NOT_NULL(g_received[index]);
+    TEST_ASSERT_EQUAL_size_t(size, pino_unpack_size(g_received[index]));
+
+    unpacked = (uint8_t *)malloc(size);
+    TEST_ASSERT_NOT_NULL(unpacked);
+    TEST_ASSERT_TRUE(pino_unpack(g_received[index], unpacked));
+    TEST_ASSERT_EQUAL_MEMORY(data, unpacked, size);
+
+    free(unpacked);
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(spl1)) {
+        TEST_FAIL();
+    }
+
+    memset(g_received, 0, sizeof(g_received));
+    g_received_count = 0;
+}
+
+void tearDown(void)
+{
+    size_t i;
+
+    for (i = 0; i < g_received_count; i++) {
+        pino_destroy(g_received[i]);
+    }
+
+    if (!PH_UNREG(spl1)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_feed_whole(void)
+{
+    pino_reassembler_t *reassembler;
+    uint8_t data[TEST_DATA_SIZE], *frame;
+    size_t frame_size;
+
+    generate_random_data(data, sizeof(data));
+    frame = make_frame(data, sizeof(data), &frame_size);
+
+    reassembler = pino_reassembler_create(on_record, NULL, 0);
+    TEST_ASSERT_NOT_NULL(reassembler);
+
+    TEST_ASSERT_TRUE(pino_reassembler_feed(reassembler, frame, frame_size));
+    TEST_ASSERT_EQUAL_size_t(1, g_received_count);
+    TEST_ASSERT_EQUAL_size_t(0, pino_reassembler_buffered(reassembler));
+    assert_received(0, data, sizeof(data));
+
+    pino_reassembler_destroy(reassembler);
+    free(frame);
+}
+
+void test_feed_bytewise(void)
+{
+    pino_reassembler_t *reassembler;
+    uint8_t data[TEST_DATA_SIZE], *frame;
+    size_t frame_size, i;
+
+    generate_random_data(data, sizeof(data));
+    frame = make_frame(data, sizeof(data), &frame_size);
+
+    reassembler = pino_reassembler_create(on_record, NULL, 0);
+    TEST_ASSERT_NOT_NULL(reassembler);
+
+    for (i = 0; i < frame_size; i++) {
+        TEST_ASSERT_TRUE(pino_reassembler_feed(reassembler, frame + i, 1));
+        if (i + 1 < frame_size) {
+            TEST_ASSERT_EQUAL_size_t(0, g_received_count);
+            TEST_ASSERT_EQUAL_size_t(i + 1, pino_reassembler_buffered(reassembler));
+        }
+    }
+
+    TEST_ASSERT_EQUAL_size_t(1, g_received_count);
+    assert_received(0, data, sizeof(data));
+
+    pino_reassembler_destroy(reassembler);
+    free(frame);
+}
+
+void test_feed_compact(void)
+{
+    pino_reassembler_t *reassembler;
+    uint8_t data[8], *frame;
+    size_t frame_size, i;
+
+    /* the whole record is shorter than the fixed header */
+    generate_random_data(data, sizeof(data));
+    TEST_ASSERT_TRUE(pino_handler_set_flags("spl1", PINO_HANDLER_FLAG_COMPACT_HEADER));
+    frame = make_frame(data, sizeof(data), &frame_size);
+
+    reassembler = pino_reassembler_create(on_record, NULL, 0);
+    TEST_ASSERT_NOT_NULL(reassembler);
+
+    for (i = 0; i < frame_size; i++) {
+        TEST_ASSERT_TRUE(pino_reassembler_feed(reassembler, frame + i, 1));
+    }
+
+    TEST_ASSERT_EQUAL_size_t(1, g_received_count);
+    assert_received(0, data, sizeof(data));
+
+    pino_reassembler_destroy(reassembler);
+    free(frame);
+}
+
+void test_feed_multiple(void)
+{
+    pino_reassembler_t *reassembler;
+    uint8_t data1[TEST_DATA_SIZE], data2[TEST_DATA_SIZE / 2], *frame1, *frame2, *stream;
+    size_t frame1_size, frame2_size, split;
+
+    generate_random_data(data1, sizeof(data1));
+    generate_fixed_data(data2, sizeof(data2));
+    frame1 = make_frame(data1, sizeof(data1), &frame1_size);
+    frame2 = make_frame(data2, sizeof(data2), &frame2_size);
+
+    stream = (uint8_t *)malloc(frame1_size * 2 + frame2_size);
+    TEST_ASSERT_NOT_NULL(stream);
+    memcpy(stream, frame1, frame1_size);
+    memcpy(stream + frame1_size, frame2, frame2_size);
+    memcpy(stream + frame1_size + frame2_size, frame1, frame1_size);
+
+    reassembler = pino_reassembler_create(on_record, NULL, 0);
+    TEST_ASSERT_NOT_NULL(reassembler);
+
+    /* split inside the second record */
+    split = frame1_size + frame2_size / 2;
+    TEST_ASSERT_TRUE(pino_reassembler_feed(reassembler, stream, split));
+    TEST_ASSERT_EQUAL_size_t(1, g_received_count);
+    TEST_ASSERT_TRUE(pino_reassembler_feed(reassembler, stream + split, frame1_size * 2 + frame2_size - split));
+    TEST_ASSERT_EQUAL_size_t(3, g_received_count);
+
+    assert_received(0, data1, sizeof(data1));
+    assert_received(1, data2, sizeof(data2));
+    assert_received(2, data1, sizeof(data1));
+
+    pino_reassembler_destroy(reassembler);
+    free(stream);
+    free(frame1);
+    free(frame2);
+}
+
+void test_feed_invalid(void)
+{
+    pino_reassembler_t *reassembler;
+    uint8_t data[TEST_DATA_SIZE], *frame;
+    size_t frame_size;
+
+    TEST_ASSERT_NULL(pino_reassembler_create(NULL, NULL, 0));
+    TEST_ASSERT_FALSE(pino_reassembler_feed(NULL, NULL, 0));
+
+    generate_random_data(data, sizeof(data));
+    frame = make_frame(data, sizeof(data), &frame_size);
+
+    /* unknown magic is rejected as soon as the header is complete */
+    frame[PINO_REASSEMBLER_PREFIX_SIZE] = 'X';
+    reassembler = pino_reassembler_create(on_record, NULL, 0);
+    TEST_ASSERT_NOT_NULL(reassembler);
+    TEST_ASSERT_FALSE(pino_reassembler_feed(reassembler, frame, PINO_REASSEMBLER_PREFIX_SIZE + 16));
+    TEST_ASSERT_FALSE(pino_reassembler_feed(reassembler, frame, frame_size));
+    TEST_ASSERT_EQUAL_size_t(0, g_received_count);
+
+    /* recovers after reset */
+    pino_reassembler_reset(reassembler);
+    frame[PINO_REASSEMBLER_PREFIX_SIZE] = 's';
+    TEST_ASSERT_TRUE(pino_reassembler_feed(reassembler, frame, frame_size));
+    TEST_ASSERT_EQUAL_size_t(1, g_received_count);
+    pino_reassembler_destroy(reassembler);
+
+    /* oversized records */
+    reassembler = pino_reassembler_create(on_record, NULL, TEST_DATA_SIZE);
+    TEST_ASSERT_NOT_NULL(reassembler);
+    TEST_ASSERT_FALSE(pino_reassembler_feed(reassembler, frame, PINO_REASSEMBLER_PREFIX_SIZE));
+    pino_reassembler_destroy(reassembler);
+
+    pino_reassembler_destroy(NULL);
+    free(frame);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_feed_whole);
+    RUN_TEST(test_feed_bytewise);
+    RUN_TEST(test_feed_compact);
+    RUN_TEST(test_feed_multiple);
+    RUN_TEST(test_feed_invalid);
+
+    return UNITY_END();
+}
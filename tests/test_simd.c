@@ -13,10 +13,15 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <pino.h>
+#include <pino/endianness.h>
+
 #include "../src/internal/bswap.h"
 #include "unity.h"
 #include "util.h"
 
+#define TEST_KERNEL_SIZE 300
+
 #if INTPTR_MAX > INT32_MAX
 #define HAS_64BIT 1
 #else
@@ -48,6 +53,19 @@ static inline void swap_64(uint64_t *val)
 }
 #endif
 
+static inline void set_kernel_env(const char *name)
+{
+#if defined(_WIN32)
+    _putenv_s("PINO_BSWAP_KERNEL", name ? name : "");
+#else
+    if (name) {
+        setenv("PINO_BSWAP_KERNEL", name, 1);
+    } else {
+        unsetenv("PINO_BSWAP_KERNEL");
+    }
+#endif
+}
+
 void setUp(void)
 {
 }
@@ -505,6 +523,80 @@ void test_bswap_zero_size(void)
     TEST_ASSERT_EQUAL_HEX32(0, dest[3]);
 }
 
+void test_bswap_kernels(void)
+{
+    const pino_bswap_kernels_t *kernel;
+    uint8_t src[TEST_KERNEL_SIZE + 8], dest[TEST_KERNEL_SIZE + 8], expected[TEST_KERNEL_SIZE];
+    size_t elem_sizes[] = {1, 2, 3, 4, 8, 16}, sizes[] = {0, 8, 31, 32, 48, 64, 96, 200, TEST_KERNEL_SIZE};
+    size_t k, e, j, offset, size;
+    uint32_t state;
+
+    pino_crc32c_init();
+    generate_random_data(src, sizeof(src));
+
+    /* scalar is always there */
+    TEST_ASSERT_NOT_NULL(pino_bswap_kernels_find(PINO_BSWAP_KERNEL_SCALAR));
+    TEST_ASSERT_NULL(pino_bswap_kernels_find(PINO_BSWAP_KERNEL_COUNT));
+
+    /* every kernel this CPU runs gives the bytes and the crc of the scalar one, including tails and odd sizes */
+    for (k = 0; k < PINO_BSWAP_KERNEL_COUNT; k++) {
+        kernel = pino_bswap_kernels_find((pino_bswap_kernel_t)k);
+        if (!kernel) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_INT(k, kernel->kernel);
+
+        for (e = 0; e < sizeof(elem_sizes) / sizeof(elem_sizes[0]); e++) {
+            for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+                for (offset = 0; offset < 8; offset += 3) {
+                    size = sizes[j];
+                    pino_bswap_memcpy_scalar(expected, src + offset, size, elem_sizes[e]);
+
+                    memset(dest, 0, sizeof(dest));
+                    kernel->copy(dest + offset, src + offset, size, elem_sizes[e]);
+                    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, dest + offset, size,
+                                                     pino_endianness_kernel_name(kernel->kernel));
+
+                    memset(dest, 0, sizeof(dest));
+                    state = kernel->copy_crc32c(dest + offset, src + offset, size, elem_sizes[e], ~UINT32_C(0));
+                    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, dest + offset, size,
+                                                     pino_endianness_kernel_name(kernel->kernel));
+                    TEST_ASSERT_EQUAL_HEX32(pino_crc32c(0, expected, size), ~state);
+                }
+            }
+        }
+    }
+}
+
+void test_bswap_kernel_select(void)
+{
+    pino_bswap_kernel_t widest;
+
+    TEST_ASSERT_EQUAL_STRING("scalar", pino_endianness_kernel_name(PINO_BSWAP_KERNEL_SCALAR));
+    TEST_ASSERT_EQUAL_STRING("avx2", pino_endianness_kernel_name(PINO_BSWAP_KERNEL_AVX2));
+    TEST_ASSERT_NULL(pino_endianness_kernel_name(PINO_BSWAP_KERNEL_COUNT));
+
+    set_kernel_env(NULL);
+    TEST_ASSERT_TRUE(pino_init());
+    widest = pino_endianness_kernel();
+    TEST_ASSERT_NOT_NULL(pino_bswap_kernels_find(widest));
+    pino_free();
+
+    /* forced */
+    set_kernel_env("scalar");
+    TEST_ASSERT_TRUE(pino_init());
+    TEST_ASSERT_EQUAL_INT(PINO_BSWAP_KERNEL_SCALAR, pino_endianness_kernel());
+    pino_free();
+
+    /* unknown names fall back to the widest kernel */
+    set_kernel_env("mmx");
+    TEST_ASSERT_TRUE(pino_init());
+    TEST_ASSERT_EQUAL_INT(widest, pino_endianness_kernel());
+    pino_free();
+
+    set_kernel_env(NULL);
+}
+
 int main(void)
 {
     UNITY_BEGIN();
@@ -529,5 +621,8 @@ int main(void)
     RUN_TEST(test_bswap_invalid_size);
     RUN_TEST(test_bswap_zero_size);
 
+    RUN_TEST(test_bswap_kernels);
+    RUN_TEST(test_bswap_kernel_select);
+
     return UNITY_END();
 }
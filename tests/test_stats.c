@@ -0,0 +1,190 @@
+/*
+ * libpino - test_stats.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+#include <pino/stats.h>
+
+#include "handler_f64a.h"
+#include "handler_u32a.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_ROUNDS 16
+
+static pino_stats_t *find_stats(pino_stats_t *stats, size_t count, const char *magic)
+{
+    size_t i;
+
+    for (i = 0; i < count; i++) {
+        if (memcmp(stats[i].magic, magic, sizeof(pino_magic_t)) == 0) {
+            return &stats[i];
+        }
+    }
+
+    return NULL;
+}
+
+static uint64_t histogram_sum(const pino_stats_counters_t *counters)
+{
+    uint64_t sum = 0;
+    size_t i;
+
+    for (i = 0; i < PINO_STATS_BUCKETS; i++) {
+        sum += counters->histogram[i];
+    }
+
+    return sum;
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(u32a) || !PH_REG(f64a)) {
+        TEST_FAIL();
+    }
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(u32a) || !PH_UNREG(f64a)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_disabled(void)
+{
+    pino_stats_t stats[2];
+
+    if (pino_stats_enabled()) {
+        TEST_IGNORE_MESSAGE("stats are compiled in");
+    }
+
+    TEST_ASSERT_EQUAL_size_t(0, pino_stats_snapshot(stats, 2));
+    TEST_ASSERT_EQUAL_size_t(0, pino_stats_snapshot(NULL, 0));
+}
+
+void test_counters(void)
+{
+    pino_stats_t stats[2], *u32a;
+    pino_t *pino, *restored;
+    uint32_t words[2] = {0x01234567, 0x89abcdef}, unpacked[2];
+    uint8_t buffer[256];
+    size_t i, size;
+    pino_stats_op_t op;
+
+    if (!pino_stats_enabled()) {
+        TEST_IGNORE_MESSAGE("stats are compiled out");
+    }
+
+    for (i = 0; i < TEST_ROUNDS; i++) {
+        pino = pino_pack("u32a", words, sizeof(words));
+        TEST_ASSERT_NOT_NULL(pino);
+
+        size = pino_serialize_size(pino);
+        TEST_ASSERT_TRUE(size <= sizeof(buffer));
+        TEST_ASSERT_TRUE(pino_serialize(pino, buffer));
+
+        restored = pino_unserialize(buffer, size);
+        TEST_ASSERT_NOT_NULL(restored);
+        TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+        TEST_ASSERT_EQUAL_MEMORY(words, unpacked, sizeof(words));
+
+        pino_destroy(restored);
+        pino_destroy(pino);
+    }
+
+    /* u32a rejects anything but two words when the object is created */
+    TEST_ASSERT_NULL(pino_pack("u32a", words, sizeof(uint32_t)));
+
+    TEST_ASSERT_EQUAL_size_t(2, pino_stats_snapshot(stats, 2));
+    u32a = find_stats(stats, 2, "u32a");
+    TEST_ASSERT_NOT_NULL(u32a);
+
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS + 1, u32a->ops[PINO_STATS_OP_PACK].calls);
+    TEST_ASSERT_EQUAL_UINT64(1, u32a->ops[PINO_STATS_OP_PACK].failures);
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS * sizeof(words), u32a->ops[PINO_STATS_OP_PACK].bytes);
+
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS * 2 + 1, u32a->ops[PINO_STATS_OP_CREATE].calls);
+    TEST_ASSERT_EQUAL_UINT64(1, u32a->ops[PINO_STATS_OP_CREATE].failures);
+
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS, u32a->ops[PINO_STATS_OP_SERIALIZE].calls);
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS * size, u32a->ops[PINO_STATS_OP_SERIALIZE].bytes);
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS, u32a->ops[PINO_STATS_OP_UNSERIALIZE].calls);
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS * size, u32a->ops[PINO_STATS_OP_UNSERIALIZE].bytes);
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS, u32a->ops[PINO_STATS_OP_UNPACK].calls);
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS * sizeof(words), u32a->ops[PINO_STATS_OP_UNPACK].bytes);
+    TEST_ASSERT_EQUAL_UINT64(TEST_ROUNDS * 2, u32a->ops[PINO_STATS_OP_DESTROY].calls);
+
+    for (op = PINO_STATS_OP_CREATE; op < PINO_STATS_OP_COUNT; op++) {
+        TEST_ASSERT_EQUAL_UINT64(u32a->ops[op].calls, histogram_sum(&u32a->ops[op]));
+    }
+
+    /* f64a was registered but never used */
+    TEST_ASSERT_NOT_NULL(find_stats(stats, 2, "f64a"));
+    TEST_ASSERT_EQUAL_UINT64(0, find_stats(stats, 2, "f64a")->ops[PINO_STATS_OP_PACK].calls);
+}
+
+void test_capacity(void)
+{
+    pino_stats_t stats[1];
+
+    if (!pino_stats_enabled()) {
+        TEST_IGNORE_MESSAGE("stats are compiled out");
+    }
+
+    TEST_ASSERT_EQUAL_size_t(2, pino_stats_snapshot(NULL, 0));
+
+    memset(stats, 0, sizeof(stats));
+    TEST_ASSERT_EQUAL_size_t(2, pino_stats_snapshot(stats, 1));
+    TEST_ASSERT_EQUAL_STRING("u32a", stats[0].magic);
+}
+
+void test_reset_on_free(void)
+{
+    pino_stats_t stats[2];
+    pino_t *pino;
+    uint32_t words[2] = {1, 2};
+
+    if (!pino_stats_enabled()) {
+        TEST_IGNORE_MESSAGE("stats are compiled out");
+    }
+
+    pino = pino_pack("u32a", words, sizeof(words));
+    TEST_ASSERT_NOT_NULL(pino);
+    pino_destroy(pino);
+
+    TEST_ASSERT_TRUE(PH_UNREG(u32a));
+    TEST_ASSERT_TRUE(PH_UNREG(f64a));
+    pino_free();
+
+    TEST_ASSERT_TRUE(pino_init());
+    TEST_ASSERT_TRUE(PH_REG(u32a));
+    TEST_ASSERT_TRUE(PH_REG(f64a));
+
+    TEST_ASSERT_EQUAL_size_t(2, pino_stats_snapshot(stats, 2));
+    TEST_ASSERT_EQUAL_UINT64(0, find_stats(stats, 2, "u32a")->ops[PINO_STATS_OP_PACK].calls);
+    TEST_ASSERT_EQUAL_UINT64(0, find_stats(stats, 2, "u32a")->ops[PINO_STATS_OP_DESTROY].calls);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_disabled);
+    RUN_TEST(test_counters);
+    RUN_TEST(test_capacity);
+    RUN_TEST(test_reset_on_free);
+
+    return UNITY_END();
+}
@@ -0,0 +1,222 @@
+/*
+ * libpino - test_trace.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+#include <pino/trace.h>
+
+#include "handler_u32a.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_EVENTS_MAX 64
+
+typedef struct {
+    pino_trace_event_t events[TEST_EVENTS_MAX];
+    size_t count;
+} recorder_t;
+
+static recorder_t g_recorder;
+
+static void record(const pino_trace_event_t *event, void *user_data)
+{
+    recorder_t *recorder = (recorder_t *)user_data;
+
+    if (recorder->count < TEST_EVENTS_MAX) {
+        recorder->events[recorder->count] = *event;
+    }
+    recorder->count++;
+}
+
+static void assert_event(size_t index, pino_trace_op_t op, pino_trace_phase_t phase, const char *magic, size_t size,
+                         bool result)
+{
+    const pino_trace_event_t *event;
+
+    TEST_ASSERT_TRUE(index < g_recorder.count);
+    event = &g_recorder.events[index];
+
+    TEST_ASSERT_EQUAL_STRING(pino_trace_op_name(op), pino_trace_op_name(event->op));
+    TEST_ASSERT_EQUAL_INT(phase, event->phase);
+    TEST_ASSERT_EQUAL_STRING(magic, event->magic);
+    TEST_ASSERT_EQUAL_size_t(size, event->size);
+    TEST_ASSERT_EQUAL(result, event->result);
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(u32a)) {
+        TEST_FAIL();
+    }
+
+    memset(&g_recorder, 0, sizeof(g_recorder));
+    if (pino_trace_enabled()) {
+        TEST_ASSERT_TRUE(pino_trace_set_hook(record, &g_recorder));
+    }
+}
+
+void tearDown(void)
+{
+    pino_trace_set_hook(NULL, NULL);
+
+    if (!PH_UNREG(u32a)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_op_names(void)
+{
+    TEST_ASSERT_EQUAL_STRING("pack", pino_trace_op_name(PINO_TRACE_OP_PACK));
+    TEST_ASSERT_EQUAL_STRING("handler_unserialize", pino_trace_op_name(PINO_TRACE_OP_HANDLER_UNSERIALIZE));
+    TEST_ASSERT_NULL(pino_trace_op_name(PINO_TRACE_OP_COUNT));
+}
+
+void test_disabled(void)
+{
+    if (pino_trace_enabled()) {
+        TEST_IGNORE_MESSAGE("tracing is compiled in");
+    }
+
+    TEST_ASSERT_FALSE(pino_trace_set_hook(record, &g_recorder));
+}
+
+void test_pack(void)
+{
+    pino_t *pino;
+    uint32_t words[2] = {1, 2};
+
+    if (!pino_trace_enabled()) {
+        TEST_IGNORE_MESSAGE("tracing is compiled out");
+    }
+
+    pino = pino_pack("u32a", words, sizeof(words));
+    TEST_ASSERT_NOT_NULL(pino);
+
+    TEST_ASSERT_EQUAL_size_t(6, g_recorder.count);
+    assert_event(0, PINO_TRACE_OP_PACK, PINO_TRACE_PHASE_BEGIN, "u32a", sizeof(words), false);
+    assert_event(1, PINO_TRACE_OP_HANDLER_CREATE, PINO_TRACE_PHASE_BEGIN, "u32a", sizeof(words), false);
+    assert_event(2, PINO_TRACE_OP_HANDLER_CREATE, PINO_TRACE_PHASE_END, "u32a", sizeof(words), true);
+    assert_event(3, PINO_TRACE_OP_HANDLER_PACK, PINO_TRACE_PHASE_BEGIN, "u32a", sizeof(words), false);
+    assert_event(4, PINO_TRACE_OP_HANDLER_PACK, PINO_TRACE_PHASE_END, "u32a", sizeof(words), true);
+    assert_event(5, PINO_TRACE_OP_PACK, PINO_TRACE_PHASE_END, "u32a", sizeof(words), true);
+
+    g_recorder.count = 0;
+    pino_destroy(pino);
+
+    /* the end event still names the magic although the object is already freed */
+    TEST_ASSERT_EQUAL_size_t(4, g_recorder.count);
+    assert_event(0, PINO_TRACE_OP_DESTROY, PINO_TRACE_PHASE_BEGIN, "u32a", 0, false);
+    assert_event(1, PINO_TRACE_OP_HANDLER_DESTROY, PINO_TRACE_PHASE_BEGIN, "u32a", 0, false);
+    assert_event(2, PINO_TRACE_OP_HANDLER_DESTROY, PINO_TRACE_PHASE_END, "u32a", 0, true);
+    assert_event(3, PINO_TRACE_OP_DESTROY, PINO_TRACE_PHASE_END, "u32a", 0, true);
+}
+
+void test_round_trip(void)
+{
+    pino_t *pino, *restored;
+    uint32_t words[2] = {3, 4}, unpacked[2];
+    uint8_t buffer[256];
+    size_t size, i;
+    bool unserialize_end = false, unpack_end = false;
+
+    if (!pino_trace_enabled()) {
+        TEST_IGNORE_MESSAGE("tracing is compiled out");
+    }
+
+    pino = pino_pack("u32a", words, sizeof(words));
+    TEST_ASSERT_NOT_NULL(pino);
+    size = pino_serialize_size(pino);
+    TEST_ASSERT_TRUE(size <= sizeof(buffer));
+
+    g_recorder.count = 0;
+    TEST_ASSERT_TRUE(pino_serialize(pino, buffer));
+    assert_event(0, PINO_TRACE_OP_SERIALIZE, PINO_TRACE_PHASE_BEGIN, "u32a", size, false);
+    assert_event(g_recorder.count - 1, PINO_TRACE_OP_SERIALIZE, PINO_TRACE_PHASE_END, "u32a", size, true);
+    for (i = 0; i < g_recorder.count; i++) {
+        if (g_recorder.events[i].op == PINO_TRACE_OP_HANDLER_SERIALIZE) {
+            TEST_ASSERT_EQUAL_size_t(sizeof(words), g_recorder.events[i].size);
+        }
+    }
+
+    g_recorder.count = 0;
+    restored = pino_unserialize(buffer, size);
+    TEST_ASSERT_NOT_NULL(restored);
+    TEST_ASSERT_TRUE(pino_unpack(restored, unpacked));
+    TEST_ASSERT_TRUE(g_recorder.count <= TEST_EVENTS_MAX);
+
+    assert_event(0, PINO_TRACE_OP_UNSERIALIZE, PINO_TRACE_PHASE_BEGIN, "", size, false);
+    for (i = 0; i < g_recorder.count; i++) {
+        if (g_recorder.events[i].phase != PINO_TRACE_PHASE_END) {
+            continue;
+        }
+        if (g_recorder.events[i].op == PINO_TRACE_OP_UNSERIALIZE) {
+            assert_event(i, PINO_TRACE_OP_UNSERIALIZE, PINO_TRACE_PHASE_END, "u32a", size, true);
+            unserialize_end = true;
+        } else if (g_recorder.events[i].op == PINO_TRACE_OP_HANDLER_UNSERIALIZE) {
+            assert_event(i, PINO_TRACE_OP_HANDLER_UNSERIALIZE, PINO_TRACE_PHASE_END, "u32a", sizeof(words), true);
+        } else if (g_recorder.events[i].op == PINO_TRACE_OP_HANDLER_UNPACK) {
+            assert_event(i, PINO_TRACE_OP_HANDLER_UNPACK, PINO_TRACE_PHASE_END, "u32a", sizeof(words), true);
+        } else if (g_recorder.events[i].op == PINO_TRACE_OP_UNPACK) {
+            assert_event(i, PINO_TRACE_OP_UNPACK, PINO_TRACE_PHASE_END, "u32a", sizeof(words), true);
+            unpack_end = true;
+        }
+    }
+    TEST_ASSERT_TRUE(unserialize_end);
+    TEST_ASSERT_TRUE(unpack_end);
+
+    pino_destroy(restored);
+    pino_destroy(pino);
+}
+
+void test_failures(void)
+{
+    uint32_t words[2] = {5, 6};
+    uint8_t garbage[4] = {0};
+
+    if (!pino_trace_enabled()) {
+        TEST_IGNORE_MESSAGE("tracing is compiled out");
+    }
+
+    TEST_ASSERT_NULL(pino_pack("none", words, sizeof(words)));
+    TEST_ASSERT_EQUAL_size_t(2, g_recorder.count);
+    assert_event(1, PINO_TRACE_OP_PACK, PINO_TRACE_PHASE_END, "none", sizeof(words), false);
+
+    g_recorder.count = 0;
+    TEST_ASSERT_NULL(pino_unserialize(garbage, sizeof(garbage)));
+    TEST_ASSERT_EQUAL_size_t(2, g_recorder.count);
+    assert_event(1, PINO_TRACE_OP_UNSERIALIZE, PINO_TRACE_PHASE_END, "", sizeof(garbage), false);
+
+    g_recorder.count = 0;
+    TEST_ASSERT_EQUAL_size_t(0, pino_unpack_size(NULL));
+    assert_event(1, PINO_TRACE_OP_UNPACK_SIZE, PINO_TRACE_PHASE_END, "", 0, false);
+
+    /* no events once the hook is removed */
+    TEST_ASSERT_TRUE(pino_trace_set_hook(NULL, NULL));
+    g_recorder.count = 0;
+    TEST_ASSERT_NULL(pino_pack("none", words, sizeof(words)));
+    TEST_ASSERT_EQUAL_size_t(0, g_recorder.count);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_op_names);
+    RUN_TEST(test_disabled);
+    RUN_TEST(test_pack);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_failures);
+
+    return UNITY_END();
+}
@@ -0,0 +1,219 @@
+/*
+ * libpino - test_writer.c
+ *
+ * This file is part of libpino.
+ *
+ * Author: Go Kudo <zeriyoshi@gmail.com>
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <pino.h>
+#include <pino/handler.h>
+#include <pino/writer.h>
+
+#include "handler_spl1.h"
+#include "unity.h"
+#include "util.h"
+
+#define TEST_BUFFER_SIZE 4096
+#define TEST_RECORDS     500
+#define TEST_LARGE_SIZE  (TEST_BUFFER_SIZE * 3)
+
+static uint8_t g_data[TEST_LARGE_SIZE];
+
+static size_t record_data_size(size_t i)
+{
+    /* every 97th record is larger than a whole buffer */
+    return i % 97 == 0 ? TEST_LARGE_SIZE : (i * 13) % 200 + 1;
+}
+
+static uint8_t *read_stream(FILE *fp, size_t *size)
+{
+    uint8_t *data;
+    long end;
+
+    TEST_ASSERT_EQUAL_INT(0, fseek(fp, 0, SEEK_END));
+    end = ftell(fp);
+    TEST_ASSERT_GREATER_THAN(0, end);
+    rewind(fp);
+
+    data = (uint8_t *)malloc((size_t)end);
+    TEST_ASSERT_NOT_NULL(data);
+    TEST_ASSERT_EQUAL_size_t((size_t)end, fread(data, 1, (size_t)end, fp));
+
+    *size = (size_t)end;
+
+    return data;
+}
+
+static void assert_stream(const uint8_t *data, size_t size, size_t count)
+{
+    pino_peek_info_t info;
+    pino_t *pino;
+    uint8_t unpacked[TEST_LARGE_SIZE];
+    size_t offset = 0, record_size, i;
+
+    for (i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE(pino_peek(data + offset, size - offset, &info));
+        /* records are not self-delimiting, the spl1 payload is the packed data */
+        record_size = info.payload_offset + record_data_size(i);
+
+        pino = pino_unserialize(data + offset, record_size);
+        TEST_ASSERT_NOT_NULL(pino);
+        TEST_ASSERT_EQUAL_size_t(record_data_size(i), pino_unpack_size(pino));
+        TEST_ASSERT_TRUE(pino_unpack(pino, unpacked));
+        TEST_ASSERT_EQUAL_MEMORY(g_data, unpacked, record_data_size(i));
+        TEST_ASSERT_EQUAL_UINT32(i, get_u32(pino));
+        pino_destroy(pino);
+
+        offset += record_size;
+    }
+
+    TEST_ASSERT_EQUAL_size_t(size, offset);
+}
+
+static void write_records(pino_writer_backend_t backend)
+{
+    pino_writer_options_t options = {TEST_BUFFER_SIZE, backend, PINO_WRITER_SYNC_DATA};
+    pino_writer_t *writer;
+    pino_t *pino;
+    FILE *fp;
+    uint8_t *data;
+    size_t size, i;
+
+    fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    writer = pino_writer_create(fileno(fp), &options);
+    if (!writer) {
+        fclose(fp);
+        TEST_IGNORE_MESSAGE("backend not available");
+    }
+    if (backend != PINO_WRITER_BACKEND_AUTO) {
+        TEST_ASSERT_EQUAL_INT(backend, pino_writer_backend(writer));
+    }
+
+    for (i = 0; i < TEST_RECORDS; i++) {
+        pino = pino_pack("spl1", g_data, record_data_size(i));
+        TEST_ASSERT_NOT_NULL(pino);
+        set_u32(pino, (uint32_t)i);
+
+        /* alternate between serializing in place and copying serialized bytes */
+        if (i % 2) {
+            TEST_ASSERT_TRUE(pino_writer_add(writer, pino));
+        } else {
+            size = pino_serialize_size(pino);
+            data = (uint8_t *)malloc(size);
+            TEST_ASSERT_NOT_NULL(data);
+            TEST_ASSERT_TRUE(pino_serialize(pino, data));
+            TEST_ASSERT_TRUE(pino_writer_add_raw(writer, data, size));
+            free(data);
+        }
+        pino_destroy(pino);
+
+        if (i == TEST_RECORDS / 2) {
+            TEST_ASSERT_TRUE(pino_writer_flush(writer));
+        }
+    }
+
+    TEST_ASSERT_TRUE(pino_writer_close(writer));
+
+    data = read_stream(fp, &size);
+    fclose(fp);
+    assert_stream(data, size, TEST_RECORDS);
+    free(data);
+}
+
+void setUp(void)
+{
+    if (!pino_init() || !PH_REG(spl1)) {
+        TEST_FAIL();
+    }
+
+    generate_fixed_data(g_data, sizeof(g_data));
+}
+
+void tearDown(void)
+{
+    if (!PH_UNREG(spl1)) {
+        TEST_FAIL();
+    }
+
+    pino_free();
+}
+
+void test_auto(void)
+{
+    write_records(PINO_WRITER_BACKEND_AUTO);
+}
+
+void test_io_uring(void)
+{
+    write_records(PINO_WRITER_BACKEND_IO_URING);
+}
+
+void test_thread(void)
+{
+    write_records(PINO_WRITER_BACKEND_THREAD);
+}
+
+void test_sync(void)
+{
+    write_records(PINO_WRITER_BACKEND_SYNC);
+}
+
+void test_offset(void)
+{
+    pino_writer_t *writer;
+    FILE *fp;
+    uint8_t prefix[7] = {0}, *data;
+    size_t size;
+
+    fp = tmpfile();
+    TEST_ASSERT_NOT_NULL(fp);
+
+    /* writing starts at the current file position */
+    TEST_ASSERT_EQUAL_size_t(sizeof(prefix), fwrite(prefix, 1, sizeof(prefix), fp));
+    TEST_ASSERT_EQUAL_INT(0, fflush(fp));
+
+    writer = pino_writer_create(fileno(fp), NULL);
+    TEST_ASSERT_NOT_NULL(writer);
+    TEST_ASSERT_EQUAL_UINT64(sizeof(prefix), pino_writer_offset(writer));
+    TEST_ASSERT_TRUE(pino_writer_add_raw(writer, g_data, 100));
+    TEST_ASSERT_TRUE(pino_writer_add_raw(writer, NULL, 0));
+    TEST_ASSERT_EQUAL_UINT64(sizeof(prefix) + 100, pino_writer_offset(writer));
+    TEST_ASSERT_TRUE(pino_writer_close(writer));
+
+    data = read_stream(fp, &size);
+    fclose(fp);
+    TEST_ASSERT_EQUAL_size_t(sizeof(prefix) + 100, size);
+    TEST_ASSERT_EQUAL_MEMORY(g_data, data + sizeof(prefix), 100);
+    free(data);
+}
+
+void test_invalid(void)
+{
+    TEST_ASSERT_NULL(pino_writer_create(-1, NULL));
+    TEST_ASSERT_FALSE(pino_writer_add(NULL, NULL));
+    TEST_ASSERT_FALSE(pino_writer_add_raw(NULL, g_data, 1));
+    TEST_ASSERT_FALSE(pino_writer_flush(NULL));
+    TEST_ASSERT_FALSE(pino_writer_close(NULL));
+    TEST_ASSERT_EQUAL_UINT64(0, pino_writer_offset(NULL));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_auto);
+    RUN_TEST(test_io_uring);
+    RUN_TEST(test_thread);
+    RUN_TEST(test_sync);
+    RUN_TEST(test_offset);
+    RUN_TEST(test_invalid);
+
+    return UNITY_END();
+}
@@ -15,6 +15,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #if defined(__linux__)
@@ -146,6 +147,27 @@ static inline void generate_fixed_data(uint8_t *out, size_t size)
     }
 }
 
+static inline void generate_compressible_data(uint8_t *out, size_t size)
+{
+    size_t i;
+    char record[64];
+    int length;
+
+    /* telemetry-like text records with slowly changing values */
+    for (i = 0; i < size;) {
+        length = snprintf(record, sizeof(record), "sensor=%02u temp=%u.%u status=ok;", (unsigned int)(i / 64 % 16),
+                          (unsigned int)(20 + i / 512 % 5), (unsigned int)(i / 128 % 10));
+        if (length <= 0) {
+            break;
+        }
+        if ((size_t)length > size - i) {
+            length = (int)(size - i);
+        }
+        memcpy(out + i, record, (size_t)length);
+        i += (size_t)length;
+    }
+}
+
 static inline void generate_random_data(uint8_t *out, size_t size)
 {
     size_t i;